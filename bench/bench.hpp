@@ -0,0 +1,193 @@
+#if !defined(ACHILLES_BENCH_HPP)
+#define ACHILLES_BENCH_HPP
+
+// a small benchmark harness so the suite builds with nothing but a compiler. cases register themselves with
+// 'BENCH' and time their loop with 'State::loop', see main.cpp for the runner and its output
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <thread>
+#include "utils/types.hpp"
+#include "utils/assert.hpp"
+#include "utils/misc.hpp"
+
+// every file of the suite uses the headers, so the handler they need is defined here
+inline bool aassert_handler(const char *file, int line, const char *conditionCode, const char *message) {
+    fprintf(stderr, "(%s, %i) assertion '%s' failed: %s\n", file, line, conditionCode, message);
+    return true;
+}
+
+namespace achilles {
+    namespace bench {
+        inline u64 nanoseconds() {
+            return (u64) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // keeps the compiler from dropping a result nothing reads
+        template<typename T>
+        inline void keep(T const &value) {
+            #if defined(__GNUC__) || defined(__clang__)
+                asm volatile("" : : "r,m"(value) : "memory");
+            #else
+                static volatile T const *_sink;
+                _sink = &value;
+            #endif
+        }
+
+        // makes the compiler assume the memory 'value' points to was changed, so loads aren't hoisted out
+        template<typename T>
+        inline void clobber(T *value) {
+            #if defined(__GNUC__) || defined(__clang__)
+                asm volatile("" : : "g"(value) : "memory");
+            #else
+                keep(value);
+            #endif
+        }
+
+        // a named number a case reports next to its timing, like an error bound or a thread count
+        struct Counter {
+            char const *name;
+            f64 value;
+        };
+
+        struct State {
+            static constexpr u32 MAX_COUNTERS = 8;
+
+            // the argument the case was registered with, zero when it has none
+            u64 argument = 0;
+            u64 iterations = 1;
+
+            // what one iteration processes, for the throughput columns
+            u64 bytes = 0;
+            u64 items = 0;
+
+            Counter counters[MAX_COUNTERS] {};
+            u32 counterCount = 0;
+
+            // set by 'fail', the run exits with an error once every case ran
+            char const *failure = nullptr;
+
+            // 'while (state.loop()) { ... }' runs the body 'iterations' times, the clock starts at the first call
+            // so whatever comes before it is setup
+            bool loop() {
+                if (_remaining == iterations) _begin = nanoseconds();
+                if (_remaining == 0) {
+                    _end = nanoseconds();
+                    return false;
+                }
+                --_remaining;
+                return true;
+            }
+
+            void counter(char const *name, f64 value) {
+                for (u32 i = 0; i < counterCount; ++i) {
+                    if (counters[i].name == name) {
+                        counters[i].value = value;
+                        return;
+                    }
+                }
+                if (counterCount < MAX_COUNTERS) counters[counterCount++] = Counter { name, value };
+            }
+
+            void fail(char const *message) {
+                if (failure == nullptr) failure = message;
+            }
+
+            u64 elapsed() const {
+                return _end - _begin;
+            }
+
+            void reset(u64 count) {
+                iterations = count;
+                _remaining = count;
+                _begin = 0;
+                _end = 0;
+            }
+        private:
+            u64 _remaining = 1;
+            u64 _begin = 0;
+            u64 _end = 0;
+        };
+
+        using Function = void (*)(State &state);
+
+        // one registered case, a case with several arguments is registered once per argument
+        struct Case {
+            char const *name;
+            Function function;
+            u64 argument;
+            bool hasArgument;
+            Case *next;
+        };
+
+        struct Registry {
+            Case *first = nullptr;
+            Case *last = nullptr;
+        };
+
+        inline Registry &registry() {
+            static Registry _registry {};
+            return _registry;
+        }
+
+        // given to 'Registrar' instead of arguments to run a case on 1, 2, 4 and so on threads up to the hardware's
+        // count, and on that count itself when it isn't a power of two
+        struct ThreadRange {};
+
+        // cases run in the order they were registered, which within a file is the order they are written in
+        struct Registrar {
+            static constexpr u32 MAX_ARGUMENTS = 8;
+
+            Registrar(char const *name, Function function, std::initializer_list<u64> arguments) {
+                if (arguments.size() == 0) {
+                    _cases[0] = Case { name, function, 0, false, nullptr };
+                    link(&_cases[0]);
+                    return;
+                }
+                u32 count = 0;
+                for (u64 argument : arguments) {
+                    if (count == MAX_ARGUMENTS) break;
+                    _cases[count] = Case { name, function, argument, true, nullptr };
+                    link(&_cases[count++]);
+                }
+            }
+
+            Registrar(char const *name, Function function, ThreadRange) {
+                u64 hardware = std::thread::hardware_concurrency();
+                if (hardware == 0) hardware = 1;
+                u32 count = 0;
+                for (u64 threads = 1; threads < hardware && count < MAX_ARGUMENTS - 1; threads *= 2) {
+                    _cases[count] = Case { name, function, threads, true, nullptr };
+                    link(&_cases[count++]);
+                }
+                _cases[count] = Case { name, function, hardware, true, nullptr };
+                link(&_cases[count]);
+            }
+        private:
+            static void link(Case *entry) {
+                Registry &cases = registry();
+                if (cases.last) cases.last->next = entry;
+                else cases.first = entry;
+                cases.last = entry;
+            }
+
+            Case _cases[MAX_ARGUMENTS] {};
+        };
+    }
+}
+
+// BENCH(memory_array_push, 1000, 100000) { ... } registers 'memory_array_push/1000' and '.../100000', the body
+// reads its argument from 'state.argument'
+#define BENCH(name, ...) \
+    static void name(achilles::bench::State &state); \
+    static achilles::bench::Registrar macro_concat2(BENCH_REGISTRAR_, name) { #name, name, { __VA_ARGS__ } }; \
+    static void name(achilles::bench::State &state)
+
+// BENCH_THREADS(pool_contended) { ... } registers 'pool_contended/1', '.../2' and so on, 'state.argument' is the
+// number of threads to run on, see 'ThreadRange'
+#define BENCH_THREADS(name) \
+    static void name(achilles::bench::State &state); \
+    static achilles::bench::Registrar macro_concat2(BENCH_REGISTRAR_, name) { #name, name, achilles::bench::ThreadRange {} }; \
+    static void name(achilles::bench::State &state)
+
+#endif
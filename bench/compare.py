@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+# puts two runs of 'achilles_bench --json' side by side, e.g. of the commit before a change and of the change:
+#
+#     python3 bench/compare.py before.json after.json [--threshold 5]
+#
+# the change is in median time, negative is faster. cases that moved by more than '--threshold' percent are
+# marked, cases that exist in only one of the runs are listed as added or removed
+import argparse
+import json
+
+
+def load(path):
+    with open(path) as file:
+        run = json.load(file)
+    return run.get("context", {}), {case["name"]: case for case in run["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare two achilles_bench json files")
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent change that gets marked")
+    args = parser.parse_args()
+
+    before_context, before = load(args.before)
+    after_context, after = load(args.after)
+    for name, context in (("before", before_context), ("after", after_context)):
+        print(f"{name}: {context.get('label') or '-'} ({context.get('compiler', '?')}, {context.get('build', '?')}, {context.get('lanes', '?')} lanes)")
+    print(f"{'case':<44} {'before ns':>14} {'after ns':>14} {'change':>9}")
+
+    for name, old in before.items():
+        new = after.get(name)
+        if new is None:
+            print(f"{name:<44} {old['ns']:>14.2f} {'removed':>14}")
+            continue
+        if "failure" in old or "failure" in new:
+            print(f"{name:<44} {'failed' if 'failure' in old else old['ns']:>14} {'failed' if 'failure' in new else new['ns']:>14}")
+            continue
+        change = (new["ns"] - old["ns"]) / old["ns"] * 100 if old["ns"] > 0 else 0.0
+        mark = " <" if change <= -args.threshold else " >" if change >= args.threshold else ""
+        print(f"{name:<44} {old['ns']:>14.2f} {new['ns']:>14.2f} {change:>+8.1f}%{mark}")
+    for name, new in after.items():
+        if name not in before:
+            print(f"{name:<44} {'added':>14} {new['ns']:>14.2f}")
+
+
+if __name__ == "__main__":
+    main()
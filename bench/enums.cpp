@@ -0,0 +1,53 @@
+// 'fromString' against the chain of 'strcmp's it replaces, over every name of an enum and a miss
+#include <cstring>
+#include "bench.hpp"
+#include "utils/enums.hpp"
+
+using namespace achilles;
+
+ENUM(Opcode, Add, Sub, Mul, Div, Mod, And, Or, Xor, ShiftLeft, ShiftRight, Not, Negate, Load, Store, Jump, JumpIf,
+    Call, Return, Push, Pop, Compare, Move, Nop, Halt);
+
+namespace {
+    char const *const INPUTS[] = {
+        "Add", "Sub", "Mul", "Div", "Mod", "And", "Or", "Xor", "ShiftLeft", "ShiftRight", "Not", "Negate", "Load",
+        "Store", "Jump", "JumpIf", "Call", "Return", "Push", "Pop", "Compare", "Move", "Nop", "Halt", "Unknown",
+    };
+    constexpr u64 INPUT_COUNT = sizeof(INPUTS) / sizeof(INPUTS[0]);
+
+    bool parseLinear(char const *string, Opcode &outValue) {
+        for (auto value : Opcode::values()) {
+            if (strcmp(Opcode(value).toString(), string) == 0) {
+                outValue = value;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+BENCH(enums_from_string) {
+    state.items = INPUT_COUNT;
+    while (state.loop()) {
+        for (u64 i = 0; i < INPUT_COUNT; ++i) {
+            char const *input = INPUTS[i];
+            bench::clobber(input);
+            Opcode value = Opcode::Nop;
+            bench::keep(Opcode::fromString(input, value));
+            bench::keep(value);
+        }
+    }
+}
+
+BENCH(enums_from_string_linear) {
+    state.items = INPUT_COUNT;
+    while (state.loop()) {
+        for (u64 i = 0; i < INPUT_COUNT; ++i) {
+            char const *input = INPUTS[i];
+            bench::clobber(input);
+            Opcode value = Opcode::Nop;
+            bench::keep(parseLinear(input, value));
+            bench::keep(value);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+// 'readFile' and 'mapFile' throughput over a range of file sizes. the files are written to the temporary
+// directory first, so the numbers are for the page cache rather than for the disk
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include "bench.hpp"
+#include "utils/memory.hpp"
+#include "utils/files.hpp"
+
+using namespace achilles;
+
+namespace {
+    // removes the file again when the case is done
+    struct TemporaryFile {
+        std::string path;
+
+        explicit TemporaryFile(u64 size) {
+            path = (std::filesystem::temp_directory_path() / ("achilles_bench_" + std::to_string(size) + ".bin")).string();
+            memory::Block contents { memory::GlobalAllocator::instance().allocate(size), size, memory::GlobalAllocator::instance() };
+            for (u64 i = 0; i < size; ++i) ((u8 *) contents)[i] = (u8) (i * 31);
+            if (!files::writeToFile(path.c_str(), contents)) path.clear();
+        }
+
+        ~TemporaryFile() {
+            if (!path.empty()) std::remove(path.c_str());
+        }
+    };
+
+    void read(bench::State &state, files::FileMode mode) {
+        TemporaryFile file { state.argument };
+        if (file.path.empty()) {
+            state.fail("couldn't write the file to read");
+            return;
+        }
+        state.bytes = state.argument;
+        while (state.loop()) {
+            memory::Block block = files::readFile(file.path.c_str(), memory::GlobalAllocator::instance(), mode);
+            if (block.size() != state.argument) {
+                state.fail("read a different size than was written");
+                return;
+            }
+            bench::keep(((u8 *) block)[state.argument - 1]);
+        }
+    }
+}
+
+BENCH(files_read, KB(4), KB(64), MB(1), MB(16)) {
+    read(state, files::FILE_BINARY);
+}
+
+BENCH(files_read_direct, MB(1), MB(16)) {
+    read(state, files::FILE_DIRECT);
+}
+
+// maps the file and touches a byte of every page, the cost of bringing the pages in without reading them
+BENCH(files_map, KB(4), KB(64), MB(1), MB(16)) {
+    TemporaryFile file { state.argument };
+    if (file.path.empty()) {
+        state.fail("couldn't write the file to map");
+        return;
+    }
+    state.bytes = state.argument;
+    while (state.loop()) {
+        memory::Block mapping = files::mapFile(file.path.c_str(), files::MAP_READ_ONLY, files::ACCESS_SEQUENTIAL);
+        if (mapping.size() != state.argument) {
+            state.fail("mapped a different size than was written");
+            return;
+        }
+        u8 const *bytes = (u8 const *) mapping;
+        u64 sum = 0;
+        for (u64 i = 0; i < state.argument; i += KB(4)) sum += bytes[i];
+        bench::keep(sum);
+    }
+}
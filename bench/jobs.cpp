@@ -0,0 +1,55 @@
+// how 'parallelFor' scales with the number of workers, and what a job costs to submit and run. the systems are
+// made before the timed loop, so thread start up isn't part of the numbers. on a machine with fewer hardware
+// threads than a case asks for the workers just share them
+#include <cmath>
+#include "bench.hpp"
+#include "utils/memory.hpp"
+#include "utils/jobs.hpp"
+
+using namespace achilles;
+
+namespace {
+    constexpr u64 ELEMENTS = 1 << 20;
+    constexpr u64 GRAIN = 4096;
+}
+
+BENCH(jobs_parallel_for, 1, 2, 4, 8) {
+    jobs::JobSystem system { (u32) state.argument };
+    memory::Array<f32> values { memory::GlobalAllocator::instance(), ELEMENTS };
+    for (u64 i = 0; i < ELEMENTS; ++i) values.push((f32) i);
+    state.items = ELEMENTS;
+    state.counter("workers", (f64) system.workerCount());
+    while (state.loop()) {
+        jobs::parallelFor(system, values.slice(), GRAIN, [](memory::Slice<f32> slice) {
+            f32 *items = (f32 *) slice;
+            for (u64 i = 0; i < slice.size(); ++i) items[i] = std::sqrt(items[i] + 1.0f);
+        });
+    }
+    bench::keep(values[ELEMENTS - 1]);
+}
+
+// the elements are one per job, so this is the overhead of splitting, submitting and stealing
+BENCH(jobs_parallel_for_fine, 1, 2, 4, 8) {
+    jobs::JobSystem system { (u32) state.argument };
+    memory::Array<u64> values { memory::GlobalAllocator::instance(), 4096 };
+    for (u64 i = 0; i < 4096; ++i) values.push(i);
+    state.items = 4096;
+    while (state.loop()) {
+        jobs::parallelFor(system, values.slice(), 1, [](u64 &value) { value += 1; });
+    }
+    bench::keep(values[0]);
+}
+
+BENCH(jobs_submit_wait, 1, 4) {
+    jobs::JobSystem system { (u32) state.argument };
+    std::atomic<u64> done {0};
+    state.items = 1024;
+    while (state.loop()) {
+        jobs::Counter counter;
+        for (u32 i = 0; i < 1024; ++i) {
+            system.submit([&done] { done.fetch_add(1, std::memory_order_relaxed); }, counter);
+        }
+        system.wait(counter);
+    }
+    bench::keep(done.load());
+}
@@ -0,0 +1,188 @@
+// runs every registered case and prints a table, '--json' also writes the results in a form 'compare.py' reads,
+// so runs of two commits can be put side by side:
+//
+//     achilles_bench --json before.json
+//     achilles_bench --json after.json
+//     python3 bench/compare.py before.json after.json
+//
+// every case is calibrated to run for at least '--min-time' milliseconds, then timed '--repetitions' times,
+// the median of those is what gets reported and compared
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include "bench.hpp"
+#include "utils/memory.hpp"
+#include "utils/math.hpp"
+
+#if !defined(ACHILLES_BENCH_BUILD_TYPE)
+    #define ACHILLES_BENCH_BUILD_TYPE "unknown"
+#endif
+
+using namespace achilles;
+
+namespace {
+    struct Options {
+        char const *filter = nullptr;
+        char const *json = nullptr;
+        char const *label = "";
+        f64 minTime = 50.0;
+        u32 repetitions = 5;
+        bool list = false;
+    };
+
+    struct Result {
+        char name[96];
+        u64 iterations;
+        f64 median;
+        f64 minimum;
+        f64 maximum;
+        u64 bytes;
+        u64 items;
+        bench::Counter counters[bench::State::MAX_COUNTERS];
+        u32 counterCount;
+        char const *failure;
+    };
+
+    bool parse(int argc, char **argv, Options &options) {
+        for (int i = 1; i < argc; ++i) {
+            char const *arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (strcmp(arg, "--filter") == 0 && hasValue) options.filter = argv[++i];
+            else if (strcmp(arg, "--json") == 0 && hasValue) options.json = argv[++i];
+            else if (strcmp(arg, "--label") == 0 && hasValue) options.label = argv[++i];
+            else if (strcmp(arg, "--min-time") == 0 && hasValue) options.minTime = atof(argv[++i]);
+            else if (strcmp(arg, "--repetitions") == 0 && hasValue) options.repetitions = (u32) atoi(argv[++i]);
+            else if (strcmp(arg, "--quick") == 0) {
+                // a smoke run, every case once for about a millisecond
+                options.minTime = 1.0;
+                options.repetitions = 1;
+            } else if (strcmp(arg, "--list") == 0) options.list = true;
+            else {
+                fprintf(stderr, "usage: %s [--filter text] [--json path] [--label text] [--min-time ms] [--repetitions n] [--quick] [--list]\n", argv[0]);
+                return false;
+            }
+        }
+        if (options.repetitions == 0) options.repetitions = 1;
+        return true;
+    }
+
+    // times one case, 'failure' is set when it failed
+    void run(bench::Case const &entry, Options const &options, Result &result) {
+        bench::State state;
+        state.argument = entry.argument;
+
+        // grow the iteration count until one run takes 'minTime', aiming a bit past it
+        u64 iterations = 1;
+        u64 target = (u64) (options.minTime * 1e6);
+        for (;;) {
+            state.reset(iterations);
+            entry.function(state);
+            if (state.failure) break;
+            u64 elapsed = state.elapsed();
+            if (elapsed >= target || iterations >= U64_MAX / 100) break;
+            u64 scale = elapsed > 0 ? (u64) ((f64) target * 1.2 / (f64) elapsed) + 1 : 100;
+            iterations *= scale < 2 ? 2 : scale > 100 ? 100 : scale;
+        }
+
+        f64 samples[64];
+        u32 count = options.repetitions < 64 ? options.repetitions : 64;
+        for (u32 i = 0; i < count && !state.failure; ++i) {
+            state.reset(iterations);
+            entry.function(state);
+            samples[i] = (f64) state.elapsed() / (f64) iterations;
+        }
+        if (state.failure) count = 0;
+
+        // insertion sort, there are only a handful
+        for (u32 i = 1; i < count; ++i) {
+            f64 sample = samples[i];
+            u32 j = i;
+            for (; j > 0 && samples[j - 1] > sample; --j) samples[j] = samples[j - 1];
+            samples[j] = sample;
+        }
+
+        result.iterations = iterations;
+        result.median = count == 0 ? 0.0 : count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+        result.minimum = count == 0 ? 0.0 : samples[0];
+        result.maximum = count == 0 ? 0.0 : samples[count - 1];
+        result.bytes = state.bytes;
+        result.items = state.items;
+        result.counterCount = state.counterCount;
+        memcpy(result.counters, state.counters, sizeof(state.counters));
+        result.failure = state.failure;
+    }
+
+    void print(Result const &result) {
+        if (result.failure) {
+            printf("%-44s FAILED: %s\n", result.name, result.failure);
+            return;
+        }
+        printf("%-44s %14.2f ns", result.name, result.median);
+        if (result.bytes > 0) printf(" %10.3f GB/s", (f64) result.bytes / result.median);
+        if (result.items > 0) printf(" %10.3f M/s", (f64) result.items * 1e3 / result.median);
+        for (u32 i = 0; i < result.counterCount; ++i) {
+            printf(" %s=%g", result.counters[i].name, result.counters[i].value);
+        }
+        printf("\n");
+    }
+
+    bool writeJson(char const *path, Options const &options, memory::Array<Result> const &results) {
+        FILE *file = fopen(path, "w");
+        if (file == nullptr) return false;
+        fprintf(file, "{\n  \"context\": {\"label\": \"%s\", \"time\": %lld, \"compiler\": \"%s\", \"build\": \"%s\", \"lanes\": %u, \"threads\": %u, \"min_time_ms\": %g, \"repetitions\": %u},\n",
+            options.label, (long long) time(nullptr),
+            #if defined(__VERSION__)
+                __VERSION__,
+            #else
+                "unknown",
+            #endif
+            ACHILLES_BENCH_BUILD_TYPE, (u32) math::wide::LANES, std::thread::hardware_concurrency(), options.minTime, options.repetitions);
+        fprintf(file, "  \"benchmarks\": [");
+        for (u64 i = 0; i < results.size(); ++i) {
+            Result const &result = results[i];
+            fprintf(file, "%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns\": %.4f, \"min_ns\": %.4f, \"max_ns\": %.4f",
+                i == 0 ? "" : ",", result.name, (unsigned long long) result.iterations, result.median, result.minimum, result.maximum);
+            if (result.bytes > 0) fprintf(file, ", \"bytes_per_second\": %.6g", (f64) result.bytes * 1e9 / result.median);
+            if (result.items > 0) fprintf(file, ", \"items_per_second\": %.6g", (f64) result.items * 1e9 / result.median);
+            for (u32 j = 0; j < result.counterCount; ++j) {
+                fprintf(file, ", \"%s\": %.9g", result.counters[j].name, result.counters[j].value);
+            }
+            if (result.failure) fprintf(file, ", \"failure\": \"%s\"", result.failure);
+            fprintf(file, "}");
+        }
+        fprintf(file, "\n  ]\n}\n");
+        return fclose(file) == 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse(argc, argv, options)) return 2;
+
+    memory::Array<Result> results { memory::GlobalAllocator::instance(), 64 };
+    bool failed = false;
+    for (bench::Case *entry = bench::registry().first; entry; entry = entry->next) {
+        Result result {};
+        if (entry->hasArgument) snprintf(result.name, sizeof(result.name), "%s/%llu", entry->name, (unsigned long long) entry->argument);
+        else snprintf(result.name, sizeof(result.name), "%s", entry->name);
+        if (options.filter && strstr(result.name, options.filter) == nullptr) continue;
+        if (options.list) {
+            printf("%s\n", result.name);
+            continue;
+        }
+
+        run(*entry, options, result);
+        print(result);
+        fflush(stdout);
+        failed = failed || result.failure != nullptr;
+        results.push(result);
+    }
+
+    if (options.json && !options.list && !writeJson(options.json, options, results)) {
+        fprintf(stderr, "failed to write '%s'\n", options.json);
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
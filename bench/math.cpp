@@ -0,0 +1,562 @@
+// the math hot paths, one value at a time and in batches. the cases for the precision policies also check
+// them: the largest error over a sweep of inputs is reported as 'max_error' and has to stay within the bound
+// 'math.hpp' documents, and the batch results have to match the same policy one value at a time bit for bit
+// ('mismatches'). builds that contract into FMAs ('-mfma', '-march=native') round the two paths differently,
+// there the mismatches are only reported. the SIMD code of 'float4' and 'quaternion' is held against the scalar
+// code the same way, on inputs run through the scalar code in constant evaluation
+#include <cmath>
+#include <cstring>
+#include "bench.hpp"
+#include "utils/memory.hpp"
+#include "utils/math.hpp"
+
+using namespace achilles;
+using namespace achilles::math;
+
+namespace {
+    constexpr u64 SWEEP = 1 << 16;
+
+    #if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+        constexpr bool CONTRACTED = true;
+    #else
+        constexpr bool CONTRACTED = false;
+    #endif
+
+    struct Random {
+        u64 state = 0x9E3779B97F4A7C15ULL;
+
+        constexpr u64 next() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        // in [low, high)
+        constexpr f32 range(f32 low, f32 high) {
+            return low + (high - low) * (f32) (next() >> 40) / (f32) (1 << 24);
+        }
+
+        float3 direction() {
+            return float3 { range(-1, 1), range(-1, 1), range(-1, 1) + 2.0f }.normalized();
+        }
+
+        quaternion rotation() {
+            return quaternion::fromAngleAxis(range(-TAU, TAU), direction());
+        }
+
+        float4x4 matrix() {
+            return float4x4::fromRotation(rotation()) * float4x4::translate(float3 { range(-10, 10), range(-10, 10), range(-10, 10) });
+        }
+    };
+
+    template<typename T>
+    memory::Slice<T const> read(memory::Array<T> &values) {
+        return memory::Slice<T const> { (T const *) values.slice(), values.size() };
+    }
+
+    template<typename T, typename F>
+    memory::Array<T> generate(u64 count, F &&make) {
+        memory::Array<T> values { memory::GlobalAllocator::instance(), count };
+        for (u64 i = 0; i < count; ++i) values.push(make(i));
+        return values;
+    }
+
+    u64 mismatches(memory::Array<f32> &batch, memory::Array<f32> &single) {
+        u64 count = 0;
+        for (u64 i = 0; i < batch.size(); ++i) {
+            if (memcmp(&batch[i], &single[i], sizeof(f32)) != 0) ++count;
+        }
+        return count;
+    }
+
+    void check(bench::State &state, f64 maxError, f64 bound, u64 mismatchCount) {
+        state.counter("max_error", maxError);
+        state.counter("mismatches", (f64) mismatchCount);
+        if (maxError > bound) state.fail("error past the documented bound");
+        if (mismatchCount > 0 && !CONTRACTED) state.fail("batch results differ from single values");
+    }
+
+    constexpr u64 SCALAR_SWEEP = 256;
+
+    // inputs and what the scalar code makes of them, built in constant evaluation, which never takes the SIMD code.
+    // 'a' and 'b' double as quaternions, and the vector rotated by 'b' is the first three components of 'a'.
+    // 'normalize' has no scalar path there, 'fisqrt' reinterprets bits, so only its squared magnitude is kept
+    struct ScalarSweep {
+        f32 a[SCALAR_SWEEP][4];
+        f32 b[SCALAR_SWEEP][4];
+        f32 scalar[SCALAR_SWEEP];
+        f32 negated[SCALAR_SWEEP][4];
+        f32 sum[SCALAR_SWEEP][4];
+        f32 difference[SCALAR_SWEEP][4];
+        f32 product[SCALAR_SWEEP][4];
+        f32 quotient[SCALAR_SWEEP][4];
+        f32 dot[SCALAR_SWEEP];
+        f32 sqrMagnitude[SCALAR_SWEEP];
+        f32 quaternionProduct[SCALAR_SWEEP][4];
+        f32 rotated[SCALAR_SWEEP][3];
+    };
+
+    constexpr void unpack(float4 v, f32 (&out)[4]) {
+        out[0] = v.x;
+        out[1] = v.y;
+        out[2] = v.z;
+        out[3] = v.w;
+    }
+
+    constexpr ScalarSweep SCALAR = [] {
+        ScalarSweep sweep {};
+        Random random;
+        for (u64 i = 0; i < SCALAR_SWEEP; ++i) {
+            float4 a { random.range(-10, 10), random.range(-10, 10), random.range(-10, 10), random.range(-10, 10) };
+            float4 b { random.range(-2, 2), random.range(-2, 2), random.range(-2, 2), random.range(-2, 2) };
+            f32 scalar = random.range(0.5f, 4);
+            unpack(a, sweep.a[i]);
+            unpack(b, sweep.b[i]);
+            sweep.scalar[i] = scalar;
+            unpack(-a, sweep.negated[i]);
+            unpack(a + b, sweep.sum[i]);
+            unpack(a - b, sweep.difference[i]);
+            unpack(a * scalar, sweep.product[i]);
+            unpack(a / scalar, sweep.quotient[i]);
+            sweep.dot[i] = a.dot(b);
+            sweep.sqrMagnitude[i] = a.sqrMagnitude();
+
+            quaternion p { a.x, a.y, a.z, a.w };
+            quaternion q { b.x, b.y, b.z, b.w };
+            quaternion product = p * q;
+            unpack(float4 { product.x, product.y, product.z, product.w }, sweep.quaternionProduct[i]);
+            float3 rotated = q * float3 { a.x, a.y, a.z };
+            sweep.rotated[i][0] = rotated.x;
+            sweep.rotated[i][1] = rotated.y;
+            sweep.rotated[i][2] = rotated.z;
+        }
+        return sweep;
+    }();
+
+    float4 sweepFloat4(f32 const (&values)[4]) {
+        return float4 { values[0], values[1], values[2], values[3] };
+    }
+
+    u64 differ(f32 const *values, f32 const *expected, u64 count) {
+        u64 result = 0;
+        for (u64 i = 0; i < count; ++i) {
+            if (memcmp(&values[i], &expected[i], sizeof(f32)) != 0) ++result;
+        }
+        return result;
+    }
+
+    void checkScalar(bench::State &state, u64 mismatchCount) {
+        state.counter("mismatches", (f64) mismatchCount);
+        if (mismatchCount > 0 && !CONTRACTED) state.fail("SIMD results differ from the scalar code");
+    }
+
+    // the accuracy of 'sin' and 'cos' over [-1000, 1000], then the batch over 'state.argument' angles
+    template<typename Precision>
+    void sincos(bench::State &state, f64 bound) {
+        memory::Array<f32> angles = generate<f32>(SWEEP, [](u64 i) { return -1000.0f + 2000.0f * (f32) i / (f32) SWEEP; });
+        memory::Array<f32> sines = generate<f32>(SWEEP, [](u64) { return 0.0f; });
+        memory::Array<f32> cosines = generate<f32>(SWEEP, [](u64) { return 0.0f; });
+        memory::Array<f32> singleSines = generate<f32>(SWEEP, [](u64) { return 0.0f; });
+        memory::Array<f32> singleCosines = generate<f32>(SWEEP, [](u64) { return 0.0f; });
+        math::sincos<Precision>(read(angles), sines.slice(), cosines.slice());
+        f64 maxError = 0;
+        for (u64 i = 0; i < SWEEP; ++i) {
+            Precision::sincos(angles[i], singleSines[i], singleCosines[i]);
+            f64 angle = (f64) angles[i];
+            maxError = std::fmax(maxError, std::fabs((f64) sines[i] - std::sin(angle)));
+            maxError = std::fmax(maxError, std::fabs((f64) cosines[i] - std::cos(angle)));
+        }
+        check(state, maxError, bound, mismatches(sines, singleSines) + mismatches(cosines, singleCosines));
+
+        u64 count = state.argument;
+        state.items = count;
+        while (state.loop()) {
+            math::sincos<Precision>(memory::Slice<f32 const> { (f32 const *) angles.slice(), count }, sines.slice(), cosines.slice());
+            bench::clobber(&sines[0]);
+        }
+    }
+
+    template<typename Precision>
+    void atan2(bench::State &state, f64 bound) {
+        Random random;
+        memory::Array<f32> ys = generate<f32>(SWEEP, [&](u64) { return random.range(-100, 100); });
+        memory::Array<f32> xs = generate<f32>(SWEEP, [&](u64) { return random.range(-100, 100); });
+        memory::Array<f32> results = generate<f32>(SWEEP, [](u64) { return 0.0f; });
+        memory::Array<f32> single = generate<f32>(SWEEP, [&](u64 i) { return Precision::atan2(ys[i], xs[i]); });
+        math::atan2<Precision>(read(ys), read(xs), results.slice());
+        f64 maxError = 0;
+        for (u64 i = 0; i < SWEEP; ++i) {
+            maxError = std::fmax(maxError, std::fabs((f64) results[i] - std::atan2((f64) ys[i], (f64) xs[i])));
+        }
+        check(state, maxError, bound, mismatches(results, single));
+
+        u64 count = state.argument;
+        state.items = count;
+        while (state.loop()) {
+            math::atan2<Precision>(memory::Slice<f32 const> { (f32 const *) ys.slice(), count }, memory::Slice<f32 const> { (f32 const *) xs.slice(), count }, results.slice());
+            bench::clobber(&results[0]);
+        }
+    }
+
+    template<typename Precision>
+    void acos(bench::State &state, f64 bound) {
+        memory::Array<f32> values = generate<f32>(SWEEP, [](u64 i) { return -1.0f + 2.0f * (f32) i / (f32) (SWEEP - 1); });
+        memory::Array<f32> results = generate<f32>(SWEEP, [](u64) { return 0.0f; });
+        memory::Array<f32> single = generate<f32>(SWEEP, [&](u64 i) { return Precision::acos(values[i]); });
+        math::acos<Precision>(read(values), results.slice());
+        f64 maxError = 0;
+        for (u64 i = 0; i < SWEEP; ++i) {
+            maxError = std::fmax(maxError, std::fabs((f64) results[i] - std::acos((f64) values[i])));
+        }
+        check(state, maxError, bound, mismatches(results, single));
+
+        u64 count = state.argument;
+        state.items = count;
+        while (state.loop()) {
+            math::acos<Precision>(memory::Slice<f32 const> { (f32 const *) values.slice(), count }, results.slice());
+            bench::clobber(&results[0]);
+        }
+    }
+
+    // the error is relative for 'rsqrt'
+    template<typename Precision>
+    void rsqrt(bench::State &state, f64 bound) {
+        memory::Array<f32> values = generate<f32>(SWEEP, [](u64 i) { return std::ldexp(1.0f + (f32) (i % 1024) / 1024.0f, (int) (i / 1024) - 32); });
+        memory::Array<f32> results = generate<f32>(SWEEP, [](u64) { return 0.0f; });
+        memory::Array<f32> single = generate<f32>(SWEEP, [&](u64 i) { return Precision::rsqrt(values[i]); });
+        math::rsqrt<Precision>(read(values), results.slice());
+        f64 maxError = 0;
+        for (u64 i = 0; i < SWEEP; ++i) {
+            f64 exact = 1.0 / std::sqrt((f64) values[i]);
+            maxError = std::fmax(maxError, std::fabs((f64) results[i] - exact) / exact);
+        }
+        check(state, maxError, bound, mismatches(results, single));
+
+        u64 count = state.argument;
+        state.items = count;
+        while (state.loop()) {
+            math::rsqrt<Precision>(memory::Slice<f32 const> { (f32 const *) values.slice(), count }, results.slice());
+            bench::clobber(&results[0]);
+        }
+    }
+}
+
+BENCH(math_float4x4_multiply, 1024) {
+    Random random;
+    memory::Array<float4x4> a = generate<float4x4>(state.argument, [&](u64) { return random.matrix(); });
+    memory::Array<float4x4> b = generate<float4x4>(state.argument, [&](u64) { return random.matrix(); });
+    memory::Array<float4x4> result = generate<float4x4>(state.argument, [](u64) { return float4x4 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = a[i] * b[i];
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_float4x4_transform, 1024) {
+    Random random;
+    float4x4 matrix = random.matrix();
+    memory::Array<float4> points = generate<float4>(state.argument, [&](u64) { return float4 { random.range(-10, 10), random.range(-10, 10), random.range(-10, 10), 1 }; });
+    memory::Array<float4> result = generate<float4>(state.argument, [](u64) { return float4 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = matrix * points[i];
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_transform_points, 4096) {
+    Random random;
+    float4x4 matrix = random.matrix();
+    memory::Array<float3> points = generate<float3>(state.argument, [&](u64) { return float3 { random.range(-10, 10), random.range(-10, 10), random.range(-10, 10) }; });
+    memory::Array<float3> result = generate<float3>(state.argument, [](u64) { return float3 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        math::transformPoints(matrix, read(points), result.slice());
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_float4_arithmetic, 1024) {
+    u64 differences = 0;
+    for (u64 i = 0; i < SCALAR_SWEEP; ++i) {
+        float4 a = sweepFloat4(SCALAR.a[i]);
+        float4 b = sweepFloat4(SCALAR.b[i]);
+        f32 scalar = SCALAR.scalar[i];
+        float4 assigned = a;
+        differences += differ((-a).values, SCALAR.negated[i], 4);
+        differences += differ((a + b).values, SCALAR.sum[i], 4);
+        differences += differ((assigned += b).values, SCALAR.sum[i], 4);
+        differences += differ((a - b).values, SCALAR.difference[i], 4);
+        differences += differ((a * scalar).values, SCALAR.product[i], 4);
+        differences += differ((a / scalar).values, SCALAR.quotient[i], 4);
+    }
+    checkScalar(state, differences);
+
+    Random random;
+    memory::Array<float4> a = generate<float4>(state.argument, [&](u64) { return float4 { random.range(-10, 10), random.range(-10, 10), random.range(-10, 10), random.range(-10, 10) }; });
+    memory::Array<float4> b = generate<float4>(state.argument, [&](u64) { return float4 { random.range(-2, 2), random.range(-2, 2), random.range(-2, 2), random.range(-2, 2) }; });
+    memory::Array<float4> result = generate<float4>(state.argument, [](u64) { return float4 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = (a[i] + b[i]) * 0.5f - b[i];
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_float4_dot, 1024) {
+    u64 differences = 0;
+    for (u64 i = 0; i < SCALAR_SWEEP; ++i) {
+        float4 a = sweepFloat4(SCALAR.a[i]);
+        float4 b = sweepFloat4(SCALAR.b[i]);
+        f32 dot = a.dot(b);
+        f32 staticDot = float4::dot(a, b);
+        f32 sqrMagnitude = a.sqrMagnitude();
+        differences += differ(&dot, &SCALAR.dot[i], 1);
+        differences += differ(&staticDot, &SCALAR.dot[i], 1);
+        differences += differ(&sqrMagnitude, &SCALAR.sqrMagnitude[i], 1);
+    }
+    checkScalar(state, differences);
+
+    Random random;
+    memory::Array<float4> a = generate<float4>(state.argument, [&](u64) { return float4 { random.range(-10, 10), random.range(-10, 10), random.range(-10, 10), random.range(-10, 10) }; });
+    memory::Array<float4> b = generate<float4>(state.argument, [&](u64) { return float4 { random.range(-2, 2), random.range(-2, 2), random.range(-2, 2), random.range(-2, 2) }; });
+    memory::Array<f32> result = generate<f32>(state.argument, [](u64) { return 0.0f; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = a[i].dot(b[i]);
+        bench::clobber(&result[0]);
+    }
+}
+
+// against the scalar formula of 'normalize' on the squared magnitude from constant evaluation
+BENCH(math_float4_normalize, 1024) {
+    u64 differences = 0;
+    for (u64 i = 0; i < SCALAR_SWEEP; ++i) {
+        float4 a = sweepFloat4(SCALAR.a[i]);
+        f32 root = math::fisqrt(SCALAR.sqrMagnitude[i]);
+        f32 expected[4] = { a.x * root, a.y * root, a.z * root, a.w * root };
+        float4 normalized = a;
+        normalized.normalize();
+        differences += differ(a.normalized().values, expected, 4);
+        differences += differ(normalized.values, expected, 4);
+    }
+    checkScalar(state, differences);
+
+    Random random;
+    memory::Array<float4> values = generate<float4>(state.argument, [&](u64) { return float4 { random.range(-2, 2), random.range(-2, 2), random.range(-2, 2), random.range(1, 2) }; });
+    memory::Array<float4> result = generate<float4>(state.argument, [](u64) { return float4 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = values[i].normalized();
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_quaternion_rotate, 1024) {
+    u64 differences = 0;
+    for (u64 i = 0; i < SCALAR_SWEEP; ++i) {
+        quaternion q { SCALAR.b[i][0], SCALAR.b[i][1], SCALAR.b[i][2], SCALAR.b[i][3] };
+        float3 rotated = q * float3 { SCALAR.a[i][0], SCALAR.a[i][1], SCALAR.a[i][2] };
+        differences += differ(rotated.values, SCALAR.rotated[i], 3);
+    }
+    checkScalar(state, differences);
+
+    Random random;
+    memory::Array<quaternion> rotations = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<float3> vectors = generate<float3>(state.argument, [&](u64) { return random.direction(); });
+    memory::Array<float3> result = generate<float3>(state.argument, [](u64) { return float3 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = rotations[i] * vectors[i];
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_quaternion_multiply, 1024) {
+    u64 differences = 0;
+    for (u64 i = 0; i < SCALAR_SWEEP; ++i) {
+        quaternion p { SCALAR.a[i][0], SCALAR.a[i][1], SCALAR.a[i][2], SCALAR.a[i][3] };
+        quaternion q { SCALAR.b[i][0], SCALAR.b[i][1], SCALAR.b[i][2], SCALAR.b[i][3] };
+        differences += differ((p * q).values, SCALAR.quaternionProduct[i], 4);
+    }
+    checkScalar(state, differences);
+
+    Random random;
+    memory::Array<quaternion> a = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> b = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> result = generate<quaternion>(state.argument, [](u64) { return quaternion {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = a[i] * b[i];
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_quaternion_normalize, 1024) {
+    Random random;
+    memory::Array<quaternion> values = generate<quaternion>(state.argument, [&](u64) { return quaternion { random.range(-2, 2), random.range(-2, 2), random.range(-2, 2), random.range(1, 2) }; });
+    memory::Array<quaternion> result = generate<quaternion>(state.argument, [](u64) { return quaternion {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = values[i].normalized();
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_float3_normalize, 1024) {
+    Random random;
+    memory::Array<float3> values = generate<float3>(state.argument, [&](u64) { return float3 { random.range(-2, 2), random.range(-2, 2), random.range(1, 2) }; });
+    memory::Array<float3> result = generate<float3>(state.argument, [](u64) { return float3 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) result[i] = values[i].normalized();
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_float3soa_normalize, 1024) {
+    Random random;
+    memory::Array<float3> values = generate<float3>(state.argument, [&](u64) { return float3 { random.range(-2, 2), random.range(-2, 2), random.range(1, 2) }; });
+    float3SoA soa { read(values) };
+    float3SoA result { read(values) };
+    state.items = state.argument;
+    while (state.loop()) {
+        math::normalize(soa, result);
+        bench::clobber(&result.x[0]);
+    }
+}
+
+BENCH(math_nlerp, 1024) {
+    Random random;
+    memory::Array<quaternion> a = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> b = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> result = generate<quaternion>(state.argument, [](u64) { return quaternion {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        math::nlerp(read(a), read(b), 0.3f, result.slice());
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_slerp_precise, 1024) {
+    Random random;
+    memory::Array<quaternion> a = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> b = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> result = generate<quaternion>(state.argument, [](u64) { return quaternion {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        math::slerp<Precise>(read(a), read(b), 0.3f, result.slice());
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_slerp_fast, 1024) {
+    Random random;
+    memory::Array<quaternion> a = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> b = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<quaternion> result = generate<quaternion>(state.argument, [](u64) { return quaternion {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        math::slerp<Fast>(read(a), read(b), 0.3f, result.slice());
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_to_matrices, 1024) {
+    Random random;
+    memory::Array<quaternion> rotations = generate<quaternion>(state.argument, [&](u64) { return random.rotation(); });
+    memory::Array<float4x4> result = generate<float4x4>(state.argument, [](u64) { return float4x4 {}; });
+    state.items = state.argument;
+    while (state.loop()) {
+        math::toMatrices(read(rotations), result.slice());
+        bench::clobber(&result[0]);
+    }
+}
+
+BENCH(math_sincos_std, 4096) {
+    memory::Array<f32> angles = generate<f32>(state.argument, [](u64 i) { return -1000.0f + 2000.0f * (f32) i / (f32) SWEEP; });
+    memory::Array<f32> sines = generate<f32>(state.argument, [](u64) { return 0.0f; });
+    memory::Array<f32> cosines = generate<f32>(state.argument, [](u64) { return 0.0f; });
+    state.items = state.argument;
+    while (state.loop()) {
+        for (u64 i = 0; i < state.argument; ++i) {
+            sines[i] = std::sin(angles[i]);
+            cosines[i] = std::cos(angles[i]);
+        }
+        bench::clobber(&sines[0]);
+    }
+}
+
+BENCH(math_sincos_fast, 4096) {
+    sincos<Fast>(state, 1e-7);
+}
+
+BENCH(math_sincos_approximate, 4096) {
+    sincos<Approximate>(state, 2e-5);
+}
+
+BENCH(math_atan2_fast, 4096) {
+    atan2<Fast>(state, 4e-7);
+}
+
+BENCH(math_atan2_approximate, 4096) {
+    atan2<Approximate>(state, 2e-5);
+}
+
+BENCH(math_acos_fast, 4096) {
+    acos<Fast>(state, 5e-7);
+}
+
+BENCH(math_acos_approximate, 4096) {
+    acos<Approximate>(state, 7e-5);
+}
+
+BENCH(math_rsqrt_fast, 4096) {
+    rsqrt<Fast>(state, 3e-7);
+}
+
+BENCH(math_rsqrt_approximate, 4096) {
+    rsqrt<Approximate>(state, 4e-4);
+}
+
+// spheres scattered around a camera at the origin looking down z, about a third of them visible
+BENCH(math_cull_spheres, 4096) {
+    Random random;
+    float4x4 clip = (float4x4::lookAt(float3 { 0, 0, 1 }) * float4x4::perspectiveDX(60.0f, 16.0f / 9.0f, 0.1f, 100.0f)).transposed();
+    frustum view = frustum::fromMatrix(clip);
+    memory::Array<float4> spheres = generate<float4>(state.argument, [&](u64) { return float4 { random.range(-60, 60), random.range(-60, 60), random.range(-20, 120), random.range(0.1f, 2.0f) }; });
+    float4SoA soa { read(spheres) };
+    memory::Array<u64> visible = generate<u64>((state.argument + 63) / 64, [](u64) { return (u64) 0; });
+
+    // the batch has to agree with 'frustum::intersects' one sphere at a time
+    u64 passed = math::cullSpheres(view, soa, visible.slice());
+    u64 differ = 0, single = 0;
+    for (u64 i = 0; i < state.argument; ++i) {
+        bool inside = view.intersects(sphere { float3 { spheres[i].x, spheres[i].y, spheres[i].z }, spheres[i].w });
+        single += inside;
+        differ += inside != (((visible[i / 64] >> (i % 64)) & 1) != 0);
+    }
+    state.counter("visible", (f64) passed / (f64) state.argument);
+    state.counter("mismatches", (f64) differ);
+    if (differ > 0 || passed != single) state.fail("batch culling differs from 'frustum::intersects'");
+
+    state.items = state.argument;
+    while (state.loop()) {
+        bench::keep(math::cullSpheres(view, soa, visible.slice()));
+    }
+}
+
+BENCH(math_cull_spheres_single, 4096) {
+    Random random;
+    float4x4 clip = (float4x4::lookAt(float3 { 0, 0, 1 }) * float4x4::perspectiveDX(60.0f, 16.0f / 9.0f, 0.1f, 100.0f)).transposed();
+    frustum view = frustum::fromMatrix(clip);
+    memory::Array<sphere> spheres = generate<sphere>(state.argument, [&](u64) { return sphere { float3 { random.range(-60, 60), random.range(-60, 60), random.range(-20, 120) }, random.range(0.1f, 2.0f) }; });
+    state.items = state.argument;
+    while (state.loop()) {
+        u64 passed = 0;
+        for (u64 i = 0; i < state.argument; ++i) passed += view.intersects(spheres[i]);
+        bench::keep(passed);
+    }
+}
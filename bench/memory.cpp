@@ -0,0 +1,216 @@
+// 'Array' against 'std::vector', the allocators against each other, and the 'simd' searches against the
+// standard algorithms
+#include <algorithm>
+#include <barrier>
+#include <thread>
+#include <vector>
+#include "bench.hpp"
+#include "utils/memory.hpp"
+#include "utils/simd.hpp"
+
+using namespace achilles;
+
+namespace {
+    constexpr u64 ALLOCATIONS = 1024;
+    constexpr u64 ALLOCATION_SIZE = 64;
+}
+
+BENCH(array_push, 16, 1024, 65536) {
+    state.items = state.argument;
+    while (state.loop()) {
+        memory::Array<u64> values { memory::GlobalAllocator::instance(), 0 };
+        for (u64 i = 0; i < state.argument; ++i) values.push(i);
+        bench::keep(values[state.argument - 1]);
+    }
+}
+
+BENCH(vector_push, 16, 1024, 65536) {
+    state.items = state.argument;
+    while (state.loop()) {
+        std::vector<u64> values;
+        for (u64 i = 0; i < state.argument; ++i) values.push_back(i);
+        bench::keep(values[state.argument - 1]);
+    }
+}
+
+// the value searched for is the last one, so the whole array is read
+BENCH(array_find, 16, 1024, 65536) {
+    memory::Array<u32> values { memory::GlobalAllocator::instance(), state.argument };
+    for (u64 i = 0; i < state.argument; ++i) values.push((u32) i);
+    u32 needle = (u32) state.argument - 1;
+    state.bytes = state.argument * sizeof(u32);
+    while (state.loop()) {
+        bench::clobber(&needle);
+        bench::keep(values.find(needle));
+    }
+}
+
+BENCH(vector_find, 16, 1024, 65536) {
+    std::vector<u32> values;
+    for (u64 i = 0; i < state.argument; ++i) values.push_back((u32) i);
+    u32 needle = (u32) state.argument - 1;
+    state.bytes = state.argument * sizeof(u32);
+    while (state.loop()) {
+        bench::clobber(&needle);
+        bench::keep(std::find(values.begin(), values.end(), needle));
+    }
+}
+
+// takes out the middle element and puts it back at the end, so the size stays the same
+BENCH(array_remove, 16, 1024, 65536) {
+    memory::Array<u64> values { memory::GlobalAllocator::instance(), state.argument };
+    for (u64 i = 0; i < state.argument; ++i) values.push(i);
+    while (state.loop()) {
+        values.push(values.remove(state.argument / 2));
+    }
+    bench::keep(values[0]);
+}
+
+BENCH(vector_remove, 16, 1024, 65536) {
+    std::vector<u64> values;
+    for (u64 i = 0; i < state.argument; ++i) values.push_back(i);
+    while (state.loop()) {
+        u64 value = values[state.argument / 2];
+        values.erase(values.begin() + (s64) (state.argument / 2));
+        values.push_back(value);
+    }
+    bench::keep(values[0]);
+}
+
+BENCH(array_swap_remove, 1024) {
+    memory::Array<u64> values { memory::GlobalAllocator::instance(), state.argument };
+    for (u64 i = 0; i < state.argument; ++i) values.push(i);
+    while (state.loop()) {
+        values.push(values.swapRemove(state.argument / 2));
+    }
+    bench::keep(values[0]);
+}
+
+// 'ALLOCATIONS' blocks of 'ALLOCATION_SIZE' bytes and then frees them all, the arena does that in one reset
+BENCH(allocator_global) {
+    memory::GlobalAllocator &allocator = memory::GlobalAllocator::instance();
+    u8 *blocks[ALLOCATIONS];
+    state.items = ALLOCATIONS;
+    while (state.loop()) {
+        for (u64 i = 0; i < ALLOCATIONS; ++i) blocks[i] = allocator.allocate(ALLOCATION_SIZE);
+        bench::clobber(blocks);
+        for (u64 i = 0; i < ALLOCATIONS; ++i) allocator.deallocate(&blocks[i], ALLOCATION_SIZE);
+    }
+}
+
+BENCH(allocator_arena) {
+    memory::ArenaAllocator allocator { ALLOCATIONS * ALLOCATION_SIZE };
+    u8 *blocks[ALLOCATIONS];
+    state.items = ALLOCATIONS;
+    while (state.loop()) {
+        for (u64 i = 0; i < ALLOCATIONS; ++i) blocks[i] = allocator.allocate(ALLOCATION_SIZE);
+        bench::clobber(blocks);
+        allocator.reset();
+    }
+}
+
+BENCH(allocator_pool) {
+    memory::PoolAllocator<ALLOCATION_SIZE, ALLOCATIONS> allocator {};
+    u8 *blocks[ALLOCATIONS];
+    state.items = ALLOCATIONS;
+    while (state.loop()) {
+        for (u64 i = 0; i < ALLOCATIONS; ++i) blocks[i] = allocator.allocate(ALLOCATION_SIZE);
+        bench::clobber(blocks);
+        for (u64 i = 0; i < ALLOCATIONS; ++i) allocator.deallocate(&blocks[i], ALLOCATION_SIZE);
+    }
+}
+
+BENCH(allocator_thread_cache_pool) {
+    memory::ThreadCachePool<ALLOCATION_SIZE, ALLOCATIONS> allocator {};
+    u8 *blocks[ALLOCATIONS];
+    state.items = ALLOCATIONS;
+    while (state.loop()) {
+        for (u64 i = 0; i < ALLOCATIONS; ++i) blocks[i] = allocator.allocate(ALLOCATION_SIZE);
+        bench::clobber(blocks);
+        for (u64 i = 0; i < ALLOCATIONS; ++i) allocator.deallocate(&blocks[i], ALLOCATION_SIZE);
+    }
+}
+
+// every thread allocates its blocks, then frees the ones its neighbour allocated, so with more than one thread all
+// the frees go through the owning heaps' remote lists and every allocation starts by taking a remote list over.
+// the main thread is one of them, the others are started before the timed loop and follow it round by round
+BENCH_THREADS(allocator_thread_cache_pool_remote) {
+    constexpr u64 MAX_THREADS = 256;
+    u64 threads = state.argument < MAX_THREADS ? state.argument : MAX_THREADS;
+    memory::ThreadCachePool<ALLOCATION_SIZE, ALLOCATIONS> allocator {};
+    memory::Array<u8 *> blocks { memory::GlobalAllocator::instance(), threads * ALLOCATIONS };
+    for (u64 i = 0; i < threads * ALLOCATIONS; ++i) blocks.push(nullptr);
+    std::barrier<> sync { (std::ptrdiff_t) threads };
+
+    auto round = [&](u64 thread) {
+        u8 **own = &blocks[thread * ALLOCATIONS];
+        u8 **neighbour = &blocks[((thread + 1) % threads) * ALLOCATIONS];
+        sync.arrive_and_wait();
+        for (u64 i = 0; i < ALLOCATIONS; ++i) own[i] = allocator.allocate(ALLOCATION_SIZE);
+        sync.arrive_and_wait();
+        for (u64 i = 0; i < ALLOCATIONS; ++i) allocator.deallocate(&neighbour[i], ALLOCATION_SIZE);
+    };
+
+    u64 iterations = state.iterations;
+    std::thread workers[MAX_THREADS];
+    for (u64 t = 1; t < threads; ++t) {
+        workers[t] = std::thread { [&round, iterations, t] {
+            for (u64 i = 0; i < iterations; ++i) round(t);
+        } };
+    }
+    state.items = threads * ALLOCATIONS;
+    state.counter("threads", (f64) threads);
+    while (state.loop()) round(0);
+    for (u64 t = 1; t < threads; ++t) workers[t].join();
+
+    for (u64 i = 0; i < threads * ALLOCATIONS; ++i) {
+        if (blocks[i] != nullptr) state.fail("a block wasn't freed");
+    }
+}
+
+// bytes are searched for one that sits at the end, like a terminator
+BENCH(simd_find_u8, 64, 4096, 1048576) {
+    memory::Array<u8> values { memory::GlobalAllocator::instance(), state.argument };
+    for (u64 i = 0; i < state.argument; ++i) values.push((u8) (i % 255));
+    values[state.argument - 1] = 255;
+    u8 needle = 255;
+    state.bytes = state.argument;
+    while (state.loop()) {
+        bench::clobber(&needle);
+        bench::keep(simd::find((u8 const *) &values[0], state.argument, needle));
+    }
+}
+
+BENCH(std_find_u8, 64, 4096, 1048576) {
+    std::vector<u8> values;
+    for (u64 i = 0; i < state.argument; ++i) values.push_back((u8) (i % 255));
+    values[state.argument - 1] = 255;
+    u8 needle = 255;
+    state.bytes = state.argument;
+    while (state.loop()) {
+        bench::clobber(&needle);
+        bench::keep(std::find(values.begin(), values.end(), needle));
+    }
+}
+
+BENCH(simd_count_u32, 4096) {
+    memory::Array<u32> values { memory::GlobalAllocator::instance(), state.argument };
+    for (u64 i = 0; i < state.argument; ++i) values.push((u32) (i % 7));
+    u32 needle = 3;
+    state.bytes = state.argument * sizeof(u32);
+    while (state.loop()) {
+        bench::clobber(&needle);
+        bench::keep(simd::count((u32 const *) &values[0], state.argument, needle));
+    }
+}
+
+BENCH(std_count_u32, 4096) {
+    std::vector<u32> values;
+    for (u64 i = 0; i < state.argument; ++i) values.push_back((u32) (i % 7));
+    u32 needle = 3;
+    state.bytes = state.argument * sizeof(u32);
+    while (state.loop()) {
+        bench::clobber(&needle);
+        bench::keep(std::count(values.begin(), values.end(), needle));
+    }
+}
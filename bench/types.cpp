@@ -0,0 +1,75 @@
+// the type-erased holders against the standard ones: 'AnyValue' against a value on the heap, and
+// 'InplaceFunction' and 'FunctionRef' against 'std::function' with a capture too big for its small buffer
+#include <functional>
+#include <memory>
+#include "bench.hpp"
+#include "utils/types.hpp"
+#include "utils/memory.hpp"
+
+using namespace achilles;
+
+namespace {
+    constexpr u64 VALUES = 1024;
+
+    struct Transform {
+        f32 position[3];
+        f32 rotation[4];
+    };
+
+    u64 callThrough(types::FunctionRef<u64(u64)> function, u64 value) {
+        return function(value);
+    }
+}
+
+BENCH(types_any_value) {
+    state.items = VALUES;
+    while (state.loop()) {
+        for (u64 i = 0; i < VALUES; ++i) {
+            memory::AnyValue value { Transform { { (f32) i, 0, 0 }, { 0, 0, 0, 1 } } };
+            bench::keep(value.get<Transform>()->position[0]);
+        }
+    }
+}
+
+BENCH(types_unique_ptr) {
+    state.items = VALUES;
+    while (state.loop()) {
+        for (u64 i = 0; i < VALUES; ++i) {
+            std::unique_ptr<Transform> value { new Transform { { (f32) i, 0, 0 }, { 0, 0, 0, 1 } } };
+            bench::keep(value->position[0]);
+        }
+    }
+}
+
+// three pointers captured, past what 'std::function' keeps inline in libstdc++
+BENCH(types_inplace_function) {
+    u64 a = 1, b = 2, c = 3;
+    state.items = VALUES;
+    while (state.loop()) {
+        for (u64 i = 0; i < VALUES; ++i) {
+            types::InplaceFunction<u64(u64)> function = [&a, &b, &c](u64 x) { return x * a + b * c; };
+            bench::keep(function(i));
+        }
+    }
+}
+
+BENCH(types_std_function) {
+    u64 a = 1, b = 2, c = 3;
+    state.items = VALUES;
+    while (state.loop()) {
+        for (u64 i = 0; i < VALUES; ++i) {
+            std::function<u64(u64)> function = [&a, &b, &c](u64 x) { return x * a + b * c; };
+            bench::keep(function(i));
+        }
+    }
+}
+
+BENCH(types_function_ref) {
+    u64 a = 1, b = 2, c = 3;
+    state.items = VALUES;
+    while (state.loop()) {
+        for (u64 i = 0; i < VALUES; ++i) {
+            bench::keep(callThrough([&a, &b, &c](u64 x) { return x * a + b * c; }, i));
+        }
+    }
+}
@@ -1,13 +1,128 @@
 #if !defined(ACHILLES_ENUMS_HPP)
 #define ACHILLES_ENUMS_HPP
 
+#include "types.hpp"
+
+namespace achilles {
+    namespace enums {
+        // FNV-1a, like 'hash::fnv1a', which this doesn't include to stay light
+        constexpr u64 hashName(char const *name, u64 length) {
+            u64 hash = 0xcbf29ce484222325;
+            for (u64 i = 0; i < length; ++i) {
+                hash ^= (u8) name[i];
+                hash *= 0x00000100000001B3;
+            }
+            return hash;
+        }
+
+        constexpr u64 nameLength(char const *name) {
+            u64 length = 0;
+            while (name[length] != '\0') ++length;
+            return length;
+        }
+
+        // 'name' is zero terminated, 'string' is 'length' characters that don't have to be
+        constexpr bool nameEquals(char const *name, char const *string, u64 length) {
+            for (u64 i = 0; i < length; ++i) {
+                if (name[i] != string[i]) return false;
+            }
+            return name[length] == '\0';
+        }
+
+        // a compile-time value with static storage. the tables below are kept in these rather than in static
+        // members of the enum, which a class declared inside a function can't have
+        template<auto Value>
+        struct Constant {
+            static constexpr decltype(Value) value = Value;
+        };
+
+        template<typename T, u64 Count>
+        struct List {
+            T items[Count > 0 ? Count : 1];
+        };
+
+        constexpr u64 namesSize(char const *const *names, u64 count) {
+            u64 size = 0;
+            for (u64 i = 0; i < count; ++i) size += nameLength(names[i]) + 1;
+            return size > 0 ? size : 1;
+        }
+
+        // the names of an enum and a hash table from them to their indices, built at compile time. the names are
+        // copied in one after the other, zero terminated. the table has at least twice as many slots as names so
+        // the linear probes stay short, and a slot is skipped on the upper hash bits before any characters are
+        // compared
+        template<u64 Count, u64 Size>
+        struct NameTable {
+            static constexpr u64 SLOTS = [] {
+                u64 slots = 2;
+                while (slots < Count * 2) slots *= 2;
+                return slots;
+            }();
+
+            struct Slot {
+                // the index plus one, zero for an empty slot
+                u32 index;
+                u32 tag;
+            };
+
+            char text[Size];
+            u32 offsets[Count > 0 ? Count : 1];
+            Slot slots[SLOTS];
+
+            constexpr char const *name(u64 index) const {
+                return text + offsets[index];
+            }
+
+            // the index of 'string', 'U64_MAX' if it isn't one of the names
+            constexpr u64 find(char const *string, u64 length) const {
+                u64 hash = hashName(string, length);
+                u32 tag = (u32) (hash >> 32);
+                for (u64 slot = hash & (SLOTS - 1); slots[slot].index != 0; slot = (slot + 1) & (SLOTS - 1)) {
+                    u32 index = slots[slot].index - 1;
+                    if (slots[slot].tag == tag && nameEquals(name(index), string, length)) return index;
+                }
+                return U64_MAX;
+            }
+        };
+
+        template<u64 Count, u64 Size>
+        constexpr NameTable<Count, Size> makeNameTable(List<char const *, Count> const &names) {
+            NameTable<Count, Size> table {};
+            u64 offset = 0;
+            for (u64 i = 0; i < Count; ++i) {
+                u64 length = nameLength(names.items[i]);
+                table.offsets[i] = (u32) offset;
+                for (u64 c = 0; c < length; ++c) table.text[offset + c] = names.items[i][c];
+                offset += length + 1;
+
+                u64 hash = hashName(names.items[i], length);
+                u64 slot = hash & (NameTable<Count, Size>::SLOTS - 1);
+                while (table.slots[slot].index != 0) slot = (slot + 1) & (NameTable<Count, Size>::SLOTS - 1);
+                table.slots[slot] = typename NameTable<Count, Size>::Slot { (u32) (i + 1), (u32) (hash >> 32) };
+            }
+            return table;
+        }
+
+        // pointers to the names of a table, for 'names()'
+        template<auto const &Table, u64 Count>
+        struct NamePointers {
+            static constexpr List<char const *, Count> value = [] {
+                List<char const *, Count> names {};
+                for (u64 i = 0; i < Count; ++i) names.items[i] = Table.name(i);
+                return names;
+            }();
+        };
+    }
+}
+
 #define _MACRO_PARENS ()
 
-#define _MACRO_EXPAND0(arg) arg
-#define _MACRO_EXPAND1(arg) _MACRO_EXPAND0(_MACRO_EXPAND0(_MACRO_EXPAND0(_MACRO_EXPAND0(arg))))
-#define _MACRO_EXPAND2(arg) _MACRO_EXPAND1(_MACRO_EXPAND1(_MACRO_EXPAND1(_MACRO_EXPAND1(arg))))
-#define _MACRO_EXPAND3(arg) _MACRO_EXPAND2(_MACRO_EXPAND2(_MACRO_EXPAND2(_MACRO_EXPAND2(arg))))
-#define _MACRO_EXPAND4(arg) _MACRO_EXPAND3(_MACRO_EXPAND3(_MACRO_EXPAND3(_MACRO_EXPAND3(arg))))
+// variadic, so what the loop body expands to can have commas in it
+#define _MACRO_EXPAND0(...) __VA_ARGS__
+#define _MACRO_EXPAND1(...) _MACRO_EXPAND0(_MACRO_EXPAND0(_MACRO_EXPAND0(_MACRO_EXPAND0(__VA_ARGS__))))
+#define _MACRO_EXPAND2(...) _MACRO_EXPAND1(_MACRO_EXPAND1(_MACRO_EXPAND1(_MACRO_EXPAND1(__VA_ARGS__))))
+#define _MACRO_EXPAND3(...) _MACRO_EXPAND2(_MACRO_EXPAND2(_MACRO_EXPAND2(_MACRO_EXPAND2(__VA_ARGS__))))
+#define _MACRO_EXPAND4(...) _MACRO_EXPAND3(_MACRO_EXPAND3(_MACRO_EXPAND3(_MACRO_EXPAND3(__VA_ARGS__))))
 
 #define _MACRO_FOREACH_HELPER0() _MACRO_FOREACH_HELPER1
 
@@ -19,6 +134,8 @@
     __VA_OPT__(_MACRO_EXPAND4(_MACRO_FOREACH_HELPER1(macro, __VA_ARGS__)))
 
 #define _MACRO_ENUM_CASE(name) case name: return #name;
+#define _MACRO_ENUM_NAME(name) #name,
+#define _MACRO_ENUM_ONE(name) + 1
 
 #define _MACRO_ENUM_BEGIN(name)\
     struct name {\
@@ -28,9 +145,21 @@
     struct name {\
         enum Value : type {
 
+// the values are numbered from zero in the order they are declared, so a value is its own index into 'values()'
 #define _MACRO_ENUM_END(name, ...)\
             __VA_ARGS__\
         };\
+        static constexpr u64 count() { return 0 _MACRO_FOREACH(_MACRO_ENUM_ONE, __VA_ARGS__); }\
+    private:\
+        /* ahead of the functions that use them, a deduced return type can't be used before its body */\
+        static constexpr auto _nameList() {\
+            return achilles::enums::List<char const *, count()> { { _MACRO_FOREACH(_MACRO_ENUM_NAME, __VA_ARGS__) } };\
+        }\
+        static constexpr auto const &_table() {\
+            constexpr u64 size = achilles::enums::namesSize(_nameList().items, count());\
+            return achilles::enums::Constant<achilles::enums::makeNameTable<count(), size>(_nameList())>::value;\
+        }\
+    public:\
         name() = default;\
         constexpr name(Value value) : _value(value) {}\
         explicit operator bool() const = delete;\
@@ -41,6 +170,26 @@
             };\
             return "";\
         }\
+        static constexpr auto const &values() {\
+            return achilles::enums::Constant<achilles::enums::List<Value, count()> { { __VA_ARGS__ } }>::value.items;\
+        }\
+        static constexpr auto const &names() {\
+            return achilles::enums::NamePointers<_table(), count()>::value.items;\
+        }\
+        /* the position of the value in 'values()', 'U64_MAX' for anything cast in that wasn't declared */\
+        constexpr u64 index() const { return (u64) _value < count() ? (u64) _value : U64_MAX; }\
+        /* 'index' has to be below 'count()' */\
+        static constexpr name fromIndex(u64 index) { return values()[index]; }\
+        /* the value named exactly 'string', through a table built at compile time. false when there is none */\
+        static constexpr bool fromString(char const *string, u64 length, name &outValue) {\
+            u64 index = _table().find(string, length);\
+            if (index == U64_MAX) return false;\
+            outValue = values()[index];\
+            return true;\
+        }\
+        static constexpr bool fromString(char const *string, name &outValue) {\
+            return fromString(string, achilles::enums::nameLength(string), outValue);\
+        }\
     private:\
         Value _value;\
     }
@@ -54,4 +203,3 @@
         _MACRO_ENUM_END(name, __VA_ARGS__)
 
 #endif
-
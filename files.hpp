@@ -4,9 +4,42 @@
 
 // this file requires <stdio.h> for 'fopen' and friends
 #include <cstdio>
+// and <thread> and friends for the prefetching in 'StreamReader'
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "types.hpp"
 #include "assert.hpp"
 
+// and the platform's file mapping functions for 'mapFile'
+#if defined(_WIN32)
+    #if !defined(WIN32_LEAN_AND_MEAN)
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #if !defined(NOMINMAX)
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+#endif
+
+// 'BatchReader' talks to io_uring through the raw system calls, there is no liburing dependency
+#if defined(__linux__)
+    #include <atomic>
+    #include <cerrno>
+    #include <sched.h>
+    #include <sys/syscall.h>
+    #include <linux/io_uring.h>
+    #define ACHILLES_IO_URING 1
+#else
+    #define ACHILLES_IO_URING 0
+#endif
+
 namespace achilles {
     namespace files {
         using namespace memory;
@@ -14,40 +47,139 @@ namespace achilles {
         enum FileMode : u8 {
             FILE_BINARY,
             FILE_TEXT,
+            // binary, bypassing the page cache ('O_DIRECT', 'FILE_FLAG_NO_BUFFERING') for big streaming loads that
+            // are read once. the memory is allocated 'DIRECT_ALIGNMENT' aligned, so the allocator has to support it
+            FILE_DIRECT,
+        };
+
+        enum FileError : u8 {
+            FILE_OK,
+            FILE_OPEN_FAILED,
+            FILE_OUT_OF_MEMORY,
+            FILE_READ_FAILED,
+            FILE_WRITE_FAILED,
         };
 
-        inline Block readFile(const char *path, Allocator &allocator = GlobalAllocator::instance(), FileMode mode = FILE_BINARY) {
+        // the buffer and offset alignment unbuffered reads need, a page covers every common sector size
+        constexpr u64 DIRECT_ALIGNMENT = 4096;
+
+        inline void setError(FileError *error, FileError value) {
+            if (error) *error = value;
+        }
+
+        // reads with unbuffered access: whole aligned blocks straight into 'memory', then the partial last block
+        // through an aligned bounce buffer, since short reads are only allowed at the end of the file
+        inline bool readDirect(const char *path, u8 *memory, u64 size) {
+            alignas(DIRECT_ALIGNMENT) u8 tail[DIRECT_ALIGNMENT];
+            u64 bulk = size & ~(DIRECT_ALIGNMENT - 1);
+            u64 total = 0;
+            #if defined(_WIN32)
+                HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                          FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+                if (file == INVALID_HANDLE_VALUE) return false;
+                while (total < size) {
+                    u64 remaining = bulk - total;
+                    bool partial = remaining == 0;
+                    // one 'ReadFile' takes at most 4GB, keep chunks aligned
+                    DWORD chunk = partial ? (DWORD) DIRECT_ALIGNMENT : (DWORD) (remaining < GB(1) ? remaining : GB(1));
+                    DWORD read = 0;
+                    if (!ReadFile(file, partial ? tail : memory + total, chunk, &read, nullptr) || read == 0) break;
+                    if (partial) memcpy(memory + total, tail, read < size - total ? read : size - total);
+                    total += read;
+                }
+                CloseHandle(file);
+            #else
+                int flags = O_RDONLY;
+                #if defined(O_DIRECT)
+                    flags |= O_DIRECT;
+                #endif
+                int file = open(path, flags);
+                // some file systems (e.g. tmpfs) refuse 'O_DIRECT', those go through the page cache
+                if (file < 0) file = open(path, O_RDONLY);
+                if (file < 0) return false;
+                #if defined(F_NOCACHE)
+                    fcntl(file, F_NOCACHE, 1);
+                #endif
+                while (total < size) {
+                    u64 remaining = bulk - total;
+                    bool partial = remaining == 0;
+                    u64 chunk = partial ? DIRECT_ALIGNMENT : (remaining < GB(1) ? remaining : GB(1));
+                    ssize_t read = pread(file, partial ? tail : memory + total, chunk, (off_t) total);
+                    if (read <= 0) break;
+                    if (partial) memcpy(memory + total, tail, (u64) read < size - total ? (u64) read : size - total);
+                    total += (u64) read;
+                }
+                close(file);
+            #endif
+            return total >= size;
+        }
+
+        // the file is read straight into memory from 'allocator', in as few calls as the platform allows. the
+        // block is invalid when anything fails, 'error' says what
+        inline Block readFile(const char *path, Allocator &allocator = GlobalAllocator::instance(), FileMode mode = FILE_BINARY, FileError *error = nullptr) {
+            setError(error, FILE_OK);
             FILE* file = nullptr;
-            constexpr u64 READ_BUFFER_SIZE = 256;
 
             const char *readMode = "rb";
             if (mode == FILE_TEXT) readMode = "r";
 
-            if ((file = std::fopen(path, readMode)) != nullptr) {
-                std::fseek(file, 0, SEEK_END);
-                u64 fileSize = ftell(file);
-                std::rewind(file);
-                u8 *memory = allocator.allocate(fileSize);
+            if ((file = std::fopen(path, readMode)) == nullptr) {
+                setError(error, FILE_OPEN_FAILED);
+                return Block { nullptr, 0, allocator };
+            }
+
+            // 'ftell' is 32 bits on windows
+            #if defined(_WIN32)
+                _fseeki64(file, 0, SEEK_END);
+                s64 end = _ftelli64(file);
+            #else
+                fseeko(file, 0, SEEK_END);
+                s64 end = (s64) ftello(file);
+            #endif
+            std::rewind(file);
+            if (end <= 0) {
+                std::fclose(file);
+                if (end < 0) setError(error, FILE_READ_FAILED);
+                return Block { nullptr, 0, allocator };
+            }
+            u64 fileSize = (u64) end;
+
+            u8 *memory = mode == FILE_DIRECT ? allocator.allocateAligned(fileSize, DIRECT_ALIGNMENT) : allocator.allocate(fileSize);
+            if (memory == nullptr) {
+                std::fclose(file);
+                setError(error, FILE_OUT_OF_MEMORY);
+                return Block { nullptr, 0, allocator };
+            }
+            Block result { memory, fileSize, allocator };
+
+            bool ok = true;
+            if (mode == FILE_DIRECT) {
+                std::fclose(file);
+                ok = readDirect(path, memory, fileSize);
+            } else {
+                // text mode can read fewer bytes than the file holds (windows drops the '\r's), the rest stays zero
                 u64 totalBytesRead = 0;
-                u8 buffer[READ_BUFFER_SIZE];
-                while (!std::feof(file)) {
-                    u64 readBytes = std::fread(buffer, sizeof *buffer, READ_BUFFER_SIZE, file);
+                while (totalBytesRead < fileSize) {
+                    u64 readBytes = std::fread(memory + totalBytesRead, 1, fileSize - totalBytesRead, file);
                     if (readBytes == 0) break;
-                    for (u64 i = 0; i < readBytes; i++) {
-                        memory[totalBytesRead++] = buffer[i];
-                    }
+                    totalBytesRead += readBytes;
                 }
+                ok = !std::ferror(file) && (mode == FILE_TEXT || totalBytesRead == fileSize);
                 std::fclose(file);
-                return Block {memory, fileSize, allocator};
             }
-            
-            return Block { nullptr, 0, allocator };
+
+            if (!ok) {
+                setError(error, FILE_READ_FAILED);
+                return Block { nullptr, 0, allocator };
+            }
+            return result;
         }
 
-        inline bool writeToFile(const char *path, Block &block, u64 elementsToWrite = 0, FileMode mode = FILE_BINARY) {
+        inline bool writeToFile(const char *path, Block &block, u64 elementsToWrite = 0, FileMode mode = FILE_BINARY, FileError *error = nullptr) {
             aassert(block.isValid(), "trying to write to a file from an invalid memory block");
             u64 count = block.size();
             aassert(count >= elementsToWrite, "trying to write more elements than stored in the memory holder");
+            setError(error, FILE_OK);
 
             FILE *file = nullptr;
 
@@ -59,13 +191,690 @@ namespace achilles {
                 if (elementsToWrite != 0) {
                     elementCount = elementsToWrite;
                 }
-                std::fwrite((void *) block, sizeof(u8), elementCount, file);
-                std::fclose(file);
-                return true;
+                bool ok = std::fwrite((void *) block, sizeof(u8), elementCount, file) == elementCount;
+                ok = std::fclose(file) == 0 && ok;
+                if (!ok) setError(error, FILE_WRITE_FAILED);
+                return ok;
             }
 
+            setError(error, FILE_OPEN_FAILED);
             return false;
         }
+
+        // writes 'blocks' one after the other into a single file, with vectored writes ('writev') where available
+        inline bool writeBlocksToFile(const char *path, Slice<Block const *> blocks, FileError *error = nullptr) {
+            setError(error, FILE_OK);
+            bool ok = true;
+            #if defined(_WIN32)
+                FILE *file = std::fopen(path, "wb");
+                if (file == nullptr) {
+                    setError(error, FILE_OPEN_FAILED);
+                    return false;
+                }
+                for (u64 i = 0; i < blocks.size() && ok; ++i) {
+                    Block const &block = *blocks[i];
+                    if (block.size() == 0) continue;
+                    ok = std::fwrite((u8 *) block, 1, block.size(), file) == block.size();
+                }
+                ok = std::fclose(file) == 0 && ok;
+            #else
+                int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (file < 0) {
+                    setError(error, FILE_OPEN_FAILED);
+                    return false;
+                }
+                constexpr u64 BATCH = 64;
+                struct iovec parts[BATCH];
+                u64 next = 0;
+                while (ok && next < blocks.size()) {
+                    u64 count = 0;
+                    for (; next < blocks.size() && count < BATCH; ++next) {
+                        Block const &block = *blocks[next];
+                        if (block.size() == 0) continue;
+                        parts[count++] = iovec { (u8 *) block, (size_t) block.size() };
+                    }
+                    // a write can stop short, skip what made it and go again
+                    struct iovec *pending = parts;
+                    while (ok && count > 0) {
+                        ssize_t written = writev(file, pending, (int) count);
+                        if (written < 0) {
+                            ok = false;
+                            break;
+                        }
+                        u64 left = (u64) written;
+                        while (count > 0 && left >= pending->iov_len) {
+                            left -= pending->iov_len;
+                            pending += 1;
+                            count -= 1;
+                        }
+                        if (count > 0) {
+                            pending->iov_base = (u8 *) pending->iov_base + left;
+                            pending->iov_len -= left;
+                        }
+                    }
+                }
+                ok = close(file) == 0 && ok;
+            #endif
+            if (!ok) setError(error, FILE_WRITE_FAILED);
+            return ok;
+        }
+
+        // reads a file front to back in chunks of 'chunkSize' bytes, with the next chunk already being read on a
+        // background thread while the current one is processed, so memory stays at two chunks however big the
+        // file is. chunks are handed out by 'next' and stay valid until the following call
+        struct StreamReader {
+            explicit StreamReader(const char *path, u64 chunkSize = MB(1), Allocator &allocator = GlobalAllocator::instance())
+                : _chunkSize{chunkSize} {
+                aassert(chunkSize > 0, "stream chunks need a non-zero size");
+                if ((_file = std::fopen(path, "rb")) == nullptr) {
+                    _error = FILE_OPEN_FAILED;
+                    return;
+                }
+                for (auto &chunk : _chunks) {
+                    u8 *memory = allocator.allocate(chunkSize);
+                    if (memory == nullptr) {
+                        _error = FILE_OUT_OF_MEMORY;
+                        return;
+                    }
+                    chunk.block = Block { memory, chunkSize, allocator };
+                }
+                _reader = std::thread { [this] { prefetch(); } };
+            }
+
+            StreamReader(StreamReader const &other) = delete;
+            StreamReader &operator =(StreamReader const &other) = delete;
+
+            ~StreamReader() {
+                {
+                    std::lock_guard<std::mutex> lock { _mutex };
+                    _stop = true;
+                }
+                _changed.notify_all();
+                if (_reader.joinable()) _reader.join();
+                if (_file) std::fclose(_file);
+            }
+
+            bool isValid() const {
+                return _reader.joinable();
+            }
+
+            // the next chunk of the file, empty once the whole file was read or a read failed (see 'error'). the
+            // previous chunk is given back to the background thread
+            Slice<u8> next() {
+                if (!isValid()) return Slice<u8> { nullptr, 0 };
+                std::unique_lock<std::mutex> lock { _mutex };
+                if (_held) {
+                    _chunks[(_consumed - 1) & 1].state = CHUNK_FREE;
+                    _held = false;
+                    _changed.notify_all();
+                }
+                Chunk &chunk = _chunks[_consumed & 1];
+                _changed.wait(lock, [&] { return chunk.state == CHUNK_READY; });
+                // the last chunk is empty and stays ready, so the end can be asked for again
+                if (chunk.size == 0) return Slice<u8> { nullptr, 0 };
+                chunk.state = CHUNK_HELD;
+                _held = true;
+                _consumed += 1;
+                _offset += chunk.size;
+                return Slice<u8> { (u8 *) chunk.block, chunk.size };
+            }
+
+            FileError error() {
+                std::lock_guard<std::mutex> lock { _mutex };
+                return _error;
+            }
+
+            // how many bytes have been handed out so far
+            u64 offset() const {
+                return _offset;
+            }
+        private:
+            enum ChunkState : u8 {
+                CHUNK_FREE,
+                CHUNK_READY,
+                CHUNK_HELD,
+            };
+
+            struct Chunk {
+                Block block;
+                u64 size = 0;
+                ChunkState state = CHUNK_FREE;
+            };
+
+            // the background thread, fills chunks in turn as soon as they're given back
+            void prefetch() {
+                for (u64 produced = 0; ; ++produced) {
+                    Chunk &chunk = _chunks[produced & 1];
+                    {
+                        std::unique_lock<std::mutex> lock { _mutex };
+                        _changed.wait(lock, [&] { return _stop || chunk.state == CHUNK_FREE; });
+                        if (_stop) return;
+                    }
+                    u8 *memory = (u8 *) chunk.block;
+                    u64 size = 0;
+                    while (size < _chunkSize) {
+                        u64 read = std::fread(memory + size, 1, _chunkSize - size, _file);
+                        if (read == 0) break;
+                        size += read;
+                    }
+                    bool failed = std::ferror(_file) != 0;
+                    {
+                        std::lock_guard<std::mutex> lock { _mutex };
+                        chunk.size = failed ? 0 : size;
+                        chunk.state = CHUNK_READY;
+                        if (failed) _error = FILE_READ_FAILED;
+                    }
+                    _changed.notify_all();
+                    if (failed || size == 0) return;
+                }
+            }
+
+            FILE *_file = nullptr;
+            u64 _chunkSize;
+            Chunk _chunks[2];
+            std::thread _reader;
+            std::mutex _mutex;
+            std::condition_variable _changed;
+            FileError _error = FILE_OK;
+            u64 _consumed = 0;
+            u64 _offset = 0;
+            bool _held = false;
+            bool _stop = false;
+        };
+
+        // reads many whole files at once, asynchronously: io_uring on linux, an I/O completion port on windows, and
+        // plain reads one file at a time where neither is available (or io_uring is blocked, e.g. by seccomp). up to
+        // 'depth' files are in flight at a time, each file gets one allocation from 'allocator', which can be an
+        // arena holding the whole batch. paths must stay alive until their file completes
+        struct BatchReader {
+            explicit BatchReader(Allocator &allocator = GlobalAllocator::instance(), u32 depth = 64)
+                : _allocator{&allocator}, _slots{GlobalAllocator::instance(), 0ull} {
+                aassert(depth > 0, "batch readers need a non-zero depth");
+                _slots.resize(depth);
+                for (u32 i = 0; i < depth; ++i) {
+                    _slots[i].request = U64_MAX;
+                }
+                #if defined(_WIN32)
+                    _port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+                #elif ACHILLES_IO_URING
+                    setupRing(depth);
+                #endif
+            }
+
+            BatchReader(BatchReader const &other) = delete;
+            BatchReader &operator =(BatchReader const &other) = delete;
+
+            // files still in flight are waited for and dropped, queued ones are never started
+            ~BatchReader() {
+                _completed += _requests.size() - _next;
+                _next = _requests.size();
+                wait([](u64, Block &&, FileError) {});
+                #if defined(_WIN32)
+                    if (_port) CloseHandle(_port);
+                #elif ACHILLES_IO_URING
+                    if (_ring >= 0) {
+                        munmap(_sqes, _sqesSize);
+                        if (_cqRing != _sqRing) munmap(_cqRing, _cqRingSize);
+                        munmap(_sqRing, _sqRingSize);
+                        close(_ring);
+                    }
+                #endif
+            }
+
+            // whether reads really run in the background, rather than one by one inside 'poll'
+            bool isAsync() const {
+                #if defined(_WIN32)
+                    return _port != nullptr;
+                #elif ACHILLES_IO_URING
+                    return _ring >= 0 && !_ringFailed;
+                #else
+                    return false;
+                #endif
+            }
+
+            // queues 'path', returns its index, which completions are reported with. nothing starts before 'poll'
+            u64 add(const char *path) {
+                _requests.push(Request { path });
+                return _requests.size() - 1;
+            }
+
+            // files added but not completed yet
+            u64 pending() const {
+                return _requests.size() - _completed;
+            }
+
+            // starts queued files while there's room and reports the ones that finished through
+            // 'onComplete(u64 index, Block &&data, FileError error)', which can move 'data' out to keep it. with
+            // 'block' set it waits for at least one completion if none is ready. returns how many completed
+            template<typename F>
+            u64 poll(F &&onComplete, bool block = false) {
+                u64 before = _completed;
+                startQueued(onComplete);
+                // reads already in the ring are still reaped when it failed, new ones are read right away
+                if (_inFlight > 0) {
+                    reap(onComplete, block && _completed == before);
+                }
+                return _completed - before;
+            }
+
+            // runs until every added file completed
+            template<typename F>
+            void wait(F &&onComplete) {
+                while (pending() > 0) {
+                    poll(onComplete, true);
+                }
+            }
+        private:
+            struct Request {
+                const char *path;
+            };
+
+            // an open file being read, slots never move so the kernel can keep pointers into them
+            struct Slot {
+                u64 request = U64_MAX;
+                u8 *memory = nullptr;
+                u64 size = 0;
+                u64 done = 0;
+                #if defined(_WIN32)
+                    HANDLE file = INVALID_HANDLE_VALUE;
+                    OVERLAPPED overlapped {};
+                #else
+                    int file = -1;
+                    #if ACHILLES_IO_URING
+                        iovec buffer {};
+                    #endif
+                #endif
+            };
+
+            // windows and linux cap a single read below 4GB and 2GB, big files take several
+            static constexpr u64 MAX_READ = GB(1);
+
+            template<typename F>
+            void startQueued(F &onComplete) {
+                for (u32 i = 0; i < _slots.size() && _next < _requests.size(); ++i) {
+                    if (_slots[i].request != U64_MAX) continue;
+                    Slot &slot = _slots[i];
+                    slot.request = _next++;
+                    slot.done = 0;
+                    FileError error = open(slot, i);
+                    if (error != FILE_OK || slot.size == 0) {
+                        finish(slot, error, onComplete);
+                        continue;
+                    }
+                    _inFlight += 1;
+                    if (!isAsync()) {
+                        readNow(slot);
+                        _inFlight -= 1;
+                        finish(slot, slot.done == slot.size ? FILE_OK : FILE_READ_FAILED, onComplete);
+                    } else if (!issue(slot, i)) {
+                        _inFlight -= 1;
+                        finish(slot, FILE_READ_FAILED, onComplete);
+                    }
+                }
+                #if ACHILLES_IO_URING && !defined(_WIN32)
+                    if (isAsync()) submit(0, onComplete);
+                #endif
+            }
+
+            FileError open(Slot &slot, u32 index) {
+                (void) index;
+                const char *path = _requests[slot.request].path;
+                #if defined(_WIN32)
+                    DWORD flags = FILE_FLAG_SEQUENTIAL_SCAN | (isAsync() ? FILE_FLAG_OVERLAPPED : 0);
+                    slot.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+                    if (slot.file == INVALID_HANDLE_VALUE) return FILE_OPEN_FAILED;
+                    LARGE_INTEGER size {};
+                    if (!GetFileSizeEx(slot.file, &size)) return FILE_READ_FAILED;
+                    if (isAsync() && CreateIoCompletionPort(slot.file, _port, (ULONG_PTR) index, 0) == nullptr) return FILE_READ_FAILED;
+                    slot.size = (u64) size.QuadPart;
+                #else
+                    slot.file = ::open(path, O_RDONLY);
+                    if (slot.file < 0) return FILE_OPEN_FAILED;
+                    struct stat status {};
+                    if (fstat(slot.file, &status) != 0) return FILE_READ_FAILED;
+                    slot.size = (u64) status.st_size;
+                #endif
+                if (slot.size == 0) return FILE_OK;
+                slot.memory = _allocator->allocate(slot.size);
+                return slot.memory ? FILE_OK : FILE_OUT_OF_MEMORY;
+            }
+
+            // the synchronous fallback
+            void readNow(Slot &slot) {
+                while (slot.done < slot.size) {
+                    u64 chunk = slot.size - slot.done < MAX_READ ? slot.size - slot.done : MAX_READ;
+                    #if defined(_WIN32)
+                        DWORD read = 0;
+                        if (!ReadFile(slot.file, slot.memory + slot.done, (DWORD) chunk, &read, nullptr) || read == 0) return;
+                    #else
+                        ssize_t read = pread(slot.file, slot.memory + slot.done, chunk, (off_t) slot.done);
+                        if (read <= 0) return;
+                    #endif
+                    slot.done += (u64) read;
+                }
+            }
+
+            // hands the file to 'onComplete' and frees the slot
+            template<typename F>
+            void finish(Slot &slot, FileError error, F &onComplete) {
+                #if defined(_WIN32)
+                    if (slot.file != INVALID_HANDLE_VALUE) CloseHandle(slot.file);
+                    slot.file = INVALID_HANDLE_VALUE;
+                #else
+                    if (slot.file >= 0) ::close(slot.file);
+                    slot.file = -1;
+                #endif
+                u64 request = slot.request;
+                Block data { nullptr, 0, *_allocator };
+                if (slot.memory) {
+                    data = Block { slot.memory, slot.size, *_allocator };
+                    // failed reads give their memory back
+                    if (error != FILE_OK) data = Block { nullptr, 0, *_allocator };
+                }
+                slot.request = U64_MAX;
+                slot.memory = nullptr;
+                slot.size = 0;
+                _completed += 1;
+                onComplete(request, std::move(data), error);
+            }
+
+            #if defined(_WIN32)
+                bool issue(Slot &slot, u32 index) {
+                    (void) index;
+                    u64 chunk = slot.size - slot.done < MAX_READ ? slot.size - slot.done : MAX_READ;
+                    slot.overlapped = OVERLAPPED {};
+                    slot.overlapped.Offset = (DWORD) slot.done;
+                    slot.overlapped.OffsetHigh = (DWORD) (slot.done >> 32);
+                    // completes through the port either way, even when 'ReadFile' finishes right away
+                    if (ReadFile(slot.file, slot.memory + slot.done, (DWORD) chunk, nullptr, &slot.overlapped)) return true;
+                    return GetLastError() == ERROR_IO_PENDING;
+                }
+
+                template<typename F>
+                void reap(F &onComplete, bool block) {
+                    OVERLAPPED_ENTRY entries[64];
+                    ULONG count = 0;
+                    if (!GetQueuedCompletionStatusEx(_port, entries, 64, &count, block ? INFINITE : 0, FALSE)) return;
+                    for (ULONG i = 0; i < count; ++i) {
+                        u32 index = (u32) entries[i].lpCompletionKey;
+                        Slot &slot = _slots[index];
+                        DWORD read = entries[i].dwNumberOfBytesTransferred;
+                        bool failed = entries[i].lpOverlapped->Internal != 0 || read == 0;
+                        slot.done += read;
+                        if (!failed && slot.done < slot.size && issue(slot, index)) continue;
+                        _inFlight -= 1;
+                        finish(slot, !failed && slot.done == slot.size ? FILE_OK : FILE_READ_FAILED, onComplete);
+                    }
+                }
+
+                HANDLE _port = nullptr;
+            #elif ACHILLES_IO_URING
+                void setupRing(u32 depth) {
+                    io_uring_params params {};
+                    int ring = (int) syscall(__NR_io_uring_setup, depth, &params);
+                    if (ring < 0) return;
+                    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+                    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                    if (single) {
+                        if (_cqRingSize > _sqRingSize) _sqRingSize = _cqRingSize;
+                        _cqRingSize = _sqRingSize;
+                    }
+                    _sqRing = (u8 *) mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+                    if (_sqRing == MAP_FAILED) {
+                        close(ring);
+                        return;
+                    }
+                    _cqRing = single ? _sqRing : (u8 *) mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+                    _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                    void *sqes = _cqRing == MAP_FAILED ? MAP_FAILED : mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+                    if (sqes == MAP_FAILED) {
+                        if (_cqRing != MAP_FAILED && _cqRing != _sqRing) munmap(_cqRing, _cqRingSize);
+                        munmap(_sqRing, _sqRingSize);
+                        close(ring);
+                        return;
+                    }
+                    _sqes = (io_uring_sqe *) sqes;
+                    _sqTail = (u32 *) (_sqRing + params.sq_off.tail);
+                    _sqMask = *(u32 *) (_sqRing + params.sq_off.ring_mask);
+                    _sqArray = (u32 *) (_sqRing + params.sq_off.array);
+                    _cqHead = (u32 *) (_cqRing + params.cq_off.head);
+                    _cqTail = (u32 *) (_cqRing + params.cq_off.tail);
+                    _cqMask = *(u32 *) (_cqRing + params.cq_off.ring_mask);
+                    _cqes = (io_uring_cqe *) (_cqRing + params.cq_off.cqes);
+                    _ring = ring;
+                }
+
+                // a slot has at most one read in flight and there are no more slots than queue entries, so the
+                // submission queue can't overflow. 'IORING_OP_READV' with one buffer rather than 'IORING_OP_READ',
+                // which needs linux 5.6 while rings themselves go back to 5.1
+                bool issue(Slot &slot, u32 index) {
+                    u64 chunk = slot.size - slot.done < MAX_READ ? slot.size - slot.done : MAX_READ;
+                    u32 tail = *_sqTail;
+                    u32 entry = tail & _sqMask;
+                    io_uring_sqe *sqe = _sqes + entry;
+                    memset(sqe, 0, sizeof(*sqe));
+                    slot.buffer = iovec { slot.memory + slot.done, chunk };
+                    sqe->opcode = IORING_OP_READV;
+                    sqe->fd = slot.file;
+                    sqe->addr = (u64) &slot.buffer;
+                    sqe->len = 1;
+                    sqe->off = slot.done;
+                    sqe->user_data = index;
+                    _sqArray[entry] = entry;
+                    std::atomic_ref<u32> { *_sqTail }.store(tail + 1, std::memory_order_release);
+                    _unsubmitted += 1;
+                    return true;
+                }
+
+                // 'EAGAIN' and 'EBUSY' pass and are tried again on the next call, any other error means the ring
+                // is unusable: the entries it didn't take are taken back and read synchronously, and the reader
+                // stops using the ring for new files
+                template<typename F>
+                void submit(u32 waitFor, F &onComplete) {
+                    if (_unsubmitted == 0 && waitFor == 0) return;
+                    u32 flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+                    for (;;) {
+                        int result = (int) syscall(__NR_io_uring_enter, _ring, _unsubmitted, waitFor, flags, nullptr, 0);
+                        if (result >= 0) {
+                            _unsubmitted -= (u32) result < _unsubmitted ? (u32) result : _unsubmitted;
+                            return;
+                        }
+                        if (errno == EINTR) continue;
+                        if (errno == EAGAIN || errno == EBUSY) return;
+                        break;
+                    }
+                    _ringFailed = true;
+                    u32 tail = *_sqTail - _unsubmitted;
+                    for (u32 entry = tail; entry != *_sqTail; ++entry) {
+                        Slot &slot = _slots[(u32) _sqes[entry & _sqMask].user_data];
+                        readNow(slot);
+                        _inFlight -= 1;
+                        finish(slot, slot.done == slot.size ? FILE_OK : FILE_READ_FAILED, onComplete);
+                    }
+                    std::atomic_ref<u32> { *_sqTail }.store(tail, std::memory_order_release);
+                    _unsubmitted = 0;
+                }
+
+                template<typename F>
+                void reap(F &onComplete, bool block) {
+                    u32 head = *_cqHead;
+                    if (block && head == std::atomic_ref<u32> { *_cqTail }.load(std::memory_order_acquire)) {
+                        // without 'io_uring_enter' the reads left in the ring are waited for by polling
+                        if (_ringFailed) sched_yield();
+                        else submit(1, onComplete);
+                    }
+                    u32 tail = std::atomic_ref<u32> { *_cqTail }.load(std::memory_order_acquire);
+                    for (; head != tail; ++head) {
+                        io_uring_cqe *cqe = _cqes + (head & _cqMask);
+                        u32 index = (u32) cqe->user_data;
+                        s32 result = cqe->res;
+                        std::atomic_ref<u32> { *_cqHead }.store(head + 1, std::memory_order_release);
+                        Slot &slot = _slots[index];
+                        bool failed = result <= 0;
+                        if (!failed) slot.done += (u64) result;
+                        if (!failed && slot.done < slot.size) {
+                            if (!_ringFailed && issue(slot, index)) continue;
+                            readNow(slot);
+                        }
+                        _inFlight -= 1;
+                        finish(slot, !failed && slot.done == slot.size ? FILE_OK : FILE_READ_FAILED, onComplete);
+                    }
+                    // short reads queued up again
+                    if (!_ringFailed) submit(0, onComplete);
+                }
+
+                int _ring = -1;
+                u8 *_sqRing = nullptr;
+                u8 *_cqRing = nullptr;
+                u64 _sqRingSize = 0;
+                u64 _cqRingSize = 0;
+                u64 _sqesSize = 0;
+                io_uring_sqe *_sqes = nullptr;
+                u32 *_sqTail = nullptr;
+                u32 *_sqArray = nullptr;
+                u32 _sqMask = 0;
+                u32 *_cqHead = nullptr;
+                u32 *_cqTail = nullptr;
+                u32 _cqMask = 0;
+                io_uring_cqe *_cqes = nullptr;
+                u32 _unsubmitted = 0;
+                bool _ringFailed = false;
+            #else
+                bool issue(Slot &slot, u32 index) {
+                    (void) slot, (void) index;
+                    return false;
+                }
+
+                template<typename F>
+                void reap(F &onComplete, bool block) {
+                    (void) onComplete, (void) block;
+                }
+            #endif
+
+            Allocator *_allocator;
+            Array<Request, GlobalAllocator> _requests {GlobalAllocator::instance(), 0ull};
+            Array<Slot, GlobalAllocator> _slots;
+            u64 _next = 0;
+            u64 _completed = 0;
+            u64 _inFlight = 0;
+        };
+
+        enum MapMode : u8 {
+            // the mapping can only be read
+            MAP_READ_ONLY,
+            // the mapping can be written, writes go to private copies of the touched pages and never to the file
+            MAP_COPY_ON_WRITE,
+        };
+
+        // how a mapping is going to be accessed, so the kernel can read ahead (or not)
+        enum AccessHint : u8 {
+            ACCESS_NORMAL,
+            ACCESS_SEQUENTIAL,
+            ACCESS_RANDOM,
+            // start reading the whole range in now
+            ACCESS_WILL_NEED,
+        };
+
+        // owns the views made by 'mapFile', so a mapped 'Block' unmaps itself like any other block frees itself.
+        // it can't allocate anything
+        struct MappedFileAllocator : Allocator {
+            u8 * allocate(u64 size) override {
+                (void) size;
+                return nullptr;
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                (void) memory, (void) oldSize, (void) newSize;
+                return false;
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                if (memory == nullptr || *memory == nullptr) return;
+                #if defined(_WIN32)
+                    (void) size;
+                    UnmapViewOfFile(*memory);
+                #else
+                    munmap(*memory, size);
+                #endif
+                *memory = nullptr;
+            }
+
+            bool canAllocate(u64 size) const override {
+                (void) size;
+                return false;
+            }
+
+            static MappedFileAllocator &instance() {
+                static auto _instance = MappedFileAllocator{};
+                return _instance;
+            }
+        };
+
+        inline void adviseMapping(Block const &mapping, AccessHint hint) {
+            if (!mapping.isValid() || hint == ACCESS_NORMAL) return;
+            #if defined(_WIN32)
+                // windows only takes prefetch requests, its read-ahead isn't tunable per view
+                if (hint == ACCESS_WILL_NEED) {
+                    WIN32_MEMORY_RANGE_ENTRY range { (u8 *) mapping, (SIZE_T) mapping.size() };
+                    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+                }
+            #else
+                int advice = MADV_NORMAL;
+                if (hint == ACCESS_SEQUENTIAL) advice = MADV_SEQUENTIAL;
+                else if (hint == ACCESS_RANDOM) advice = MADV_RANDOM;
+                else if (hint == ACCESS_WILL_NEED) advice = MADV_WILLNEED;
+                madvise((u8 *) mapping, mapping.size(), advice);
+            #endif
+        }
+
+        // maps the whole file at 'path' into memory instead of reading it, pages are loaded from the file (or the
+        // page cache) as they are touched, and nothing is copied. the result is invalid when the file can't be
+        // opened or mapped, including when it is empty, and unmaps itself when destroyed
+        inline Block mapFile(const char *path, MapMode mode = MAP_READ_ONLY, AccessHint hint = ACCESS_NORMAL) {
+            Allocator &allocator = MappedFileAllocator::instance();
+            u8 *memory = nullptr;
+            u64 size = 0;
+            #if defined(_WIN32)
+                HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) return Block { nullptr, 0, allocator };
+                LARGE_INTEGER fileSize {};
+                if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+                    DWORD protection = mode == MAP_COPY_ON_WRITE ? PAGE_WRITECOPY : PAGE_READONLY;
+                    HANDLE mapping = CreateFileMappingA(file, nullptr, protection, 0, 0, nullptr);
+                    if (mapping != nullptr) {
+                        DWORD access = mode == MAP_COPY_ON_WRITE ? FILE_MAP_COPY : FILE_MAP_READ;
+                        memory = (u8 *) MapViewOfFile(mapping, access, 0, 0, 0);
+                        // the view keeps the mapping alive
+                        CloseHandle(mapping);
+                        if (memory) size = (u64) fileSize.QuadPart;
+                    }
+                }
+                CloseHandle(file);
+            #else
+                int file = open(path, O_RDONLY);
+                if (file < 0) return Block { nullptr, 0, allocator };
+                struct stat status {};
+                if (fstat(file, &status) == 0 && status.st_size > 0) {
+                    int protection = mode == MAP_COPY_ON_WRITE ? PROT_READ | PROT_WRITE : PROT_READ;
+                    void *view = mmap(nullptr, (size_t) status.st_size, protection, MAP_PRIVATE, file, 0);
+                    if (view != MAP_FAILED) {
+                        memory = (u8 *) view;
+                        size = (u64) status.st_size;
+                    }
+                }
+                // the mapping keeps the file alive
+                close(file);
+            #endif
+            Block result { memory, size, allocator };
+            adviseMapping(result, hint);
+            return result;
+        }
+
+        // the bytes of a block, e.g. of a mapping
+        inline Slice<u8 const> bytes(Block const &block) {
+            return Slice<u8 const> { (u8 const *) block, block.size() };
+        }
     }
 }
 
@@ -0,0 +1,670 @@
+#if !defined(ACHILLES_HASH_HPP)
+#define ACHILLES_HASH_HPP
+
+// this file depends on <bit> for 'std::countr_zero' and friends
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <new>
+#include <type_traits>
+#include "types.hpp"
+#include "assert.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+
+namespace achilles {
+    namespace hash {
+        // the finalizer of splitmix64, spreads every input bit over the whole word. the tables below take the
+        // probe position from the high bits and the control byte from the low 7, so both need to be good
+        constexpr u64 mix(u64 value) {
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111eb;
+            value ^= value >> 31;
+            return value;
+        }
+
+        // FNV-1a, the same as 'types::typeHash'
+        constexpr u64 fnv1a(char const *data, u64 size) {
+            u64 prime = 0x00000100000001B3;
+            u64 offset = 0xcbf29ce484222325;
+            u64 hash = offset;
+            for (u64 i = 0; i < size; ++i) {
+                hash ^= (u8) data[i];
+                hash *= prime;
+            }
+            return hash;
+        }
+
+        // the default hashers, specialize 'Hash' for your own keys or pass a hasher to the table. hashers are
+        // created on every call, so they must be cheap and stateless
+        template<typename T>
+        struct Hash {
+            static_assert(std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+                          "no default hash for this type, specialize 'achilles::hash::Hash' or pass a hasher");
+
+            u64 operator()(T const &value) const {
+                if constexpr (std::is_pointer_v<T>) return mix((u64) (uintptr_t) value);
+                else return mix((u64) value);
+            }
+        };
+
+        template<typename Tag, typename T, T defaultValue>
+        struct Hash<types::TypeSafeHandle<Tag, T, defaultValue>> {
+            u64 operator()(types::TypeSafeHandle<Tag, T, defaultValue> const &handle) const {
+                return Hash<T>{}((T) handle);
+            }
+        };
+
+        template<>
+        struct Hash<memory::Slice<char const>> {
+            u64 operator()(memory::Slice<char const> const &string) const {
+                return mix(fnv1a((char const *) string, string.size()));
+            }
+        };
+
+        template<>
+        struct Hash<memory::Slice<char>> {
+            u64 operator()(memory::Slice<char> const &string) const {
+                return mix(fnv1a((char const *) string, string.size()));
+            }
+        };
+
+        // null-terminated strings hash and compare by their contents, not their address
+        template<>
+        struct Hash<char const *> {
+            u64 operator()(char const *string) const {
+                return mix(fnv1a(string, strlen(string)));
+            }
+        };
+
+        template<typename T>
+        struct Equal {
+            bool operator()(T const &a, T const &b) const {
+                return a == b;
+            }
+        };
+
+        template<>
+        struct Equal<char const *> {
+            bool operator()(char const *a, char const *b) const {
+                return strcmp(a, b) == 0;
+            }
+        };
+
+        // a group of control bytes that is matched at once, with SSE2/AVX2/NEON when available. masks have lanes of
+        // 'BITS' bits with only the lowest set for a match, so they can be walked with 'std::countr_zero'
+        struct Group {
+            #if ACHILLES_SIMD
+                static constexpr u64 WIDTH = simd::Native::BYTES;
+                static constexpr u64 BITS = simd::Native::BITS_PER_BYTE;
+            #else
+                static constexpr u64 WIDTH = 8;
+                static constexpr u64 BITS = 1;
+            #endif
+
+            static u64 match(u8 const *control, u8 byte) {
+                #if ACHILLES_SIMD
+                    u64 mask = simd::Native::equalMask<u8>(simd::Native::load(control), simd::broadcast<u8>(byte));
+                    if constexpr (BITS == 1) return mask;
+                    else return mask & (U64_MAX / ((1ULL << BITS) - 1));
+                #else
+                    u64 mask = 0;
+                    for (u64 i = 0; i < WIDTH; ++i) {
+                        if (control[i] == byte) mask |= 1ULL << i;
+                    }
+                    return mask;
+                #endif
+            }
+
+            static u64 first(u64 mask) {
+                return std::countr_zero(mask) / BITS;
+            }
+
+            // how many lanes at the top of the group are unset
+            static u64 leadingClear(u64 mask) {
+                return (std::countl_zero(mask) - (64 - WIDTH * BITS)) / BITS;
+            }
+
+            static u64 next(u64 mask) {
+                return mask & (mask - 1);
+            }
+        };
+
+        // the storage behind 'HashMap' and 'HashSet', an open-addressing table in the style of SwissTable: one
+        // control byte per slot (empty, deleted, or the low 7 bits of the element's hash), probed a 'Group' at a
+        // time so a lookup usually touches one group of control bytes and one slot. slots and control bytes live
+        // in one block from 'A', slots first, so growth that the allocator can do in place ('tryResize') rehashes
+        // in place, without a second allocation or a copy. 'E' is the stored element, 'K' the part of it that is
+        // hashed, either 'E' itself or its 'key' member
+        template<typename K, typename E, typename A, typename H, typename Q>
+        struct HashTable {
+            using Traits = memory::AllocatorTraits<A>;
+
+            static constexpr u8 EMPTY = 0x80;
+            static constexpr u8 DELETED = 0xFE;
+
+            // set elements are their own keys, so they can't be changed in place
+            using Element = std::conditional_t<std::is_same_v<E, K>, E const, E>;
+
+            struct Iterator {
+                Element &operator*() const {
+                    return table->slots()[index];
+                }
+
+                Element *operator->() const {
+                    return table->slots() + index;
+                }
+
+                Iterator &operator++() {
+                    index = table->nextFull(index + 1);
+                    return *this;
+                }
+
+                bool operator==(Iterator const &other) const {
+                    return index == other.index;
+                }
+
+                bool operator!=(Iterator const &other) const {
+                    return index != other.index;
+                }
+
+                HashTable const *table;
+                u64 index;
+            };
+
+            // a 'capacity' of zero allocates nothing until the first insert
+            HashTable(A &allocator = memory::AllocatorHandle<A>::defaultInstance(), u64 capacity = 0)
+                : _block{nullptr, 0, allocator} {
+                if (capacity > 0) reserve(capacity);
+            }
+
+            HashTable(HashTable &&other)
+                : _block{std::move(other._block)},
+                  _capacity{other._capacity},
+                  _size{other._size},
+                  _growthLeft{other._growthLeft}
+            {
+                other.invalidate();
+            }
+
+            HashTable &operator=(HashTable &&other) {
+                if (this == &other) return *this;
+                destroyAll();
+                _block = std::move(other._block);
+                _capacity = other._capacity;
+                _size = other._size;
+                _growthLeft = other._growthLeft;
+                other.invalidate();
+                return *this;
+            }
+
+            HashTable(HashTable const &other) = delete;
+            HashTable &operator=(HashTable const &other) = delete;
+
+            ~HashTable() {
+                destroyAll();
+            }
+
+            u64 size() const {
+                return _size;
+            }
+
+            // the number of slots, elements fit until the table is 7/8 full
+            u64 capacity() const {
+                return _capacity;
+            }
+
+            bool isEmpty() const {
+                return _size == 0;
+            }
+
+            // makes room for 'count' elements without growing again
+            bool reserve(u64 count) {
+                u64 required = capacityFor(count);
+                if (required <= _capacity) return true;
+                return resize(required);
+            }
+
+            // destroys every element, keeping the storage
+            void clear() {
+                if (_capacity == 0) return;
+                destroyElements();
+                memset(control(), EMPTY, _capacity + Group::WIDTH);
+                _size = 0;
+                _growthLeft = growthFor(_capacity);
+            }
+
+            E *find(K const &key) const {
+                u64 index = indexOf(key);
+                return index == U64_MAX ? nullptr : slots() + index;
+            }
+
+            bool contains(K const &key) const {
+                return indexOf(key) != U64_MAX;
+            }
+
+            // the slot for 'key', when it's not in the table yet 'inserted' is set, and the caller has to construct
+            // the element in the returned slot before touching the table again. null only when the allocator ran out
+            E *findOrPrepare(K const &key, bool &inserted) {
+                u64 hash = H{}(key);
+                u64 index = indexOf(key, hash);
+                inserted = false;
+                if (index != U64_MAX) return slots() + index;
+                if (_capacity == 0 && !makeRoom()) return nullptr;
+                index = firstFree(hash);
+                if (_growthLeft == 0 && control()[index] != DELETED) {
+                    if (!makeRoom()) return nullptr;
+                    index = firstFree(hash);
+                }
+                if (control()[index] == EMPTY) _growthLeft -= 1;
+                setControl(index, fingerprint(hash));
+                _size += 1;
+                inserted = true;
+                return slots() + index;
+            }
+
+            bool remove(K const &key) {
+                u64 index = indexOf(key);
+                if (index == U64_MAX) return false;
+                erase(index);
+                return true;
+            }
+
+            Iterator begin() const {
+                return Iterator { this, nextFull(0) };
+            }
+
+            Iterator end() const {
+                return Iterator { this, _capacity };
+            }
+        private:
+            static K const &keyOf(E const &element) {
+                if constexpr (std::is_same_v<E, K>) return element;
+                else return element.key;
+            }
+
+            static u8 fingerprint(u64 hash) {
+                return (u8) (hash & 0x7F);
+            }
+
+            static u64 growthFor(u64 capacity) {
+                return capacity - capacity / 8;
+            }
+
+            // the smallest power-of-two capacity, at least a group, that holds 'count' elements under the load limit
+            static u64 capacityFor(u64 count) {
+                if (count == 0) return 0;
+                u64 slots = count + (count + 6) / 7;
+                if (slots < Group::WIDTH) slots = Group::WIDTH;
+                return std::bit_ceil(slots);
+            }
+
+            static u64 bytesFor(u64 capacity) {
+                return capacity * sizeof(E) + capacity + Group::WIDTH;
+            }
+
+            E *slots() const {
+                return (E *) _block;
+            }
+
+            // the control bytes, followed by a copy of the first group so a group can be loaded from any slot
+            u8 *control() const {
+                return ((u8 *) _block) + _capacity * sizeof(E);
+            }
+
+            void setControl(u64 index, u8 value) {
+                u8 *bytes = control();
+                bytes[index] = value;
+                if (index < Group::WIDTH) bytes[_capacity + index] = value;
+            }
+
+            // the probe sequence visits every group once: groups start 'WIDTH', '2 * WIDTH', ... slots after the
+            // previous one, which for a power-of-two capacity covers the whole table
+            u64 indexOf(K const &key) const {
+                return indexOf(key, H{}(key));
+            }
+
+            u64 indexOf(K const &key, u64 hash) const {
+                if (_size == 0) return U64_MAX;
+                u64 mask = _capacity - 1;
+                u8 byte = fingerprint(hash);
+                u8 const *bytes = control();
+                E const *elements = slots();
+                u64 position = (hash >> 7) & mask;
+                for (u64 step = Group::WIDTH; ; step += Group::WIDTH) {
+                    for (u64 match = Group::match(bytes + position, byte); match; match = Group::next(match)) {
+                        u64 index = (position + Group::first(match)) & mask;
+                        if (Q{}(keyOf(elements[index]), key)) return index;
+                    }
+                    if (Group::match(bytes + position, EMPTY)) return U64_MAX;
+                    position = (position + step) & mask;
+                }
+            }
+
+            // the first empty or deleted slot on the probe sequence of 'hash', the load limit guarantees one
+            u64 firstFree(u64 hash) const {
+                u64 mask = _capacity - 1;
+                u8 const *bytes = control();
+                u64 position = (hash >> 7) & mask;
+                for (u64 step = Group::WIDTH; ; step += Group::WIDTH) {
+                    u64 match = Group::match(bytes + position, EMPTY) | Group::match(bytes + position, DELETED);
+                    if (match) return (position + Group::first(match)) & mask;
+                    position = (position + step) & mask;
+                }
+            }
+
+            u64 nextFull(u64 index) const {
+                u8 const *bytes = control();
+                while (index < _capacity && (bytes[index] & 0x80)) index += 1;
+                return index;
+            }
+
+            // a slot can go back to empty, rather than deleted, when no group-sized window around it was ever full,
+            // since then no probe sequence ever stepped over it
+            void erase(u64 index) {
+                E *slot = slots() + index;
+                slot->~E();
+                _size -= 1;
+                u8 const *bytes = control();
+                u64 after = Group::match(bytes + index, EMPTY);
+                u64 before = Group::match(bytes + ((index - Group::WIDTH) & (_capacity - 1)), EMPTY);
+                if (after && before && Group::first(after) + Group::leadingClear(before) < Group::WIDTH) {
+                    setControl(index, EMPTY);
+                    _growthLeft += 1;
+                } else {
+                    setControl(index, DELETED);
+                }
+            }
+
+            // out of room, either because the table is full or because deleted slots pile up. the latter only
+            // needs a rehash in place
+            bool makeRoom() {
+                if (_capacity > 0 && _size <= growthFor(_capacity) / 2) {
+                    rehashInPlace(_capacity);
+                    return true;
+                }
+                return resize(_capacity == 0 ? Group::WIDTH : _capacity * 2);
+            }
+
+            bool resize(u64 newCapacity) {
+                u64 newBytes = bytesFor(newCapacity);
+                if (_capacity > 0) {
+                    // 'tryResize' may move the block with a plain copy, which only relocatable elements survive
+                    if constexpr (memory::is_trivially_relocatable_v<E>) {
+                        if (resizeStorage(newBytes)) {
+                            u8 *memory = (u8 *) _block;
+                            u64 oldCapacity = _capacity;
+                            memmove(memory + newCapacity * sizeof(E), memory + oldCapacity * sizeof(E), oldCapacity);
+                            _capacity = newCapacity;
+                            rehashInPlace(oldCapacity);
+                            return true;
+                        }
+                    }
+                }
+                A &allocator = _block.allocator();
+                u8 *memory = allocateStorage(allocator, newBytes);
+                if (memory == nullptr) return false;
+                memory::BasicBlock<A> old = std::move(_block);
+                u64 oldCapacity = _capacity;
+                _block = memory::BasicBlock<A> { memory, newBytes, allocator };
+                _capacity = newCapacity;
+                memset(control(), EMPTY, newCapacity + Group::WIDTH);
+                _growthLeft = growthFor(newCapacity) - _size;
+                if (oldCapacity == 0) return true;
+                E *source = (E *) old;
+                u8 const *sourceControl = ((u8 *) old) + oldCapacity * sizeof(E);
+                for (u64 i = 0; i < oldCapacity; ++i) {
+                    if (sourceControl[i] & 0x80) continue;
+                    u64 hash = H{}(keyOf(source[i]));
+                    u64 index = firstFree(hash);
+                    relocate(slots() + index, source + i);
+                    setControl(index, fingerprint(hash));
+                }
+                return true;
+            }
+
+            // re-places the elements of the first 'count' slots, used to clear out deleted slots and after the
+            // storage grew in place. elements to place are marked deleted, every other slot becomes empty, then
+            // each marked element either stays (when it's already in the first group it would probe) or moves to
+            // the first free slot of its probe sequence, swapping with a marked element that's in the way
+            void rehashInPlace(u64 count) {
+                u8 *bytes = control();
+                for (u64 i = 0; i < _capacity; ++i) {
+                    bytes[i] = (i < count && !(bytes[i] & 0x80)) ? DELETED : EMPTY;
+                }
+                memcpy(bytes + _capacity, bytes, Group::WIDTH);
+                u64 mask = _capacity - 1;
+                E *elements = slots();
+                for (u64 i = 0; i < count; ) {
+                    if (bytes[i] != DELETED) {
+                        i += 1;
+                        continue;
+                    }
+                    u64 hash = H{}(keyOf(elements[i]));
+                    u64 start = (hash >> 7) & mask;
+                    u64 target = firstFree(hash);
+                    if (((target - start) & mask) / Group::WIDTH == ((i - start) & mask) / Group::WIDTH) {
+                        setControl(i, fingerprint(hash));
+                        i += 1;
+                    } else if (bytes[target] == EMPTY) {
+                        relocate(elements + target, elements + i);
+                        setControl(target, fingerprint(hash));
+                        setControl(i, EMPTY);
+                        i += 1;
+                    } else {
+                        // 'target' holds another element still to be placed, swap and place that one next
+                        alignas(E) u8 temp[sizeof(E)];
+                        relocate((E *) temp, elements + target);
+                        relocate(elements + target, elements + i);
+                        relocate(elements + i, (E *) temp);
+                        setControl(target, fingerprint(hash));
+                    }
+                }
+                _growthLeft = growthFor(_capacity) - _size;
+            }
+
+            static void relocate(E *destination, E *source) {
+                if constexpr (memory::is_trivially_relocatable_v<E>) {
+                    memcpy((void *) destination, (void *) source, sizeof(E));
+                } else {
+                    new (destination) E(std::move(*source));
+                    source->~E();
+                }
+            }
+
+            void destroyElements() {
+                if constexpr (!std::is_trivially_destructible_v<E>) {
+                    u8 const *bytes = control();
+                    E *elements = slots();
+                    for (u64 i = 0; i < _capacity; ++i) {
+                        if (!(bytes[i] & 0x80)) elements[i].~E();
+                    }
+                }
+            }
+
+            void destroyAll() {
+                if (_capacity > 0) destroyElements();
+                _block = memory::BasicBlock<A> { nullptr, 0, _block.allocator() };
+                _capacity = 0;
+                _size = 0;
+                _growthLeft = 0;
+            }
+
+            void invalidate() {
+                _capacity = 0;
+                _size = 0;
+                _growthLeft = 0;
+            }
+
+            static u8 *allocateStorage(A &allocator, u64 size) {
+                if constexpr (alignof(E) <= memory::DEFAULT_ALIGNMENT) return Traits::allocate(allocator, size);
+                else return Traits::allocateAligned(allocator, size, alignof(E));
+            }
+
+            bool resizeStorage(u64 newSize) {
+                if constexpr (alignof(E) <= memory::DEFAULT_ALIGNMENT) return _block.tryResize(newSize);
+                else return _block.tryResize(newSize, alignof(E));
+            }
+
+            memory::BasicBlock<A> _block;
+            u64 _capacity = 0;
+            u64 _size = 0;
+            u64 _growthLeft = 0;
+        };
+
+        template<typename K, typename V>
+        struct Entry {
+            K key;
+            V value;
+        };
+    }
+
+    namespace memory {
+        template<typename K, typename V>
+        struct is_trivially_relocatable<hash::Entry<K, V>>
+            : std::bool_constant<is_trivially_relocatable_v<K> && is_trivially_relocatable_v<V>> {};
+    }
+
+    namespace hash {
+        // a flat hash map, entries are stored inline in the table so there is no allocation per entry. pointers
+        // to entries are invalidated by any insert that grows the table
+        template<typename K, typename V, typename A = memory::Allocator, typename H = Hash<K>, typename Q = Equal<K>>
+        struct HashMap {
+            using Table = HashTable<K, Entry<K, V>, A, H, Q>;
+            using Iterator = typename Table::Iterator;
+
+            HashMap(A &allocator = memory::AllocatorHandle<A>::defaultInstance(), u64 capacity = 0) : _table{allocator, capacity} {}
+
+            explicit HashMap(u64 capacity) requires memory::AllocatorHandle<A>::STATELESS : _table{A::instance(), capacity} {}
+
+            u64 size() const {
+                return _table.size();
+            }
+
+            u64 capacity() const {
+                return _table.capacity();
+            }
+
+            bool isEmpty() const {
+                return _table.isEmpty();
+            }
+
+            bool reserve(u64 count) {
+                return _table.reserve(count);
+            }
+
+            void clear() {
+                _table.clear();
+            }
+
+            // sets the value for 'key', returns it, or null if the allocator ran out
+            V *insert(K const &key, V value) {
+                bool inserted = false;
+                Entry<K, V> *entry = _table.findOrPrepare(key, inserted);
+                if (entry == nullptr) return nullptr;
+                if (inserted) new (entry) Entry<K, V> { key, std::move(value) };
+                else entry->value = std::move(value);
+                return &entry->value;
+            }
+
+            // returns the value for 'key', constructing one from 'args' only when there is none yet
+            template<typename... Args>
+            V *emplace(K const &key, Args &&...args) {
+                bool inserted = false;
+                Entry<K, V> *entry = _table.findOrPrepare(key, inserted);
+                if (entry == nullptr) return nullptr;
+                if (inserted) {
+                    new (&entry->key) K(key);
+                    new (&entry->value) V { std::forward<Args>(args)... };
+                }
+                return &entry->value;
+            }
+
+            // null when 'key' isn't in the map
+            V *get(K const &key) const {
+                Entry<K, V> *entry = _table.find(key);
+                return entry ? &entry->value : nullptr;
+            }
+
+            bool contains(K const &key) const {
+                return _table.contains(key);
+            }
+
+            bool remove(K const &key) {
+                return _table.remove(key);
+            }
+
+            Iterator begin() const {
+                return _table.begin();
+            }
+
+            Iterator end() const {
+                return _table.end();
+            }
+        private:
+            Table _table;
+        };
+
+        template<typename K, typename A = memory::Allocator, typename H = Hash<K>, typename Q = Equal<K>>
+        struct HashSet {
+            using Table = HashTable<K, K, A, H, Q>;
+            using Iterator = typename Table::Iterator;
+
+            HashSet(A &allocator = memory::AllocatorHandle<A>::defaultInstance(), u64 capacity = 0) : _table{allocator, capacity} {}
+
+            explicit HashSet(u64 capacity) requires memory::AllocatorHandle<A>::STATELESS : _table{A::instance(), capacity} {}
+
+            u64 size() const {
+                return _table.size();
+            }
+
+            u64 capacity() const {
+                return _table.capacity();
+            }
+
+            bool isEmpty() const {
+                return _table.isEmpty();
+            }
+
+            bool reserve(u64 count) {
+                return _table.reserve(count);
+            }
+
+            void clear() {
+                _table.clear();
+            }
+
+            // false when 'key' was already there, or the allocator ran out
+            bool insert(K const &key) {
+                bool inserted = false;
+                K *slot = _table.findOrPrepare(key, inserted);
+                if (slot == nullptr || !inserted) return false;
+                new (slot) K(key);
+                return true;
+            }
+
+            bool contains(K const &key) const {
+                return _table.contains(key);
+            }
+
+            bool remove(K const &key) {
+                return _table.remove(key);
+            }
+
+            Iterator begin() const {
+                return _table.begin();
+            }
+
+            Iterator end() const {
+                return _table.end();
+            }
+        private:
+            Table _table;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,333 @@
+#if !defined(ACHILLES_JOBS_HPP)
+#define ACHILLES_JOBS_HPP
+
+// this file depends on <thread> for the workers, link with '-pthread' where needed
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <new>
+#include <type_traits>
+#include "types.hpp"
+#include "assert.hpp"
+#include "memory.hpp"
+#include "queue.hpp"
+
+namespace achilles {
+    namespace jobs {
+        // counts the jobs submitted against it that haven't finished yet, see 'JobSystem::wait'
+        struct Counter {
+            std::atomic<u64> pending {0};
+
+            bool isDone() const {
+                return pending.load(std::memory_order_acquire) == 0;
+            }
+        };
+
+        // a job is one cache line: the function that runs it, its counter, and the callable stored inline. aligned to
+        // the line, so jobs run by different workers never share one
+        struct alignas(CACHE_LINE_SIZE) Job {
+            static constexpr u64 PAYLOAD_SIZE = 48;
+
+            void (*invoke)(Job *job);
+            Counter *counter;
+            alignas(memory::DEFAULT_ALIGNMENT) u8 payload[PAYLOAD_SIZE];
+        };
+
+        // a Chase-Lev work-stealing deque of fixed capacity, in the formulation of Lê et al. (2013): the owning
+        // worker pushes and pops at the bottom, any other thread steals from the top. elements are published
+        // through the release store of 'bottom', which thieves acquire
+        template<u64 Capacity>
+        struct WorkStealingDeque {
+            static_assert(memory::isPowerOfTwo(Capacity), "deque capacity must be a power of two");
+
+            // owner only, false when the deque is full
+            bool push(Job *job) {
+                s64 bottom = _bottom->load(std::memory_order_relaxed);
+                s64 top = _top->load(std::memory_order_acquire);
+                if (bottom - top >= (s64) Capacity) return false;
+                _jobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+                _bottom->store(bottom + 1, std::memory_order_release);
+                return true;
+            }
+
+            // owner only, takes the most recently pushed job
+            Job *pop() {
+                s64 bottom = _bottom->load(std::memory_order_relaxed) - 1;
+                _bottom->store(bottom, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                s64 top = _top->load(std::memory_order_relaxed);
+                if (top > bottom) {
+                    _bottom->store(bottom + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                Job *job = _jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+                if (top == bottom) {
+                    // the last job, race the thieves for it
+                    if (!_top->compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+                    _bottom->store(bottom + 1, std::memory_order_relaxed);
+                }
+                return job;
+            }
+
+            // any thread, takes the oldest job, null when empty or when it lost a race
+            Job *steal() {
+                s64 top = _top->load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                s64 bottom = _bottom->load(std::memory_order_acquire);
+                if (top >= bottom) return nullptr;
+                Job *job = _jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+                if (!_top->compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+                return job;
+            }
+
+            bool isEmpty() const {
+                return _bottom->load(std::memory_order_acquire) <= _top->load(std::memory_order_acquire);
+            }
+        private:
+            memory::CacheAligned<std::atomic<s64>> _top {};
+            memory::CacheAligned<std::atomic<s64>> _bottom {};
+            std::atomic<Job *> _jobs[Capacity] {};
+        };
+
+        // a work-stealing thread pool. the thread that creates it is worker 0 and does its share while it waits
+        // on a counter, the other workers are threads of their own. jobs submitted from a worker go to the bottom
+        // of its deque, so it runs them depth first while idle workers steal the oldest (and usually biggest) ones.
+        // jobs submitted from any other thread go through a shared queue. jobs come from a thread-caching pool,
+        // so submitting never calls 'malloc' once the pool is warm
+        struct JobSystem {
+            static constexpr u64 DEQUE_CAPACITY = 4096;
+            static constexpr u64 INJECTED_CAPACITY = 1024;
+
+            // 'threads' counts the calling thread, zero picks one per hardware thread
+            explicit JobSystem(u32 threads = 0, memory::Allocator &allocator = memory::GlobalAllocator::instance())
+                : _allocator{&allocator},
+                  _pool{allocator},
+                  _injected{allocator, INJECTED_CAPACITY} {
+                if (threads == 0) threads = std::thread::hardware_concurrency();
+                if (threads == 0) threads = 1;
+                u64 size = threads * sizeof(Worker);
+                u8 *memory = allocator.allocateAligned(size, alignof(Worker));
+                aassert(memory != nullptr, "failed to allocate job system workers");
+                _workers = (Worker *) memory;
+                _workerCount = threads;
+                for (u32 i = 0; i < threads; ++i) {
+                    new (_workers + i) Worker {};
+                    _workers[i].random = 0x9E3779B97F4A7C15ULL * (i + 1);
+                }
+                current() = Current { this, _workers };
+                for (u32 i = 1; i < threads; ++i) {
+                    _workers[i].thread = std::thread { [this, i] { work(_workers + i); } };
+                }
+            }
+
+            JobSystem(JobSystem const &other) = delete;
+            JobSystem &operator =(JobSystem const &other) = delete;
+
+            // every counter must have been waited on before the system goes away
+            ~JobSystem() {
+                _running.store(false, std::memory_order_release);
+                wake(true);
+                for (u32 i = 1; i < _workerCount; ++i) {
+                    _workers[i].thread.join();
+                }
+                for (u32 i = 0; i < _workerCount; ++i) {
+                    _workers[i].~Worker();
+                }
+                u8 *memory = (u8 *) _workers;
+                _allocator->deallocate(&memory, _workerCount * sizeof(Worker));
+                if (current().system == this) current() = Current {};
+            }
+
+            u32 workerCount() const {
+                return _workerCount;
+            }
+
+            // runs 'function' on some worker, counted against 'counter'. the callable is stored inline in the job,
+            // so it has to fit in 'Job::PAYLOAD_SIZE' bytes, capture big things by reference. when the deque or
+            // the pool are exhausted the job runs right away on the calling thread
+            template<typename F>
+            void submit(F &&function, Counter &counter) {
+                using Function = std::decay_t<F>;
+                static_assert(sizeof(Function) <= Job::PAYLOAD_SIZE, "job callable too large, capture by reference");
+                static_assert(alignof(Function) <= memory::DEFAULT_ALIGNMENT, "job callable over-aligned");
+
+                Job *job = (Job *) _pool.allocateAligned(sizeof(Job), alignof(Job));
+                if (job == nullptr) {
+                    function();
+                    return;
+                }
+                new (job->payload) Function(std::forward<F>(function));
+                job->invoke = [](Job *self) {
+                    Function *function = (Function *) self->payload;
+                    (*function)();
+                    function->~Function();
+                };
+                job->counter = &counter;
+                counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+                Worker *worker = localWorker();
+                bool queued = worker ? worker->jobs.push(job) : _injected.push(job);
+                if (!queued) {
+                    execute(job);
+                    return;
+                }
+                wake(false);
+            }
+
+            // runs jobs until every job counted against 'counter' has finished
+            void wait(Counter &counter) {
+                Worker *worker = localWorker();
+                u32 idle = 0;
+                while (!counter.isDone()) {
+                    Job *job = findJob(worker);
+                    if (job) {
+                        execute(job);
+                        idle = 0;
+                    } else if (++idle > SPINS) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        private:
+            static constexpr u32 SPINS = 64;
+
+            struct Worker {
+                WorkStealingDeque<DEQUE_CAPACITY> jobs;
+                std::thread thread;
+                u64 random = 0;
+            };
+
+            struct Current {
+                JobSystem *system = nullptr;
+                Worker *worker = nullptr;
+            };
+
+            static Current &current() {
+                thread_local Current _current {};
+                return _current;
+            }
+
+            Worker *localWorker() const {
+                Current &local = current();
+                return local.system == this ? local.worker : nullptr;
+            }
+
+            void work(Worker *worker) {
+                current() = Current { this, worker };
+                u32 idle = 0;
+                while (_running.load(std::memory_order_acquire)) {
+                    Job *job = findJob(worker);
+                    if (job) {
+                        execute(job);
+                        idle = 0;
+                        continue;
+                    }
+                    if (++idle <= SPINS) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    // announce the sleep before the last look for work, 'wake' checks '_sleepers' after queueing
+                    // its job, so one of the two always sees the other
+                    _sleepers.fetch_add(1, std::memory_order_seq_cst);
+                    u32 epoch = _epoch.load(std::memory_order_seq_cst);
+                    job = findJob(worker);
+                    if (job == nullptr && _running.load(std::memory_order_acquire)) {
+                        _epoch.wait(epoch, std::memory_order_seq_cst);
+                    }
+                    _sleepers.fetch_sub(1, std::memory_order_relaxed);
+                    if (job) execute(job);
+                    idle = 0;
+                }
+            }
+
+            void wake(bool all) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!all && _sleepers.load(std::memory_order_seq_cst) == 0) return;
+                _epoch.fetch_add(1, std::memory_order_seq_cst);
+                if (all) _epoch.notify_all();
+                else _epoch.notify_one();
+            }
+
+            // the worker's own deque first, then the shared queue, then steal from the others starting at a
+            // random one
+            Job *findJob(Worker *worker) {
+                Job *job = nullptr;
+                if (worker && (job = worker->jobs.pop())) return job;
+                if (_injected.pop(job)) return job;
+                u64 start = worker ? nextRandom(worker) : 0;
+                for (u32 i = 0; i < _workerCount; ++i) {
+                    Worker *victim = _workers + (start + i) % _workerCount;
+                    if (victim == worker) continue;
+                    if ((job = victim->jobs.steal())) return job;
+                }
+                return nullptr;
+            }
+
+            void execute(Job *job) {
+                job->invoke(job);
+                Counter *counter = job->counter;
+                u8 *memory = (u8 *) job;
+                _pool.deallocate(&memory, sizeof(Job));
+                counter->pending.fetch_sub(1, std::memory_order_release);
+            }
+
+            static u64 nextRandom(Worker *worker) {
+                u64 x = worker->random;
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                worker->random = x;
+                return x;
+            }
+
+            memory::Allocator *_allocator;
+            // 'sizeof(Job)' slots, which the pool lines up with cache lines
+            memory::ThreadCachePool<sizeof(Job), 256> _pool;
+            queue::MpmcQueue<Job *> _injected;
+            Worker *_workers = nullptr;
+            u32 _workerCount = 0;
+            std::atomic<bool> _running {true};
+            std::atomic<u32> _sleepers {0};
+            std::atomic<u32> _epoch {0};
+        };
+
+        template<typename T, typename F>
+        struct ParallelFor {
+            JobSystem *jobs;
+            Counter *counter;
+            T *items;
+            F *function;
+            u64 grainSize;
+
+            // splits off the upper half as a job until the range is down to a grain, so thieves take big halves
+            void run(u64 low, u64 high) const {
+                while (high - low > grainSize) {
+                    u64 middle = low + (high - low) / 2;
+                    ParallelFor const *self = this;
+                    jobs->submit([self, middle, high] { self->run(middle, high); }, *counter);
+                    high = middle;
+                }
+                if constexpr (std::is_invocable_v<F &, memory::Slice<T>>) {
+                    (*function)(memory::Slice<T> { items + low, high - low });
+                } else {
+                    for (u64 i = low; i < high; ++i) {
+                        (*function)(items[i]);
+                    }
+                }
+            }
+        };
+
+        // calls 'function' on every element of 'items', or on sub-slices of them when it takes a 'Slice<T>',
+        // spread over the workers in pieces of about 'grainSize' elements. returns once all of them are done
+        template<typename T, typename F>
+        void parallelFor(JobSystem &jobs, memory::Slice<T> items, u64 grainSize, F &&function) {
+            if (items.size() == 0) return;
+            Counter counter;
+            ParallelFor<T, std::remove_reference_t<F>> range { &jobs, &counter, (T *) items, &function, grainSize > 0 ? grainSize : 1 };
+            range.run(0, items.size());
+            jobs.wait(counter);
+        }
+    }
+}
+
+#endif
@@ -3,7 +3,10 @@
 
 // this file depends on <cmath> for 'sqrt'
 #include <cmath>
+#include <type_traits>
 #include "types.hpp"
+#include "simd.hpp"
+#include "memory.hpp"
 
 #undef min
 #undef max
@@ -21,6 +24,9 @@ namespace achilles {
         constexpr f32 E          = 2.718281828459f;
         constexpr f32 EPSILON    = 0.000001f;
 
+        // above this cosine 'quaternion::slerp' falls back to a normalized lerp
+        constexpr f32 SLERP_THRESHOLD = 0.9995f;
+
         inline f32 fisqrt(f32 n) {
             union {
                 f32 f;
@@ -116,11 +122,734 @@ namespace achilles {
             return n;
         }
 
+        // float4 and quaternion math runs on SSE or NEON registers when the compiler targets one, define
+        // 'ACHILLES_SCALAR_MATH' (or 'ACHILLES_NO_SIMD') to keep it scalar. constant evaluation always takes the
+        // scalar code. the vector code does the same operations in the same order, so both give the same bits
+        // as long as the compiler doesn't contract the scalar code into FMAs (e.g. '-ffp-contract=off')
+        #if !defined(ACHILLES_SCALAR_MATH) && (defined(ACHILLES_SSE2) || defined(ACHILLES_NEON))
+            #define ACHILLES_SIMD_MATH 1
+        #else
+            #define ACHILLES_SIMD_MATH 0
+        #endif
+
+        #if ACHILLES_SIMD_MATH
+            // four lanes of f32 and the few operations the vector types need
+            namespace vec4 {
+                #if defined(ACHILLES_SSE2)
+                    using Register = __m128;
+
+                    inline Register load(f32 const *values) { return _mm_load_ps(values); }
+                    inline void store(f32 *values, Register r) { _mm_store_ps(values, r); }
+                    inline Register loadUnaligned(f32 const *values) { return _mm_loadu_ps(values); }
+                    inline void storeUnaligned(f32 *values, Register r) { _mm_storeu_ps(values, r); }
+                    inline Register set(f32 x, f32 y, f32 z, f32 w) { return _mm_setr_ps(x, y, z, w); }
+                    inline Register splat(f32 value) { return _mm_set1_ps(value); }
+                    inline Register add(Register a, Register b) { return _mm_add_ps(a, b); }
+                    inline Register sub(Register a, Register b) { return _mm_sub_ps(a, b); }
+                    inline Register mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+                    inline Register div(Register a, Register b) { return _mm_div_ps(a, b); }
+                    inline f32 first(Register r) { return _mm_cvtss_f32(r); }
+
+                    // a * b + c, fused when the target has FMA, which can change the last bit against the scalar code
+                    inline Register mulAdd(Register a, Register b, Register c) {
+                        #if defined(__FMA__)
+                            return _mm_fmadd_ps(a, b, c);
+                        #else
+                            return _mm_add_ps(_mm_mul_ps(a, b), c);
+                        #endif
+                    }
+
+                    // four float3s from twelve floats, one register per component
+                    inline void load3(f32 const *values, Register &x, Register &y, Register &z) {
+                        Register a = _mm_loadu_ps(values);
+                        Register b = _mm_loadu_ps(values + 4);
+                        Register c = _mm_loadu_ps(values + 8);
+                        x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+                        y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+                        z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+                    }
+
+                    inline void transpose(Register &x, Register &y, Register &z, Register &w) {
+                        _MM_TRANSPOSE4_PS(x, y, z, w);
+                    }
+
+                    // all bits set in the lanes where a comparison holds
+                    using Mask = __m128;
+
+                    inline Mask less(Register a, Register b) { return _mm_cmplt_ps(a, b); }
+
+                    // the lanes of 'a' where 'mask' is set, of 'b' elsewhere
+                    inline Register select(Mask mask, Register a, Register b) {
+                        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+                    }
+
+                    // flips the sign of the lanes of 'value' where 'sign' is negative
+                    inline Register flipIfNegative(Register value, Register sign) {
+                        Register negative = _mm_cmplt_ps(sign, _mm_setzero_ps());
+                        return _mm_xor_ps(value, _mm_and_ps(negative, _mm_set1_ps(-0.0f)));
+                    }
+
+                    // four float4s, also from aligned memory
+                    inline void load4(f32 const *values, Register &x, Register &y, Register &z, Register &w) {
+                        x = _mm_load_ps(values);
+                        y = _mm_load_ps(values + 4);
+                        z = _mm_load_ps(values + 8);
+                        w = _mm_load_ps(values + 12);
+                        _MM_TRANSPOSE4_PS(x, y, z, w);
+                    }
+
+                    inline void store4(f32 *values, Register x, Register y, Register z, Register w) {
+                        _MM_TRANSPOSE4_PS(x, y, z, w);
+                        _mm_store_ps(values, x);
+                        _mm_store_ps(values + 4, y);
+                        _mm_store_ps(values + 8, z);
+                        _mm_store_ps(values + 12, w);
+                    }
+
+                    // the other way around
+                    inline void store3(f32 *values, Register x, Register y, Register z) {
+                        Register a = _mm_shuffle_ps(_mm_unpacklo_ps(x, y), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0));
+                        Register b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+                        Register c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+                        _mm_storeu_ps(values, a);
+                        _mm_storeu_ps(values + 4, b);
+                        _mm_storeu_ps(values + 8, c);
+                    }
+
+                    // lane i of the result is lane 'I' of 'r'
+                    template<int X, int Y, int Z, int W>
+                    inline Register permute(Register r) {
+                        return _mm_shuffle_ps(r, r, _MM_SHUFFLE(W, Z, Y, X));
+                    }
+
+                    // flips the sign of the lanes set in the mask
+                    template<int X, int Y, int Z, int W>
+                    inline Register negate(Register r) {
+                        return _mm_xor_ps(r, _mm_setr_ps(X ? -0.0f : 0.0f, Y ? -0.0f : 0.0f, Z ? -0.0f : 0.0f, W ? -0.0f : 0.0f));
+                    }
+
+                    // 'fisqrt' on every lane
+                    inline Register fisqrt(Register n) {
+                        __m128i i = _mm_sub_epi32(_mm_set1_epi32(0x5F1FFFF9), _mm_srli_epi32(_mm_castps_si128(n), 1));
+                        Register f = _mm_castsi128_ps(i);
+                        Register nff = _mm_mul_ps(_mm_mul_ps(n, f), f);
+                        return _mm_mul_ps(f, _mm_mul_ps(_mm_set1_ps(0.703952253f), _mm_sub_ps(_mm_set1_ps(2.38924456f), nff)));
+                    }
+                #else
+                    using Register = float32x4_t;
+
+                    inline Register load(f32 const *values) { return vld1q_f32(values); }
+                    inline void store(f32 *values, Register r) { vst1q_f32(values, r); }
+                    inline Register loadUnaligned(f32 const *values) { return vld1q_f32(values); }
+                    inline void storeUnaligned(f32 *values, Register r) { vst1q_f32(values, r); }
+                    inline Register set(f32 x, f32 y, f32 z, f32 w) { f32 values[4] = { x, y, z, w }; return vld1q_f32(values); }
+                    inline Register splat(f32 value) { return vdupq_n_f32(value); }
+                    inline Register add(Register a, Register b) { return vaddq_f32(a, b); }
+                    inline Register sub(Register a, Register b) { return vsubq_f32(a, b); }
+                    inline Register mul(Register a, Register b) { return vmulq_f32(a, b); }
+                    inline Register div(Register a, Register b) { return vdivq_f32(a, b); }
+                    inline f32 first(Register r) { return vgetq_lane_f32(r, 0); }
+
+                    inline Register mulAdd(Register a, Register b, Register c) { return vfmaq_f32(c, a, b); }
+
+                    inline void load3(f32 const *values, Register &x, Register &y, Register &z) {
+                        float32x4x3_t v = vld3q_f32(values);
+                        x = v.val[0];
+                        y = v.val[1];
+                        z = v.val[2];
+                    }
+
+                    inline void store3(f32 *values, Register x, Register y, Register z) {
+                        float32x4x3_t v;
+                        v.val[0] = x;
+                        v.val[1] = y;
+                        v.val[2] = z;
+                        vst3q_f32(values, v);
+                    }
+
+                    inline void transpose(Register &x, Register &y, Register &z, Register &w) {
+                        float32x4x2_t xy = vtrnq_f32(x, y);
+                        float32x4x2_t zw = vtrnq_f32(z, w);
+                        x = vcombine_f32(vget_low_f32(xy.val[0]), vget_low_f32(zw.val[0]));
+                        y = vcombine_f32(vget_low_f32(xy.val[1]), vget_low_f32(zw.val[1]));
+                        z = vcombine_f32(vget_high_f32(xy.val[0]), vget_high_f32(zw.val[0]));
+                        w = vcombine_f32(vget_high_f32(xy.val[1]), vget_high_f32(zw.val[1]));
+                    }
+
+                    using Mask = uint32x4_t;
+
+                    inline Mask less(Register a, Register b) { return vcltq_f32(a, b); }
+                    inline Register select(Mask mask, Register a, Register b) { return vbslq_f32(mask, a, b); }
+
+                    inline Register flipIfNegative(Register value, Register sign) {
+                        uint32x4_t negative = vcltq_f32(sign, vdupq_n_f32(0.0f));
+                        uint32x4_t flip = vandq_u32(negative, vdupq_n_u32(0x80000000u));
+                        return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(value), flip));
+                    }
+
+                    inline void load4(f32 const *values, Register &x, Register &y, Register &z, Register &w) {
+                        float32x4x4_t v = vld4q_f32(values);
+                        x = v.val[0];
+                        y = v.val[1];
+                        z = v.val[2];
+                        w = v.val[3];
+                    }
+
+                    inline void store4(f32 *values, Register x, Register y, Register z, Register w) {
+                        float32x4x4_t v;
+                        v.val[0] = x;
+                        v.val[1] = y;
+                        v.val[2] = z;
+                        v.val[3] = w;
+                        vst4q_f32(values, v);
+                    }
+
+                    template<int X, int Y, int Z, int W>
+                    inline Register permute(Register r) {
+                        static constexpr u8 table[16] = {
+                            X * 4, X * 4 + 1, X * 4 + 2, X * 4 + 3, Y * 4, Y * 4 + 1, Y * 4 + 2, Y * 4 + 3,
+                            Z * 4, Z * 4 + 1, Z * 4 + 2, Z * 4 + 3, W * 4, W * 4 + 1, W * 4 + 2, W * 4 + 3,
+                        };
+                        return vreinterpretq_f32_u8(vqtbl1q_u8(vreinterpretq_u8_f32(r), vld1q_u8(table)));
+                    }
+
+                    template<int X, int Y, int Z, int W>
+                    inline Register negate(Register r) {
+                        static constexpr u32 mask[4] = { X ? 0x80000000u : 0u, Y ? 0x80000000u : 0u, Z ? 0x80000000u : 0u, W ? 0x80000000u : 0u };
+                        return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(r), vld1q_u32(mask)));
+                    }
+
+                    inline Register fisqrt(Register n) {
+                        uint32x4_t i = vsubq_u32(vdupq_n_u32(0x5F1FFFF9), vshrq_n_u32(vreinterpretq_u32_f32(n), 1));
+                        Register f = vreinterpretq_f32_u32(i);
+                        Register nff = vmulq_f32(vmulq_f32(n, f), f);
+                        return vmulq_f32(f, vmulq_f32(vdupq_n_f32(0.703952253f), vsubq_f32(vdupq_n_f32(2.38924456f), nff)));
+                    }
+                #endif
+
+                // the dot product in every lane, summed in lane order like the scalar code
+                inline Register dot(Register a, Register b) {
+                    Register p = mul(a, b);
+                    Register sum = add(permute<0, 0, 0, 0>(p), permute<1, 1, 1, 1>(p));
+                    sum = add(sum, permute<2, 2, 2, 2>(p));
+                    return add(sum, permute<3, 3, 3, 3>(p));
+                }
+
+                // the cross product of the first three lanes, the last one is garbage
+                inline Register cross(Register a, Register b) {
+                    Register left = mul(permute<1, 2, 0, 3>(a), permute<2, 0, 1, 3>(b));
+                    Register right = mul(permute<2, 0, 1, 3>(a), permute<1, 2, 0, 3>(b));
+                    return sub(left, right);
+                }
+
+                // the hamilton product of two quaternions stored as x, y, z, w
+                inline Register quaternionMul(Register q, Register p) {
+                    Register r = mul(permute<3, 3, 3, 3>(q), p);
+                    r = add(r, negate<0, 0, 0, 1>(mul(permute<0, 1, 2, 0>(q), permute<3, 3, 3, 0>(p))));
+                    r = add(r, negate<0, 0, 0, 1>(mul(permute<1, 2, 0, 1>(q), permute<2, 0, 1, 1>(p))));
+                    return sub(r, mul(permute<2, 0, 1, 2>(q), permute<1, 2, 0, 2>(p)));
+                }
+            }
+        #endif
+
+        // the batch kernels work on 'LANES' floats at a time: eight with AVX2, four with SSE or NEON, one
+        // otherwise. unlike 'vec4' nothing here needs aligned memory
+        namespace wide {
+            #if ACHILLES_SIMD_MATH && defined(ACHILLES_AVX2)
+                using Register = __m256;
+                constexpr u64 LANES = 8;
+
+                inline Register load(f32 const *values) { return _mm256_loadu_ps(values); }
+                inline void store(f32 *values, Register r) { _mm256_storeu_ps(values, r); }
+                inline Register splat(f32 value) { return _mm256_set1_ps(value); }
+                inline Register add(Register a, Register b) { return _mm256_add_ps(a, b); }
+                inline Register sub(Register a, Register b) { return _mm256_sub_ps(a, b); }
+                inline Register mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+                inline Register div(Register a, Register b) { return _mm256_div_ps(a, b); }
+                inline Register min(Register a, Register b) { return _mm256_min_ps(a, b); }
+                inline Register max(Register a, Register b) { return _mm256_max_ps(a, b); }
+
+                // bit i set when lane i is negative, '-0.0f' included
+                inline u32 signBits(Register r) { return (u32) _mm256_movemask_ps(r); }
+
+                inline Register mulAdd(Register a, Register b, Register c) {
+                    #if defined(__FMA__)
+                        return _mm256_fmadd_ps(a, b, c);
+                    #else
+                        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+                    #endif
+                }
+
+                inline Register fisqrt(Register n) {
+                    __m256i i = _mm256_sub_epi32(_mm256_set1_epi32(0x5F1FFFF9), _mm256_srli_epi32(_mm256_castps_si256(n), 1));
+                    Register f = _mm256_castsi256_ps(i);
+                    Register nff = _mm256_mul_ps(_mm256_mul_ps(n, f), f);
+                    return _mm256_mul_ps(f, _mm256_mul_ps(_mm256_set1_ps(0.703952253f), _mm256_sub_ps(_mm256_set1_ps(2.38924456f), nff)));
+                }
+            #elif ACHILLES_SIMD_MATH
+                using Register = vec4::Register;
+                constexpr u64 LANES = 4;
+
+                #if defined(ACHILLES_SSE2)
+                    inline Register load(f32 const *values) { return _mm_loadu_ps(values); }
+                    inline void store(f32 *values, Register r) { _mm_storeu_ps(values, r); }
+                    inline Register min(Register a, Register b) { return _mm_min_ps(a, b); }
+                    inline Register max(Register a, Register b) { return _mm_max_ps(a, b); }
+                    inline u32 signBits(Register r) { return (u32) _mm_movemask_ps(r); }
+                #else
+                    inline Register load(f32 const *values) { return vld1q_f32(values); }
+                    inline void store(f32 *values, Register r) { vst1q_f32(values, r); }
+                    inline Register min(Register a, Register b) { return vminq_f32(a, b); }
+                    inline Register max(Register a, Register b) { return vmaxq_f32(a, b); }
+
+                    inline u32 signBits(Register r) {
+                        static constexpr u32 weights[4] = { 1, 2, 4, 8 };
+                        uint32x4_t signs = vshrq_n_u32(vreinterpretq_u32_f32(r), 31);
+                        return vaddvq_u32(vmulq_u32(signs, vld1q_u32(weights)));
+                    }
+                #endif
+
+                using vec4::splat;
+                using vec4::add;
+                using vec4::sub;
+                using vec4::mul;
+                using vec4::div;
+                using vec4::mulAdd;
+                using vec4::fisqrt;
+            #else
+                struct Register {
+                    f32 value;
+                };
+                constexpr u64 LANES = 1;
+
+                inline Register load(f32 const *values) { return Register { *values }; }
+                inline void store(f32 *values, Register r) { *values = r.value; }
+                inline Register splat(f32 value) { return Register { value }; }
+                inline Register add(Register a, Register b) { return Register { a.value + b.value }; }
+                inline Register sub(Register a, Register b) { return Register { a.value - b.value }; }
+                inline Register mul(Register a, Register b) { return Register { a.value * b.value }; }
+                inline Register div(Register a, Register b) { return Register { a.value / b.value }; }
+                inline Register min(Register a, Register b) { return Register { b.value < a.value ? b.value : a.value }; }
+                inline Register max(Register a, Register b) { return Register { b.value > a.value ? b.value : a.value }; }
+                inline Register mulAdd(Register a, Register b, Register c) { return Register { a.value * b.value + c.value }; }
+                inline Register fisqrt(Register n) { return Register { math::fisqrt(n.value) }; }
+                inline u32 signBits(Register r) { return std::signbit(r.value) ? 1 : 0; }
+            #endif
+        }
+
+        // what the precision policies below need from a register type: 'f32' itself, 'vec4::Register' and
+        // 'wide::Register'. the kernels are written once over these, so the scalar and vector versions do the
+        // same operations in the same order and give the same bits. the vector ones are told apart by size,
+        // naming '__m128' as a template argument makes GCC warn about its dropped alignment attribute
+        template<typename R, u64 Size = sizeof(R)>
+        struct Lanes;
+
+        template<>
+        struct Lanes<f32> {
+            using Register = f32;
+            using Int = s32;
+            using Mask = bool;
+            static constexpr u64 COUNT = 1;
+
+            // newton steps that take 'rsqrtEstimate' to full precision
+            #if defined(ACHILLES_NEON)
+                static constexpr u32 RSQRT_STEPS = 2;
+            #elif defined(ACHILLES_SSE2)
+                static constexpr u32 RSQRT_STEPS = 1;
+            #else
+                static constexpr u32 RSQRT_STEPS = 2;
+            #endif
+
+            static f32 load(f32 const *values) { return *values; }
+            static void store(f32 *values, f32 r) { *values = r; }
+            static f32 splat(f32 value) { return value; }
+            static f32 add(f32 a, f32 b) { return a + b; }
+            static f32 sub(f32 a, f32 b) { return a - b; }
+            static f32 mul(f32 a, f32 b) { return a * b; }
+            static f32 div(f32 a, f32 b) { return a / b; }
+            static f32 min(f32 a, f32 b) { return b < a ? b : a; }
+            static f32 max(f32 a, f32 b) { return b > a ? b : a; }
+            static f32 abs(f32 a) { return std::fabs(a); }
+            static f32 sqrt(f32 a) { return std::sqrt(a); }
+
+            // fused exactly when 'vec4::mulAdd' is
+            static f32 mulAdd(f32 a, f32 b, f32 c) {
+                #if defined(__FMA__) || (defined(ACHILLES_NEON) && ACHILLES_SIMD_MATH)
+                    return std::fma(a, b, c);
+                #else
+                    return a * b + c;
+                #endif
+            }
+
+            static bool less(f32 a, f32 b) { return a < b; }
+            static bool equal(f32 a, f32 b) { return a == b; }
+            static f32 select(bool mask, f32 a, f32 b) { return mask ? a : b; }
+            static f32 negateIf(bool mask, f32 a) { return mask ? -a : a; }
+
+            // to the nearest integer, ties to even
+            static s32 round(f32 a) { return (s32) std::nearbyint(a); }
+            static f32 toFloat(s32 a) { return (f32) a; }
+            static s32 increment(s32 a) { return a + 1; }
+            static bool test(s32 a, s32 bits) { return (a & bits) != 0; }
+
+            static f32 rsqrtEstimate(f32 a) {
+                #if defined(ACHILLES_NEON)
+                    return vrsqrtes_f32(a);
+                #elif defined(ACHILLES_SSE2)
+                    return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(a)));
+                #else
+                    return fisqrt(a);
+                #endif
+            }
+
+            template<typename F>
+            static f32 map(f32 a, F &&function) { return function(a); }
+
+            template<typename F>
+            static f32 map(f32 a, f32 b, F &&function) { return function(a, b); }
+        };
+
+        #if ACHILLES_SIMD_MATH
+            template<typename R>
+            struct Lanes<R, sizeof(vec4::Register)> {
+                using Register = vec4::Register;
+                using Mask = vec4::Mask;
+                static constexpr u64 COUNT = 4;
+
+                #if defined(ACHILLES_SSE2)
+                    using Int = __m128i;
+                    static constexpr u32 RSQRT_STEPS = 1;
+
+                    static Register min(Register a, Register b) { return _mm_min_ps(a, b); }
+                    static Register max(Register a, Register b) { return _mm_max_ps(a, b); }
+                    static Register abs(Register a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+                    static Register sqrt(Register a) { return _mm_sqrt_ps(a); }
+                    static Mask equal(Register a, Register b) { return _mm_cmpeq_ps(a, b); }
+                    static Register negateIf(Mask mask, Register a) { return _mm_xor_ps(a, _mm_and_ps(mask, _mm_set1_ps(-0.0f))); }
+                    static Int round(Register a) { return _mm_cvtps_epi32(a); }
+                    static Register toFloat(Int a) { return _mm_cvtepi32_ps(a); }
+                    static Int increment(Int a) { return _mm_add_epi32(a, _mm_set1_epi32(1)); }
+                    static Mask test(Int a, s32 bits) { return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(a, _mm_set1_epi32(bits)), _mm_set1_epi32(bits))); }
+                    static Register rsqrtEstimate(Register a) { return _mm_rsqrt_ps(a); }
+                #else
+                    using Int = int32x4_t;
+                    static constexpr u32 RSQRT_STEPS = 2;
+
+                    static Register min(Register a, Register b) { return vminq_f32(a, b); }
+                    static Register max(Register a, Register b) { return vmaxq_f32(a, b); }
+                    static Register abs(Register a) { return vabsq_f32(a); }
+                    static Register sqrt(Register a) { return vsqrtq_f32(a); }
+                    static Mask equal(Register a, Register b) { return vceqq_f32(a, b); }
+                    static Register negateIf(Mask mask, Register a) { return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vandq_u32(mask, vdupq_n_u32(0x80000000u)))); }
+                    static Int round(Register a) { return vcvtnq_s32_f32(a); }
+                    static Register toFloat(Int a) { return vcvtq_f32_s32(a); }
+                    static Int increment(Int a) { return vaddq_s32(a, vdupq_n_s32(1)); }
+                    static Mask test(Int a, s32 bits) { return vtstq_s32(a, vdupq_n_s32(bits)); }
+                    static Register rsqrtEstimate(Register a) { return vrsqrteq_f32(a); }
+                #endif
+
+                static Register load(f32 const *values) { return vec4::loadUnaligned(values); }
+                static void store(f32 *values, Register r) { vec4::storeUnaligned(values, r); }
+                static Register splat(f32 value) { return vec4::splat(value); }
+                static Register add(Register a, Register b) { return vec4::add(a, b); }
+                static Register sub(Register a, Register b) { return vec4::sub(a, b); }
+                static Register mul(Register a, Register b) { return vec4::mul(a, b); }
+                static Register div(Register a, Register b) { return vec4::div(a, b); }
+                static Register mulAdd(Register a, Register b, Register c) { return vec4::mulAdd(a, b, c); }
+                static Mask less(Register a, Register b) { return vec4::less(a, b); }
+                static Register select(Mask mask, Register a, Register b) { return vec4::select(mask, a, b); }
+
+                template<typename F>
+                static Register map(Register a, F &&function) {
+                    alignas(16) f32 values[4];
+                    vec4::store(values, a);
+                    for (u32 i = 0; i < 4; ++i) values[i] = function(values[i]);
+                    return vec4::load(values);
+                }
+
+                template<typename F>
+                static Register map(Register a, Register b, F &&function) {
+                    alignas(16) f32 values[4];
+                    alignas(16) f32 others[4];
+                    vec4::store(values, a);
+                    vec4::store(others, b);
+                    for (u32 i = 0; i < 4; ++i) values[i] = function(values[i], others[i]);
+                    return vec4::load(values);
+                }
+            };
+        #endif
+
+        #if ACHILLES_SIMD_MATH && defined(ACHILLES_AVX2)
+            template<typename R>
+            struct Lanes<R, sizeof(wide::Register)> {
+                using Register = wide::Register;
+                using Int = __m256i;
+                using Mask = __m256;
+                static constexpr u64 COUNT = 8;
+                static constexpr u32 RSQRT_STEPS = 1;
+
+                static Register load(f32 const *values) { return wide::load(values); }
+                static void store(f32 *values, Register r) { wide::store(values, r); }
+                static Register splat(f32 value) { return wide::splat(value); }
+                static Register add(Register a, Register b) { return wide::add(a, b); }
+                static Register sub(Register a, Register b) { return wide::sub(a, b); }
+                static Register mul(Register a, Register b) { return wide::mul(a, b); }
+                static Register div(Register a, Register b) { return wide::div(a, b); }
+                static Register min(Register a, Register b) { return wide::min(a, b); }
+                static Register max(Register a, Register b) { return wide::max(a, b); }
+                static Register mulAdd(Register a, Register b, Register c) { return wide::mulAdd(a, b, c); }
+                static Register abs(Register a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+                static Register sqrt(Register a) { return _mm256_sqrt_ps(a); }
+                static Mask less(Register a, Register b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+                static Mask equal(Register a, Register b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+                static Register select(Mask mask, Register a, Register b) { return _mm256_blendv_ps(b, a, mask); }
+                static Register negateIf(Mask mask, Register a) { return _mm256_xor_ps(a, _mm256_and_ps(mask, _mm256_set1_ps(-0.0f))); }
+                static Int round(Register a) { return _mm256_cvtps_epi32(a); }
+                static Register toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+                static Int increment(Int a) { return _mm256_add_epi32(a, _mm256_set1_epi32(1)); }
+                static Mask test(Int a, s32 bits) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(a, _mm256_set1_epi32(bits)), _mm256_set1_epi32(bits))); }
+                static Register rsqrtEstimate(Register a) { return _mm256_rsqrt_ps(a); }
+
+                template<typename F>
+                static Register map(Register a, F &&function) {
+                    alignas(32) f32 values[8];
+                    _mm256_store_ps(values, a);
+                    for (u32 i = 0; i < 8; ++i) values[i] = function(values[i]);
+                    return _mm256_load_ps(values);
+                }
+
+                template<typename F>
+                static Register map(Register a, Register b, F &&function) {
+                    alignas(32) f32 values[8];
+                    alignas(32) f32 others[8];
+                    _mm256_store_ps(values, a);
+                    _mm256_store_ps(others, b);
+                    for (u32 i = 0; i < 8; ++i) values[i] = function(values[i], others[i]);
+                    return _mm256_load_ps(values);
+                }
+            };
+        #elif !ACHILLES_SIMD_MATH
+            // the one lane of the scalar 'wide::Register'
+            template<>
+            struct Lanes<wide::Register> {
+                using Register = wide::Register;
+                using Scalar = Lanes<f32>;
+                using Int = s32;
+                using Mask = bool;
+                static constexpr u64 COUNT = 1;
+                static constexpr u32 RSQRT_STEPS = Scalar::RSQRT_STEPS;
+
+                static Register load(f32 const *values) { return Register { *values }; }
+                static void store(f32 *values, Register r) { *values = r.value; }
+                static Register splat(f32 value) { return Register { value }; }
+                static Register add(Register a, Register b) { return Register { a.value + b.value }; }
+                static Register sub(Register a, Register b) { return Register { a.value - b.value }; }
+                static Register mul(Register a, Register b) { return Register { a.value * b.value }; }
+                static Register div(Register a, Register b) { return Register { a.value / b.value }; }
+                static Register min(Register a, Register b) { return Register { Scalar::min(a.value, b.value) }; }
+                static Register max(Register a, Register b) { return Register { Scalar::max(a.value, b.value) }; }
+                static Register mulAdd(Register a, Register b, Register c) { return Register { Scalar::mulAdd(a.value, b.value, c.value) }; }
+                static Register abs(Register a) { return Register { std::fabs(a.value) }; }
+                static Register sqrt(Register a) { return Register { std::sqrt(a.value) }; }
+                static bool less(Register a, Register b) { return a.value < b.value; }
+                static bool equal(Register a, Register b) { return a.value == b.value; }
+                static Register select(bool mask, Register a, Register b) { return mask ? a : b; }
+                static Register negateIf(bool mask, Register a) { return Register { mask ? -a.value : a.value }; }
+                static s32 round(Register a) { return Scalar::round(a.value); }
+                static Register toFloat(s32 a) { return Register { (f32) a }; }
+                static s32 increment(s32 a) { return a + 1; }
+                static bool test(s32 a, s32 bits) { return (a & bits) != 0; }
+                static Register rsqrtEstimate(Register a) { return Register { Scalar::rsqrtEstimate(a.value) }; }
+
+                template<typename F>
+                static Register map(Register a, F &&function) { return Register { function(a.value) }; }
+
+                template<typename F>
+                static Register map(Register a, Register b, F &&function) { return Register { function(a.value, b.value) }; }
+            };
+        #endif
+
+        // the polynomial kernels behind 'Fast' and 'Approximate', 'Low' picking the cheaper polynomials
+        template<typename R, bool Low>
+        struct Kernels {
+            using L = Lanes<R>;
+
+            // 'TAU / 4' in three parts, the first ones with enough trailing zeros that 'q * part' is exact for
+            // the quadrants the reduction is good for
+            static constexpr f32 QUARTER_1 = 1.5703125f;
+            static constexpr f32 QUARTER_2 = 4.837512969970703125e-4f;
+            static constexpr f32 QUARTER_3 = 7.54978995489188216e-8f;
+
+            static R rsqrt(R x) {
+                R y = L::rsqrtEstimate(x);
+                constexpr u32 steps = Low ? L::RSQRT_STEPS - 1 : L::RSQRT_STEPS;
+                for (u32 i = 0; i < steps; ++i) {
+                    y = L::mul(y, L::sub(L::splat(1.5f), L::mul(L::mul(L::splat(0.5f), x), L::mul(y, y))));
+                }
+                return y;
+            }
+
+            // reduces 'x' by the nearest quarter turn to [-TAU / 8, TAU / 8], evaluates both polynomials there
+            // and swaps and flips them back by the quadrant
+            static void sincos(R x, R &outSin, R &outCos) {
+                typename L::Int quadrant = L::round(L::mul(x, L::splat(4.0f / TAU)));
+                R q = L::toFloat(quadrant);
+                R r = L::mulAdd(q, L::splat(-QUARTER_1), x);
+                r = L::mulAdd(q, L::splat(-QUARTER_2), r);
+                r = L::mulAdd(q, L::splat(-QUARTER_3), r);
+                R z = L::mul(r, r);
+
+                R s, c;
+                if constexpr (Low) {
+                    s = L::mulAdd(L::mul(L::mulAdd(z, L::splat(0.008152992f), L::splat(-0.16662834f)), z), r, r);
+                    c = L::mulAdd(L::mulAdd(z, L::splat(0.040488936f), L::splat(-0.49977631f)), z, L::splat(1.0f));
+                } else {
+                    R sp = L::mulAdd(L::mulAdd(z, L::splat(-1.9515295891e-4f), L::splat(8.3321608736e-3f)), z, L::splat(-1.6666654611e-1f));
+                    s = L::mulAdd(L::mul(sp, z), r, r);
+                    R cp = L::mulAdd(L::mulAdd(z, L::splat(2.443315711809948e-5f), L::splat(-1.388731625493765e-3f)), z, L::splat(4.166664568298827e-2f));
+                    c = L::mulAdd(L::mul(cp, z), z, L::mulAdd(z, L::splat(-0.5f), L::splat(1.0f)));
+                }
+
+                typename L::Mask swap = L::test(quadrant, 1);
+                outSin = L::negateIf(L::test(quadrant, 2), L::select(swap, c, s));
+                outCos = L::negateIf(L::test(L::increment(quadrant), 2), L::select(swap, s, c));
+            }
+
+            // atan of the smaller over the larger of |y| and |x|, in [0, 1], mirrored into the right octant
+            static R atan2(R y, R x) {
+                R ax = L::abs(x);
+                R ay = L::abs(y);
+                R high = L::max(ax, ay);
+                R low = L::min(ax, ay);
+                R a = L::div(low, L::select(L::equal(high, L::splat(0.0f)), L::splat(1.0f), high));
+                R s = L::mul(a, a);
+
+                R p;
+                if constexpr (Low) {
+                    // Abramowitz and Stegun 4.4.47
+                    p = L::mulAdd(s, L::splat(0.0208351f), L::splat(-0.0851330f));
+                    p = L::mulAdd(p, s, L::splat(0.1801410f));
+                    p = L::mulAdd(p, s, L::splat(-0.3302995f));
+                    p = L::mulAdd(p, s, L::splat(0.9998660f));
+                } else {
+                    // Abramowitz and Stegun 4.4.49
+                    p = L::mulAdd(s, L::splat(0.0028662257f), L::splat(-0.0161657367f));
+                    p = L::mulAdd(p, s, L::splat(0.0429096138f));
+                    p = L::mulAdd(p, s, L::splat(-0.0752896400f));
+                    p = L::mulAdd(p, s, L::splat(0.1065626393f));
+                    p = L::mulAdd(p, s, L::splat(-0.1420889944f));
+                    p = L::mulAdd(p, s, L::splat(0.1999355085f));
+                    p = L::mulAdd(p, s, L::splat(-0.3333314528f));
+                    p = L::mulAdd(p, s, L::splat(1.0f));
+                }
+                R r = L::mul(p, a);
+                r = L::select(L::less(ax, ay), L::sub(L::splat(TAU / 4), r), r);
+                r = L::select(L::less(x, L::splat(0.0f)), L::sub(L::splat(TAU / 2), r), r);
+                return L::negateIf(L::less(y, L::splat(0.0f)), r);
+            }
+
+            // 'sqrt(1 - |x|)' times a polynomial in |x|, mirrored for negative 'x'
+            static R acos(R x) {
+                R ax = L::min(L::abs(x), L::splat(1.0f));
+                R p;
+                if constexpr (Low) {
+                    // Abramowitz and Stegun 4.4.45
+                    p = L::mulAdd(ax, L::splat(-0.0187293f), L::splat(0.0742610f));
+                    p = L::mulAdd(p, ax, L::splat(-0.2121144f));
+                    p = L::mulAdd(p, ax, L::splat(1.5707288f));
+                } else {
+                    // Abramowitz and Stegun 4.4.46
+                    p = L::mulAdd(ax, L::splat(-0.0012624911f), L::splat(0.0066700901f));
+                    p = L::mulAdd(p, ax, L::splat(-0.0170881256f));
+                    p = L::mulAdd(p, ax, L::splat(0.0308918810f));
+                    p = L::mulAdd(p, ax, L::splat(-0.0501743046f));
+                    p = L::mulAdd(p, ax, L::splat(0.0889789874f));
+                    p = L::mulAdd(p, ax, L::splat(-0.2145988016f));
+                    p = L::mulAdd(p, ax, L::splat(1.5707963050f));
+                }
+                R r = L::mul(L::sqrt(L::sub(L::splat(1.0f), ax)), p);
+                return L::select(L::less(x, L::splat(0.0f)), L::sub(L::splat(TAU / 2), r), r);
+            }
+        };
+
+        // precision policies for the trigonometry and reciprocal square roots of this file. the builders that
+        // spend their time in those take one as a template argument, 'Precise' by default:
+        //
+        //     quaternion q = quaternion::fromAngleAxis<Fast>(angle, axis);
+        //     float4x4 projection = float4x4::perspectiveDX<Fast>(fov, aspect, near, far);
+        //
+        // and every function works on 'f32', 'vec4::Register' and 'wide::Register' alike, e.g.
+        // 'Fast::sincos(angles, sines, cosines)' for eight angles at once with AVX2. the errors below were
+        // measured over the whole input range and are absolute, except for 'rsqrt'
+        //
+        // 'Precise' is <cmath>, lane by lane for registers, and the exact reciprocal of 'sqrt'
+        struct Precise {
+            template<typename R> static R sin(R x) { return Lanes<R>::map(x, [](f32 v) { return std::sin(v); }); }
+            template<typename R> static R cos(R x) { return Lanes<R>::map(x, [](f32 v) { return std::cos(v); }); }
+            template<typename R> static R tan(R x) { return Lanes<R>::map(x, [](f32 v) { return std::tan(v); }); }
+            template<typename R> static R asin(R x) { return Lanes<R>::map(x, [](f32 v) { return std::asin(v); }); }
+            template<typename R> static R acos(R x) { return Lanes<R>::map(x, [](f32 v) { return std::acos(v); }); }
+            template<typename R> static R atan2(R y, R x) { return Lanes<R>::map(y, x, [](f32 a, f32 b) { return std::atan2(a, b); }); }
+            template<typename R> static R rsqrt(R x) { return Lanes<R>::div(Lanes<R>::splat(1.0f), Lanes<R>::sqrt(x)); }
+
+            template<typename R>
+            static void sincos(R x, R &outSin, R &outCos) {
+                outSin = sin(x);
+                outCos = cos(x);
+            }
+        };
+
+        // the polynomial policies. 'acos' and 'asin' clamp to [-1, 1], 'atan2' doesn't follow the signed zeros
+        // and infinities of 'std::atan2' and 'rsqrt' needs a positive finite input
+        template<bool Low>
+        struct Polynomial {
+            template<typename R> static R rsqrt(R x) { return Kernels<R, Low>::rsqrt(x); }
+            template<typename R> static void sincos(R x, R &outSin, R &outCos) { Kernels<R, Low>::sincos(x, outSin, outCos); }
+            template<typename R> static R atan2(R y, R x) { return Kernels<R, Low>::atan2(y, x); }
+            template<typename R> static R acos(R x) { return Kernels<R, Low>::acos(x); }
+
+            template<typename R>
+            static R asin(R x) {
+                return Lanes<R>::sub(Lanes<R>::splat(TAU / 4), acos(x));
+            }
+
+            template<typename R>
+            static R sin(R x) {
+                R s, c;
+                sincos(x, s, c);
+                return s;
+            }
+
+            template<typename R>
+            static R cos(R x) {
+                R s, c;
+                sincos(x, s, c);
+                return c;
+            }
+
+            template<typename R>
+            static R tan(R x) {
+                R s, c;
+                sincos(x, s, c);
+                return Lanes<R>::div(s, c);
+            }
+        };
+
+        // 'Fast' keeps close to full precision: 'sin' and 'cos' within 1e-7 for |x| < 8192 (less accurate past
+        // that), 'atan2' within 4e-7, 'acos' and 'asin' within 5e-7, 'rsqrt' within 3e-7 relative. about four
+        // times faster than <cmath> one at a time, and it goes wide
+        using Fast = Polynomial<false>;
+
+        // 'Approximate' trades precision for fewer terms: 'sin' and 'cos' within 2e-5 (for the same range),
+        // 'atan2' within 2e-5, 'acos' and 'asin' within 7e-5, 'rsqrt' within 4e-4 relative
+        using Approximate = Polynomial<true>;
+
         union float2;
         union float3;
         union float4;
         union quaternion;
         union float4x4;
+        union float3x4;
 
         union float2 {
             struct {
@@ -234,7 +963,7 @@ namespace achilles {
             constexpr static f32 inverseLerp(float3 a, float3 b, float3 c);
         };
 
-        union float4 {
+        union alignas(16) float4 {
             struct {
                 f32 x,y,z,w;
             };
@@ -281,7 +1010,7 @@ namespace achilles {
             constexpr static f32 inverseLerp(float4 a, float4 b, float4 c);
         };
 
-        union quaternion {
+        union alignas(16) quaternion {
             struct {
                 f32 x, y, z, w;
             };
@@ -312,11 +1041,13 @@ namespace achilles {
             constexpr f32 sqrMagnitude() const;
             quaternion & normalize();
             quaternion normalized() const;
-            void toAngleAxis(f32 &outAngle, float3 &outAxis) const;
-            float3 toEulerAngles() const;
-            static quaternion fromAngleAxis(f32 angle, float3 axis);
+            template<typename Precision = Precise> void toAngleAxis(f32 &outAngle, float3 &outAxis) const;
+            template<typename Precision = Precise> float3 toEulerAngles() const;
+            template<typename Precision = Precise> static quaternion fromAngleAxis(f32 angle, float3 axis);
             static quaternion lookRotation(float3 point, float3 eye = float3::zero(), float3 up = float3::up());
-            static quaternion fromEulerAngles(float3 angles);
+            template<typename Precision = Precise> static quaternion fromEulerAngles(float3 angles);
+            static quaternion nlerp(quaternion a, quaternion b, f32 t);
+            template<typename Precision = Precise> static quaternion slerp(quaternion a, quaternion b, f32 t);
         };
 
         union float4x4 {
@@ -351,6 +1082,10 @@ namespace achilles {
             constexpr float4x4 & operator *=(float4x4 m);
             constexpr float4x4 & transpose();
             constexpr float4x4 transposed() const;
+            constexpr f32 determinant() const;
+            constexpr float4x4 & inverse();
+            constexpr float4x4 inversed() const;
+            constexpr float4x4 affineInversed() const;
             constexpr float4x4 translation() const;
             constexpr float4x4 rotationAndScale() const;
             constexpr float4 operator *(float4 v) const;
@@ -362,13 +1097,45 @@ namespace achilles {
             constexpr static float4x4 fromRotation(quaternion q);
             constexpr static float4x4 scale(float3 s);
             constexpr static float4x4 translate(float3 t);
-            static float4x4 perspectiveDX(f32 fov, f32 aspectRatio, f32 near, f32 far);
-            static float4x4 perspectiveGL(f32 fov, f32 aspectRatio, f32 near, f32 far);
+            template<typename Precision = Precise> static float4x4 perspectiveDX(f32 fov, f32 aspectRatio, f32 near, f32 far);
+            template<typename Precision = Precise> static float4x4 perspectiveGL(f32 fov, f32 aspectRatio, f32 near, f32 far);
             static constexpr float4x4 orthoDX(f32 width, f32 height, f32 near, f32 far);
             static constexpr float4x4 orthoGL(f32 left, f32 right, f32 bottom, f32 top, f32 near, f32 far);
-            static float4x4 eulerAngles(float3 angles);
+            template<typename Precision = Precise> static float4x4 eulerAngles(float3 angles);
             static float4x4 lookAt(float3 point, float3 eye = float3::zero(), float3 up = float3::up());
         };
+
+        // the top three rows of a 'float4x4' whose last row is 0 0 0 1, what skinning and most transforms need
+        union float3x4 {
+            struct {
+                float4 a;
+                float4 b;
+                float4 c;
+            } rows;
+
+            f32 values[3][4];
+
+            constexpr float3x4(
+                float4 a = float4{ 1, 0, 0, 0 },
+                float4 b = float4{ 0, 1, 0, 0 },
+                float4 c = float4{ 0, 0, 1, 0 }
+            ) : rows { a,b,c } { }
+
+            constexpr explicit float3x4(float4x4 m) : rows { m.rows.a, m.rows.b, m.rows.c } { }
+
+            constexpr explicit operator float4x4() const {
+                return float4x4 { rows.a, rows.b, rows.c, float4 { 0, 0, 0, 1 } };
+            }
+
+            constexpr float3 operator *(float3 v) const {
+                float4 p { v.x, v.y, v.z, 1.0f };
+                return float3 { rows.a.dot(p), rows.b.dot(p), rows.c.dot(p) };
+            }
+
+            constexpr static float3x4 fromRotation(quaternion q) {
+                return float3x4 { float4x4::fromRotation(q) };
+            }
+        };
         
         // float2
         constexpr float2::operator float3() const {
@@ -680,14 +1447,34 @@ namespace achilles {
         }
 
         constexpr float4 float4::operator -() const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    float4 result;
+                    vec4::store(result.values, vec4::negate<1, 1, 1, 1>(vec4::load(this->values)));
+                    return result;
+                }
+            #endif
             return float4(-this->x, -this->y, -this->z, -this->w);
         }
 
         constexpr float4 float4::operator +(float4 b) const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    float4 result;
+                    vec4::store(result.values, vec4::add(vec4::load(this->values), vec4::load(b.values)));
+                    return result;
+                }
+            #endif
             return float4(this->x + b.x, this->y + b.y, this->z + b.z, this->w + b.w);
         }
 
         constexpr float4 & float4::operator +=(float4 b) {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::store(this->values, vec4::add(vec4::load(this->values), vec4::load(b.values)));
+                    return *this;
+                }
+            #endif
             this->x += b.x;
             this->y += b.y;
             this->z += b.z;
@@ -696,10 +1483,23 @@ namespace achilles {
         }
 
         constexpr float4 float4::operator -(float4 b) const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    float4 result;
+                    vec4::store(result.values, vec4::sub(vec4::load(this->values), vec4::load(b.values)));
+                    return result;
+                }
+            #endif
             return float4(this->x - b.x, this->y - b.y, this->z - b.z, this->w - b.w);
         }
 
         constexpr float4 & float4::operator -=(float4 b) {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::store(this->values, vec4::sub(vec4::load(this->values), vec4::load(b.values)));
+                    return *this;
+                }
+            #endif
             this->x -= b.x;
             this->y -= b.y;
             this->z -= b.z;
@@ -708,10 +1508,23 @@ namespace achilles {
         }
 
         constexpr float4 float4::operator /(f32 scalar) const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    float4 result;
+                    vec4::store(result.values, vec4::div(vec4::load(this->values), vec4::splat(scalar)));
+                    return result;
+                }
+            #endif
             return float4(this->x / scalar, this->y / scalar, this->z / scalar, this->w / scalar);
         }
 
         constexpr float4 & float4::operator /=(f32 scalar) {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::store(this->values, vec4::div(vec4::load(this->values), vec4::splat(scalar)));
+                    return *this;
+                }
+            #endif
             this->x /= scalar;
             this->y /= scalar;
             this->z /= scalar;
@@ -720,10 +1533,23 @@ namespace achilles {
         }
 
         constexpr float4 float4::operator *(f32 scalar) const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    float4 result;
+                    vec4::store(result.values, vec4::mul(vec4::load(this->values), vec4::splat(scalar)));
+                    return result;
+                }
+            #endif
             return float4(this->x * scalar, this->y * scalar, this->z * scalar, this->w * scalar);
         }
 
         constexpr float4 & float4::operator *=(f32 scalar) {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::store(this->values, vec4::mul(vec4::load(this->values), vec4::splat(scalar)));
+                    return *this;
+                }
+            #endif
             this->x *= scalar;
             this->y *= scalar;
             this->z *= scalar;
@@ -732,39 +1558,68 @@ namespace achilles {
         }
 
         constexpr f32 float4::dot(float4 v) const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    return vec4::first(vec4::dot(vec4::load(this->values), vec4::load(v.values)));
+                }
+            #endif
             return (this->x * v.x) + (this->y * v.y) + (this->z * v.z) + (this->w * v.w);
         }
 
         constexpr f32 float4::sqrMagnitude() const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::Register r = vec4::load(this->values);
+                    return vec4::first(vec4::dot(r, r));
+                }
+            #endif
             return (this->x * this->x) + (this->y * this->y) + (this->z * this->z) + (this->w * this->w);
         }
 
         inline f32 float4::magnitude() const {
-            return std::sqrt((this->x * this->x) + (this->y * this->y) + (this->z * this->z) + (this->w * this->w));
+            return std::sqrt(this->sqrMagnitude());
         }
 
         inline float4 & float4::normalize() {
-            f32 mag  = this->sqrMagnitude();
-            f32 root = fisqrt(mag);
-            this->x *= root;
-            this->y *= root;
-            this->z *= root;
-            this->w *= root;
-            return *this;
+            #if ACHILLES_SIMD_MATH
+                vec4::Register r = vec4::load(this->values);
+                vec4::store(this->values, vec4::mul(r, vec4::fisqrt(vec4::dot(r, r))));
+                return *this;
+            #else
+                f32 mag  = this->sqrMagnitude();
+                f32 root = fisqrt(mag);
+                this->x *= root;
+                this->y *= root;
+                this->z *= root;
+                this->w *= root;
+                return *this;
+            #endif
         }
 
         inline float4 float4::normalized() const {
-            f32 mag  = this->sqrMagnitude();
-            f32 root = fisqrt(mag);
-            return float4(
-                this->x * root,
-                this->y * root,
-                this->z * root,
-                this->w * root
-            );
+            #if ACHILLES_SIMD_MATH
+                float4 result;
+                vec4::Register r = vec4::load(this->values);
+                vec4::store(result.values, vec4::mul(r, vec4::fisqrt(vec4::dot(r, r))));
+                return result;
+            #else
+                f32 mag  = this->sqrMagnitude();
+                f32 root = fisqrt(mag);
+                return float4(
+                    this->x * root,
+                    this->y * root,
+                    this->z * root,
+                    this->w * root
+                );
+            #endif
         }
 
         constexpr f32 float4::dot(float4 a, float4 b) {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    return vec4::first(vec4::dot(vec4::load(a.values), vec4::load(b.values)));
+                }
+            #endif
             return (a.x * b.x) + (a.y * b.y) + (a.z * b.z) + (a.w * b.w);
         }
 
@@ -801,6 +1656,13 @@ namespace achilles {
         }
         
         constexpr quaternion quaternion::operator *(quaternion q) const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    quaternion result;
+                    vec4::store(result.values, vec4::quaternionMul(vec4::load(this->values), vec4::load(q.values)));
+                    return result;
+                }
+            #endif
             return quaternion(
                 this->w * q.x + this->x * q.w + this->y * q.z - this->z * q.y, 
                 this->w * q.y + this->y * q.w + this->z * q.x - this->x * q.z, 
@@ -810,66 +1672,84 @@ namespace achilles {
         }
         
         constexpr quaternion& quaternion::operator *=(quaternion q) {
-            this->x = this->w * q.x + this->x * q.w + this->y * q.z - this->z * q.y; 
-            this->y = this->w * q.y + this->y * q.w + this->z * q.x - this->x * q.z; 
-            this->z = this->w * q.z + this->z * q.w + this->x * q.y - this->y * q.x; 
-            this->w = this->w * q.w - this->x * q.x - this->y * q.y - this->z * q.z;
+            *this = *this * q;
             return *this;
         }
 
+        // v + 2w(u x v) + 2u x (u x v), with u the vector part, which is cheaper than building the rotation matrix
         constexpr float3 quaternion::operator *(float3 v) const {
-            f32 x2 = this->x + this->x;
-            f32 y2 = this->y + this->y;
-            f32 z2 = this->z + this->z;
-
-            f32 yy = this->y * y2;
-            f32 xy = this->x * y2;
-            f32 xz = this->x * z2;
-            f32 yz = this->y * z2;
-
-            f32 zz = this->z * z2;
-            f32 wz = this->w * z2;
-            f32 wy = this->w * y2;
-            f32 wx = this->w * x2;
-
-            f32 xx = this->x * x2;
-            
-            return float3 {
-                (1.0f - yy - zz) * v.x + (xy - wz) * v.y + (xz + wy) * v.z,
-                (xy + wz) * v.x + (1.0f - xx - zz) * v.y + (yz - wx) * v.z,
-                (xz - wy) * v.x + (yz + wx) * v.y + (1.0f - xx - yy) * v.z,
-            };
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::Register q = vec4::load(this->values);
+                    vec4::Register t = vec4::cross(q, vec4::set(v.x, v.y, v.z, 0.0f));
+                    t = vec4::add(t, t);
+                    vec4::Register r = vec4::add(vec4::set(v.x, v.y, v.z, 0.0f), vec4::mul(t, vec4::splat(this->w)));
+                    r = vec4::add(r, vec4::cross(q, t));
+                    alignas(16) f32 values[4];
+                    vec4::store(values, r);
+                    return float3 { values[0], values[1], values[2] };
+                }
+            #endif
+            float3 u { this->x, this->y, this->z };
+            float3 t = u.cross(v);
+            t = t + t;
+            return v + t * this->w + u.cross(t);
         }
 
         constexpr f32 quaternion::dot(quaternion q) const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    return vec4::first(vec4::dot(vec4::load(this->values), vec4::load(q.values)));
+                }
+            #endif
             return this->x * q.x + this->y * q.y + this->z * q.z + this->w * q.w;
         }
 
         constexpr f32 quaternion::sqrMagnitude() const {
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::Register r = vec4::load(this->values);
+                    return vec4::first(vec4::dot(r, r));
+                }
+            #endif
             return this->x * this->x + this->y * this->y + this->z * this->z + this->w * this->w;
         }
         
         inline quaternion & quaternion::normalize() {
-            f32 mag = sqrMagnitude();
-            f32 root = fisqrt(mag);
-            this->x *= root;
-            this->y *= root;
-            this->z *= root;
-            this->w *= root;
-            return *this;
+            #if ACHILLES_SIMD_MATH
+                vec4::Register r = vec4::load(this->values);
+                vec4::store(this->values, vec4::mul(r, vec4::fisqrt(vec4::dot(r, r))));
+                return *this;
+            #else
+                f32 mag = sqrMagnitude();
+                f32 root = fisqrt(mag);
+                this->x *= root;
+                this->y *= root;
+                this->z *= root;
+                this->w *= root;
+                return *this;
+            #endif
         }
 
         inline quaternion quaternion::normalized() const {
-            f32 mag = sqrMagnitude();
-            f32 root = fisqrt(mag);
-            return quaternion(
-                this->x * root,
-                this->y * root,
-                this->z * root,
-                this->w * root
-            );
-        }
-
+            #if ACHILLES_SIMD_MATH
+                quaternion result;
+                vec4::Register r = vec4::load(this->values);
+                vec4::store(result.values, vec4::mul(r, vec4::fisqrt(vec4::dot(r, r))));
+                return result;
+            #else
+                f32 mag = sqrMagnitude();
+                f32 root = fisqrt(mag);
+                return quaternion(
+                    this->x * root,
+                    this->y * root,
+                    this->z * root,
+                    this->w * root
+                );
+            #endif
+        }
+
+        template<typename Precision>
         inline void quaternion::toAngleAxis(f32 &outAngle, float3 &outAxis) const {
             quaternion q;
             if (scalar > 1.0f) {
@@ -877,7 +1757,7 @@ namespace achilles {
             } else {
                 q = *this;
             }
-            outAngle = 2.0f * std::acos(q.scalar);
+            outAngle = 2.0f * Precision::acos(q.scalar);
             f32 s     = fisqrt(1.0f - q.scalar * q.scalar);
             outAxis = float3 { q.x, q.y, q.z };
             if (nearlyEqual(s, 0.0f, 0.001f)) {
@@ -887,10 +1767,11 @@ namespace achilles {
             }
         }
 
+        template<typename Precision>
         inline quaternion quaternion::fromAngleAxis(f32 angle, float3 axis) {
             axis.normalize();
-            f32 sin2 = std::sin(angle * 0.5f);
-            f32 cos2 = std::cos(angle * 0.5f);
+            f32 sin2, cos2;
+            Precision::sincos(angle * 0.5f, sin2, cos2);
             return quaternion {
                 axis.x * sin2,
                 axis.y * sin2,
@@ -903,34 +1784,64 @@ namespace achilles {
             return float4x4::lookAt(point, eye, up).toRotation();
         }
 
+        template<typename Precision>
         inline quaternion quaternion::fromEulerAngles(float3 angles) {
-            quaternion x = quaternion::fromAngleAxis(angles.x, float3::right());
-            quaternion y = quaternion::fromAngleAxis(angles.y, float3::up());
-            quaternion z = quaternion::fromAngleAxis(angles.z, float3::forward());
+            quaternion x = quaternion::fromAngleAxis<Precision>(angles.x, float3::right());
+            quaternion y = quaternion::fromAngleAxis<Precision>(angles.y, float3::up());
+            quaternion z = quaternion::fromAngleAxis<Precision>(angles.z, float3::forward());
 
             return x * y * z;
         }
 
+        template<typename Precision>
         inline float3 quaternion::toEulerAngles() const {
             float3 result;
 
             f32 xsc = 2.0f * (w * x + y * z);
             f32 xcc = 1.0f - 2.0f * (x * x + y * y);
-            result.x = std::atan2(xsc, xcc);
+            result.x = Precision::atan2(xsc, xcc);
 
             f32 sin = 2.0f * (w * y - z * x);
             if (abs(sin) >= 1.0f) {
                 result.y = (TAU / 4) * sign(sin);
             } else {
-                result.y = std::asin(sin);
+                result.y = Precision::asin(sin);
             }
 
             f32 zsc = 2.0f * (w * z + x * y);
             f32 zcc = 1.0f - 2.0f * (y * y + z * z);
-            result.z = std::atan2(zsc, zcc);
+            result.z = Precision::atan2(zsc, zcc);
 
             return result;
         }
+
+        // along the shorter arc, normalizing the blend. cheaper than 'slerp' but the speed along the arc isn't
+        // constant, which doesn't show for the small steps of animation blending
+        inline quaternion quaternion::nlerp(quaternion a, quaternion b, f32 t) {
+            if (a.dot(b) < 0.0f) b = quaternion { -b.x, -b.y, -b.z, -b.w };
+            f32 s = 1 - t;
+            return quaternion { s * a.x + t * b.x, s * a.y + t * b.y, s * a.z + t * b.z, s * a.w + t * b.w }.normalized();
+        }
+
+        // along the shorter arc at constant speed, falling back to 'nlerp' when the two are too close for the
+        // division by 'sin(theta)'
+        template<typename Precision>
+        inline quaternion quaternion::slerp(quaternion a, quaternion b, f32 t) {
+            f32 d = a.dot(b);
+            if (d < 0.0f) {
+                b = quaternion { -b.x, -b.y, -b.z, -b.w };
+                d = -d;
+            }
+            if (d > SLERP_THRESHOLD) {
+                f32 s = 1 - t;
+                return quaternion { s * a.x + t * b.x, s * a.y + t * b.y, s * a.z + t * b.z, s * a.w + t * b.w }.normalized();
+            }
+            f32 theta = Precision::acos(d);
+            f32 inverseSin = 1.0f / Precision::sin(theta);
+            f32 wa = Precision::sin((1 - t) * theta) * inverseSin;
+            f32 wb = Precision::sin(t * theta) * inverseSin;
+            return quaternion { wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z, wa * a.w + wb * b.w };
+        }
         
         constexpr float4x4 float4x4::operator +(float4x4 m) const {
             return float4x4(
@@ -1019,66 +1930,38 @@ namespace achilles {
             return *this;
         }
 
+        // every row of the result is the rows of 'm' weighted by a row of this one, so nothing is gathered
         constexpr float4x4 float4x4::operator *(float4x4 m) const {
-            auto ma = m.getColumn(0);
-            auto mb = m.getColumn(1);
-            auto mc = m.getColumn(2);
-            auto md = m.getColumn(3);
-
+            #if ACHILLES_SIMD_MATH
+                if (!std::is_constant_evaluated()) {
+                    vec4::Register a = vec4::load(m.values[0]);
+                    vec4::Register b = vec4::load(m.values[1]);
+                    vec4::Register c = vec4::load(m.values[2]);
+                    vec4::Register d = vec4::load(m.values[3]);
+                    float4x4 result;
+                    for (u32 i = 0; i < 4; ++i) {
+                        vec4::Register row = vec4::mul(vec4::splat(this->values[i][0]), a);
+                        row = vec4::mulAdd(vec4::splat(this->values[i][1]), b, row);
+                        row = vec4::mulAdd(vec4::splat(this->values[i][2]), c, row);
+                        row = vec4::mulAdd(vec4::splat(this->values[i][3]), d, row);
+                        vec4::store(result.values[i], row);
+                    }
+                    return result;
+                }
+            #endif
+            auto row = [&m](float4 r) {
+                return m.rows.a * r.x + m.rows.b * r.y + m.rows.c * r.z + m.rows.d * r.w;
+            };
             return float4x4 {
-                float4 {
-                    this->rows.a.dot(ma),
-                    this->rows.a.dot(mb),
-                    this->rows.a.dot(mc),
-                    this->rows.a.dot(md),
-                },
-                float4 {
-                    this->rows.b.dot(ma),
-                    this->rows.b.dot(mb),
-                    this->rows.b.dot(mc),
-                    this->rows.b.dot(md),
-                },
-                float4 {
-                    this->rows.c.dot(ma),
-                    this->rows.c.dot(mb),
-                    this->rows.c.dot(mc),
-                    this->rows.c.dot(md),
-                },
-                float4 {
-                    this->rows.d.dot(ma),
-                    this->rows.d.dot(mb),
-                    this->rows.d.dot(mc),
-                    this->rows.d.dot(md),
-                },
+                row(this->rows.a),
+                row(this->rows.b),
+                row(this->rows.c),
+                row(this->rows.d),
             };
         }
 
         constexpr float4x4 & float4x4::operator *=(float4x4 m) {
-            this->rows.a = float4 {
-                this->rows.a.dot(m.getColumn(0)),
-                this->rows.a.dot(m.getColumn(1)),
-                this->rows.a.dot(m.getColumn(2)),
-                this->rows.a.dot(m.getColumn(3)),
-            };
-            this->rows.b = float4 {
-                this->rows.b.dot(m.getColumn(0)),
-                this->rows.b.dot(m.getColumn(1)),
-                this->rows.b.dot(m.getColumn(2)),
-                this->rows.b.dot(m.getColumn(3)),
-            };
-            this->rows.c = float4 {
-                this->rows.c.dot(m.getColumn(0)),
-                this->rows.c.dot(m.getColumn(1)),
-                this->rows.c.dot(m.getColumn(2)),
-                this->rows.c.dot(m.getColumn(3)),
-            };
-            this->rows.d = float4 {
-                this->rows.d.dot(m.getColumn(0)),
-                this->rows.d.dot(m.getColumn(1)),
-                this->rows.d.dot(m.getColumn(2)),
-                this->rows.d.dot(m.getColumn(3)),
-            };
-
+            *this = *this * m;
             return *this;
         }
 
@@ -1156,6 +2039,99 @@ namespace achilles {
             };
         }
 
+        constexpr f32 float4x4::determinant() const {
+            float4 a = this->rows.a, b = this->rows.b, c = this->rows.c, d = this->rows.d;
+            f32 s0 = a.x * b.y - b.x * a.y;
+            f32 s1 = a.x * b.z - b.x * a.z;
+            f32 s2 = a.x * b.w - b.x * a.w;
+            f32 s3 = a.y * b.z - b.y * a.z;
+            f32 s4 = a.y * b.w - b.y * a.w;
+            f32 s5 = a.z * b.w - b.z * a.w;
+            f32 c5 = c.z * d.w - d.z * c.w;
+            f32 c4 = c.y * d.w - d.y * c.w;
+            f32 c3 = c.y * d.z - d.y * c.z;
+            f32 c2 = c.x * d.w - d.x * c.w;
+            f32 c1 = c.x * d.z - d.x * c.z;
+            f32 c0 = c.x * d.y - d.x * c.y;
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        }
+
+        // through the 2x2 minors of the top and bottom halves (laplace expansion), about a hundred flops and no
+        // branches. a singular matrix gives infinities, check 'determinant' first when that can happen
+        constexpr float4x4 float4x4::inversed() const {
+            float4 a = this->rows.a, b = this->rows.b, c = this->rows.c, d = this->rows.d;
+            f32 s0 = a.x * b.y - b.x * a.y;
+            f32 s1 = a.x * b.z - b.x * a.z;
+            f32 s2 = a.x * b.w - b.x * a.w;
+            f32 s3 = a.y * b.z - b.y * a.z;
+            f32 s4 = a.y * b.w - b.y * a.w;
+            f32 s5 = a.z * b.w - b.z * a.w;
+            f32 c5 = c.z * d.w - d.z * c.w;
+            f32 c4 = c.y * d.w - d.y * c.w;
+            f32 c3 = c.y * d.z - d.y * c.z;
+            f32 c2 = c.x * d.w - d.x * c.w;
+            f32 c1 = c.x * d.z - d.x * c.z;
+            f32 c0 = c.x * d.y - d.x * c.y;
+            f32 inverseDeterminant = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+            return float4x4 {
+                float4 {
+                    ( b.y * c5 - b.z * c4 + b.w * c3),
+                    (-a.y * c5 + a.z * c4 - a.w * c3),
+                    ( d.y * s5 - d.z * s4 + d.w * s3),
+                    (-c.y * s5 + c.z * s4 - c.w * s3),
+                } * inverseDeterminant,
+                float4 {
+                    (-b.x * c5 + b.z * c2 - b.w * c1),
+                    ( a.x * c5 - a.z * c2 + a.w * c1),
+                    (-d.x * s5 + d.z * s2 - d.w * s1),
+                    ( c.x * s5 - c.z * s2 + c.w * s1),
+                } * inverseDeterminant,
+                float4 {
+                    ( b.x * c4 - b.y * c2 + b.w * c0),
+                    (-a.x * c4 + a.y * c2 - a.w * c0),
+                    ( d.x * s4 - d.y * s2 + d.w * s0),
+                    (-c.x * s4 + c.y * s2 - c.w * s0),
+                } * inverseDeterminant,
+                float4 {
+                    (-b.x * c3 + b.y * c1 - b.z * c0),
+                    ( a.x * c3 - a.y * c1 + a.z * c0),
+                    (-d.x * s3 + d.y * s1 - d.z * s0),
+                    ( c.x * s3 - c.y * s1 + c.z * s0),
+                } * inverseDeterminant,
+            };
+        }
+
+        constexpr float4x4 & float4x4::inverse() {
+            *this = this->inversed();
+            return *this;
+        }
+
+        // for transforms whose last row is 0 0 0 1 (any mix of 'translate', 'scale' and rotations): inverts the
+        // 3x3 part through cross products of its columns and moves the translation back, about half the work
+        // of 'inversed'
+        constexpr float4x4 float4x4::affineInversed() const {
+            float3 x { this->rows.a.x, this->rows.b.x, this->rows.c.x };
+            float3 y { this->rows.a.y, this->rows.b.y, this->rows.c.y };
+            float3 z { this->rows.a.z, this->rows.b.z, this->rows.c.z };
+            float3 t { this->rows.a.w, this->rows.b.w, this->rows.c.w };
+
+            float3 a = y.cross(z);
+            float3 b = z.cross(x);
+            float3 c = x.cross(y);
+            f32 inverseDeterminant = 1.0f / x.dot(a);
+            a *= inverseDeterminant;
+            b *= inverseDeterminant;
+            c *= inverseDeterminant;
+
+            return float4x4 {
+                float4 { a.x, a.y, a.z, -a.dot(t) },
+                float4 { b.x, b.y, b.z, -b.dot(t) },
+                float4 { c.x, c.y, c.z, -c.dot(t) },
+                float4 { 0.0f, 0.0f, 0.0f, 1.0f },
+            };
+        }
+
         constexpr float4x4 float4x4::translation() const {
             return float4x4 {
                 { 1.0f, 0.0f, 0.0f, this->values[0][3] },
@@ -1200,8 +2176,9 @@ namespace achilles {
             };
         }
 
+        template<typename Precision>
         inline float4x4 float4x4::perspectiveDX(f32 fov, f32 aspectRatio, f32 near, f32 far) {
-            f32 tangent = std::tan(fov * 0.5f * DEG_TO_RAD);
+            f32 tangent = Precision::tan(fov * 0.5f * DEG_TO_RAD);
             f32 yScale = 1.0f / tangent;
             f32 xScale = yScale / aspectRatio;
             f32 a      = far / (far - near);
@@ -1216,8 +2193,9 @@ namespace achilles {
         }
         
 
+        template<typename Precision>
         inline float4x4 float4x4::perspectiveGL(f32 fov, f32 aspectRatio, f32 near, f32 far) {
-            f32 tangent = std::tan(fov * 0.5f);
+            f32 tangent = Precision::tan(fov * 0.5f);
             f32 yScale = 1.0f / tangent;
             f32 xScale = yScale / aspectRatio;
             f32 a      = - (far + near) / (far - near);
@@ -1290,13 +2268,12 @@ namespace achilles {
             };
         }
 
+        template<typename Precision>
         inline float4x4 float4x4::eulerAngles(float3 angles) {
-            f32 sinx = std::sin(angles.x * DEG_TO_RAD);
-            f32 cosx = std::cos(angles.x * DEG_TO_RAD);
-            f32 siny = std::sin(angles.y * DEG_TO_RAD);
-            f32 cosy = std::cos(angles.y * DEG_TO_RAD);
-            f32 sinz = std::sin(angles.z * DEG_TO_RAD);
-            f32 cosz = std::cos(angles.z * DEG_TO_RAD);
+            f32 sinx, cosx, siny, cosy, sinz, cosz;
+            Precision::sincos(angles.x * DEG_TO_RAD, sinx, cosx);
+            Precision::sincos(angles.y * DEG_TO_RAD, siny, cosy);
+            Precision::sincos(angles.z * DEG_TO_RAD, sinz, cosz);
 
             float4x4 result {};
 
@@ -1324,6 +2301,888 @@ namespace achilles {
             float4 w     = float4 { -xaxis.dot(eye), -yaxis.dot(eye), -zaxis.dot(eye), 1.0f };
             return float4x4 { xaxis, yaxis, zaxis, w };
         }
+
+        enum ClipDepth : u8 {
+            // direct3d, vulkan and metal, what 'perspectiveDX' and 'orthoDX' build
+            CLIP_ZERO_TO_ONE,
+            // opengl, what 'perspectiveGL' and 'orthoGL' build
+            CLIP_MINUS_ONE_TO_ONE,
+        };
+
+        // the points where 'dot(normal, point) + distance' is positive are in front of it
+        struct plane {
+            float3 normal;
+            f32 distance;
+
+            // scaled so 'normal' has length one, which makes 'distanceTo' a distance
+            static plane fromCoefficients(float4 coefficients) {
+                float3 normal = (float3) coefficients;
+                f32 inverse = 1.0f / std::sqrt(normal.sqrMagnitude());
+                return plane { normal * inverse, coefficients.w * inverse };
+            }
+
+            constexpr f32 distanceTo(float3 point) const {
+                return ((normal.x * point.x + normal.y * point.y) + normal.z * point.z) + distance;
+            }
+        };
+
+        struct sphere {
+            float3 center;
+            f32 radius;
+
+            constexpr bool contains(float3 point) const {
+                return (point - center).sqrMagnitude() <= radius * radius;
+            }
+        };
+
+        struct aabb {
+            float3 min;
+            float3 max;
+
+            constexpr float3 center() const {
+                return (min + max) * 0.5f;
+            }
+
+            // half the size on every axis
+            constexpr float3 extents() const {
+                return (max - min) * 0.5f;
+            }
+
+            constexpr bool contains(float3 point) const {
+                return point.x >= min.x && point.y >= min.y && point.z >= min.z
+                    && point.x <= max.x && point.y <= max.y && point.z <= max.z;
+            }
+
+            constexpr aabb merged(aabb other) const {
+                return aabb {
+                    float3 { math::min(min.x, other.min.x), math::min(min.y, other.min.y), math::min(min.z, other.min.z) },
+                    float3 { math::max(max.x, other.max.x), math::max(max.y, other.max.y), math::max(max.z, other.max.z) },
+                };
+            }
+
+            // the box around this one after 'matrix', growing it as needed to stay axis aligned (Arvo's method)
+            constexpr aabb transformed(float4x4 const &matrix) const {
+                float3 c = center();
+                float3 e = extents();
+                float3 newCenter = matrix * c;
+                float3 newExtents {
+                    math::abs(matrix.values[0][0]) * e.x + math::abs(matrix.values[0][1]) * e.y + math::abs(matrix.values[0][2]) * e.z,
+                    math::abs(matrix.values[1][0]) * e.x + math::abs(matrix.values[1][1]) * e.y + math::abs(matrix.values[1][2]) * e.z,
+                    math::abs(matrix.values[2][0]) * e.x + math::abs(matrix.values[2][1]) * e.y + math::abs(matrix.values[2][2]) * e.z,
+                };
+                return aabb { newCenter - newExtents, newCenter + newExtents };
+            }
+
+            sphere boundingSphere() const {
+                return sphere { center(), std::sqrt(extents().sqrMagnitude()) };
+            }
+
+            // the empty box when there are no points
+            static aabb fromPoints(memory::Slice<float3 const> points) {
+                if (points.size() == 0) return aabb { float3::zero(), float3::zero() };
+                aabb result { points[0], points[0] };
+                for (u64 i = 1; i < points.size(); ++i) {
+                    result = result.merged(aabb { points[i], points[i] });
+                }
+                return result;
+            }
+        };
+
+        // the six planes of a view volume, facing inwards: left, right, bottom, top, near, far
+        struct frustum {
+            plane planes[6];
+
+            // Gribb and Hartmann's extraction from a matrix used as 'clip * point', the way 'float4x4' multiplies.
+            // 'perspectiveDX' and 'lookAt' are laid out the other way around, for 'point * matrix', so pass
+            // '(view * projection).transposed()' for those
+            static frustum fromMatrix(float4x4 const &clip, ClipDepth depth = CLIP_ZERO_TO_ONE) {
+                float4 x = clip.rows.a, y = clip.rows.b, z = clip.rows.c, w = clip.rows.d;
+                return frustum { {
+                    plane::fromCoefficients(w + x),
+                    plane::fromCoefficients(w - x),
+                    plane::fromCoefficients(w + y),
+                    plane::fromCoefficients(w - y),
+                    plane::fromCoefficients(depth == CLIP_ZERO_TO_ONE ? z : w + z),
+                    plane::fromCoefficients(w - z),
+                } };
+            }
+
+            constexpr bool contains(float3 point) const {
+                for (u32 i = 0; i < 6; ++i) {
+                    if (planes[i].distanceTo(point) < 0.0f) return false;
+                }
+                return true;
+            }
+
+            // conservative, a sphere near a corner can pass without touching the frustum. the batch 'cullSpheres'
+            // gives the same answers
+            bool intersects(sphere s) const {
+                f32 nearest = planes[0].distanceTo(s.center) + s.radius;
+                for (u32 i = 1; i < 6; ++i) {
+                    f32 d = planes[i].distanceTo(s.center) + s.radius;
+                    nearest = d < nearest ? d : nearest;
+                }
+                return !std::signbit(nearest);
+            }
+
+            // conservative like the sphere test, the box is only rejected when it's behind one of the planes
+            bool intersects(aabb box) const {
+                return intersects(box.center(), box.extents());
+            }
+
+            // the box from its center and half size, see 'cullAABBs'
+            bool intersects(float3 center, float3 extents) const {
+                f32 nearest = 0.0f;
+                for (u32 i = 0; i < 6; ++i) {
+                    float3 n = planes[i].normal;
+                    f32 reach = (math::abs(n.x) * extents.x + math::abs(n.y) * extents.y) + math::abs(n.z) * extents.z;
+                    f32 d = planes[i].distanceTo(center) + reach;
+                    nearest = i == 0 || d < nearest ? d : nearest;
+                }
+                return !std::signbit(nearest);
+            }
+        };
+
+        // 'matrix * point' for every point of 'points' into 'result', which can be 'points' itself. four points
+        // go through the registers at a time
+        inline void transformPoints(float4x4 const &matrix, memory::Slice<float3 const> points, memory::Slice<float3> result) {
+            aassert(result.size() >= points.size(), "transform result is too small");
+            u64 count = points.size();
+            float3 const *input = (float3 const *) points;
+            float3 *output = (float3 *) result;
+            u64 i = 0;
+            #if ACHILLES_SIMD_MATH
+                static_assert(sizeof(float3) == 3 * sizeof(f32), "float3 must be tightly packed");
+                vec4::Register m[3][4];
+                for (u32 row = 0; row < 3; ++row) {
+                    for (u32 column = 0; column < 4; ++column) {
+                        m[row][column] = vec4::splat(matrix.values[row][column]);
+                    }
+                }
+                for (; i + 4 <= count; i += 4) {
+                    vec4::Register x, y, z;
+                    vec4::load3(input[i].values, x, y, z);
+                    vec4::Register transformed[3];
+                    for (u32 row = 0; row < 3; ++row) {
+                        vec4::Register r = vec4::mul(m[row][0], x);
+                        r = vec4::mulAdd(m[row][1], y, r);
+                        r = vec4::mulAdd(m[row][2], z, r);
+                        transformed[row] = vec4::add(r, m[row][3]);
+                    }
+                    vec4::store3(output[i].values, transformed[0], transformed[1], transformed[2]);
+                }
+            #endif
+            for (; i < count; ++i) {
+                output[i] = matrix * input[i];
+            }
+        }
+
+        inline void transformPoints(float4x4 const &matrix, memory::Slice<float3> points) {
+            transformPoints(matrix, memory::Slice<float3 const> { (float3 const *) points, points.size() }, points);
+        }
+
+        // structure of arrays versions of 'float3' and 'float4', one array per component, so the kernels below
+        // can go through 'wide::LANES' vectors at a time. the arrays are aligned for AVX
+        struct float3SoA {
+            using Lane = memory::Array<f32, memory::Allocator, 32>;
+
+            Lane x, y, z;
+
+            explicit float3SoA(memory::Allocator &allocator = memory::GlobalAllocator::instance(), u64 capacity = 0)
+                : x{allocator, capacity}, y{allocator, capacity}, z{allocator, capacity} {}
+
+            explicit float3SoA(memory::Slice<float3 const> values, memory::Allocator &allocator = memory::GlobalAllocator::instance())
+                : float3SoA{allocator, values.size()} {
+                pushMany(values);
+            }
+
+            u64 size() const {
+                return x.size();
+            }
+
+            bool reserve(u64 capacity) {
+                return x.reserve(capacity) && y.reserve(capacity) && z.reserve(capacity);
+            }
+
+            // new vectors are zero
+            bool resize(u64 size) {
+                return x.resize(size) && y.resize(size) && z.resize(size);
+            }
+
+            void clear() {
+                x.clear();
+                y.clear();
+                z.clear();
+            }
+
+            bool push(float3 v) {
+                if (!reserve(size() + 1)) return false;
+                x.push(v.x);
+                y.push(v.y);
+                z.push(v.z);
+                return true;
+            }
+
+            float3 get(u64 index) const {
+                return float3 { x[index], y[index], z[index] };
+            }
+
+            void set(u64 index, float3 v) {
+                x[index] = v.x;
+                y[index] = v.y;
+                z[index] = v.z;
+            }
+
+            // appends 'values', splitting the components four vectors at a time
+            bool pushMany(memory::Slice<float3 const> values) {
+                u64 offset = size();
+                u64 count = values.size();
+                if (!resize(offset + count)) return false;
+                float3 const *input = (float3 const *) values;
+                f32 *xs = lane(x) + offset, *ys = lane(y) + offset, *zs = lane(z) + offset;
+                u64 i = 0;
+                #if ACHILLES_SIMD_MATH
+                    for (; i + 4 <= count; i += 4) {
+                        vec4::Register vx, vy, vz;
+                        vec4::load3(input[i].values, vx, vy, vz);
+                        vec4::storeUnaligned(xs + i, vx);
+                        vec4::storeUnaligned(ys + i, vy);
+                        vec4::storeUnaligned(zs + i, vz);
+                    }
+                #endif
+                for (; i < count; ++i) {
+                    xs[i] = input[i].x;
+                    ys[i] = input[i].y;
+                    zs[i] = input[i].z;
+                }
+                return true;
+            }
+
+            // writes the vectors back as 'float3's, 'result' has to hold 'size()' of them
+            void copyTo(memory::Slice<float3> result) const {
+                aassert(result.size() >= size(), "soa copy result is too small");
+                u64 count = size();
+                float3 *output = (float3 *) result;
+                f32 const *xs = lane(x), *ys = lane(y), *zs = lane(z);
+                u64 i = 0;
+                #if ACHILLES_SIMD_MATH
+                    for (; i + 4 <= count; i += 4) {
+                        vec4::store3(output[i].values, vec4::loadUnaligned(xs + i), vec4::loadUnaligned(ys + i), vec4::loadUnaligned(zs + i));
+                    }
+                #endif
+                for (; i < count; ++i) {
+                    output[i] = float3 { xs[i], ys[i], zs[i] };
+                }
+            }
+
+            static f32 *lane(Lane const &values) {
+                return values.size() > 0 ? &values[0] : nullptr;
+            }
+        };
+
+        struct float4SoA {
+            using Lane = memory::Array<f32, memory::Allocator, 32>;
+
+            Lane x, y, z, w;
+
+            explicit float4SoA(memory::Allocator &allocator = memory::GlobalAllocator::instance(), u64 capacity = 0)
+                : x{allocator, capacity}, y{allocator, capacity}, z{allocator, capacity}, w{allocator, capacity} {}
+
+            explicit float4SoA(memory::Slice<float4 const> values, memory::Allocator &allocator = memory::GlobalAllocator::instance())
+                : float4SoA{allocator, values.size()} {
+                pushMany(values);
+            }
+
+            u64 size() const {
+                return x.size();
+            }
+
+            bool reserve(u64 capacity) {
+                return x.reserve(capacity) && y.reserve(capacity) && z.reserve(capacity) && w.reserve(capacity);
+            }
+
+            bool resize(u64 size) {
+                return x.resize(size) && y.resize(size) && z.resize(size) && w.resize(size);
+            }
+
+            void clear() {
+                x.clear();
+                y.clear();
+                z.clear();
+                w.clear();
+            }
+
+            bool push(float4 v) {
+                if (!reserve(size() + 1)) return false;
+                x.push(v.x);
+                y.push(v.y);
+                z.push(v.z);
+                w.push(v.w);
+                return true;
+            }
+
+            float4 get(u64 index) const {
+                return float4 { x[index], y[index], z[index], w[index] };
+            }
+
+            void set(u64 index, float4 v) {
+                x[index] = v.x;
+                y[index] = v.y;
+                z[index] = v.z;
+                w[index] = v.w;
+            }
+
+            // appends 'values', transposing four vectors at a time
+            bool pushMany(memory::Slice<float4 const> values) {
+                u64 offset = size();
+                u64 count = values.size();
+                if (!resize(offset + count)) return false;
+                float4 const *input = (float4 const *) values;
+                f32 *xs = lane(x) + offset, *ys = lane(y) + offset, *zs = lane(z) + offset, *ws = lane(w) + offset;
+                u64 i = 0;
+                #if ACHILLES_SIMD_MATH
+                    for (; i + 4 <= count; i += 4) {
+                        vec4::Register vx, vy, vz, vw;
+                        vec4::load4(input[i].values, vx, vy, vz, vw);
+                        vec4::storeUnaligned(xs + i, vx);
+                        vec4::storeUnaligned(ys + i, vy);
+                        vec4::storeUnaligned(zs + i, vz);
+                        vec4::storeUnaligned(ws + i, vw);
+                    }
+                #endif
+                for (; i < count; ++i) {
+                    xs[i] = input[i].x;
+                    ys[i] = input[i].y;
+                    zs[i] = input[i].z;
+                    ws[i] = input[i].w;
+                }
+                return true;
+            }
+
+            void copyTo(memory::Slice<float4> result) const {
+                aassert(result.size() >= size(), "soa copy result is too small");
+                u64 count = size();
+                float4 *output = (float4 *) result;
+                f32 const *xs = lane(x), *ys = lane(y), *zs = lane(z), *ws = lane(w);
+                u64 i = 0;
+                #if ACHILLES_SIMD_MATH
+                    for (; i + 4 <= count; i += 4) {
+                        vec4::store4(output[i].values, vec4::loadUnaligned(xs + i), vec4::loadUnaligned(ys + i), vec4::loadUnaligned(zs + i), vec4::loadUnaligned(ws + i));
+                    }
+                #endif
+                for (; i < count; ++i) {
+                    output[i] = float4 { xs[i], ys[i], zs[i], ws[i] };
+                }
+            }
+
+            static f32 *lane(Lane const &values) {
+                return values.size() > 0 ? &values[0] : nullptr;
+            }
+        };
+
+        // the batch kernels. every one of them takes its inputs and a result of the same size, which can be one
+        // of the inputs, and gives the same values as the scalar function it's named after
+        namespace batch {
+            // 'result[i] = f(a[i], ...)' over one lane of floats, 'wide' and 'scalar' being the same operation
+            template<typename W, typename S>
+            inline void map(u64 count, f32 *result, W &&wideOp, S &&scalarOp, f32 const *a, f32 const *b = nullptr) {
+                u64 i = 0;
+                for (; i + wide::LANES <= count; i += wide::LANES) {
+                    wide::store(result + i, b ? wideOp(wide::load(a + i), wide::load(b + i)) : wideOp(wide::load(a + i), wide::Register {}));
+                }
+                for (; i < count; ++i) {
+                    result[i] = scalarOp(a[i], b ? b[i] : 0.0f);
+                }
+            }
+
+            template<typename SoA, typename W, typename S>
+            inline void mapComponents(SoA const &a, SoA const *b, SoA &result, W &&wideOp, S &&scalarOp) {
+                aassert(result.size() == a.size() && (b == nullptr || b->size() == a.size()), "soa kernel sizes differ");
+                auto component = [&](typename SoA::Lane const &in, typename SoA::Lane const *other, typename SoA::Lane &out) {
+                    map(a.size(), SoA::lane(out), wideOp, scalarOp, SoA::lane(in), other ? SoA::lane(*other) : nullptr);
+                };
+                component(a.x, b ? &b->x : nullptr, result.x);
+                component(a.y, b ? &b->y : nullptr, result.y);
+                component(a.z, b ? &b->z : nullptr, result.z);
+                if constexpr (std::is_same_v<SoA, float4SoA>) component(a.w, b ? &b->w : nullptr, result.w);
+            }
+        }
+
+        template<typename SoA>
+        concept VectorSoA = std::is_same_v<SoA, float3SoA> || std::is_same_v<SoA, float4SoA>;
+
+        template<VectorSoA SoA>
+        inline void add(SoA const &a, SoA const &b, SoA &result) {
+            batch::mapComponents(a, &b, result,
+                [](wide::Register x, wide::Register y) { return wide::add(x, y); },
+                [](f32 x, f32 y) { return x + y; });
+        }
+
+        template<VectorSoA SoA>
+        inline void sub(SoA const &a, SoA const &b, SoA &result) {
+            batch::mapComponents(a, &b, result,
+                [](wide::Register x, wide::Register y) { return wide::sub(x, y); },
+                [](f32 x, f32 y) { return x - y; });
+        }
+
+        template<VectorSoA SoA>
+        inline void mul(SoA const &a, f32 scalar, SoA &result) {
+            wide::Register s = wide::splat(scalar);
+            batch::mapComponents(a, (SoA const *) nullptr, result,
+                [s](wide::Register x, wide::Register) { return wide::mul(x, s); },
+                [scalar](f32 x, f32) { return x * scalar; });
+        }
+
+        // 'a * scalar + b', e.g. 'mulAdd(velocities, dt, positions, positions)'. fused when the target has FMA
+        template<VectorSoA SoA>
+        inline void mulAdd(SoA const &a, f32 scalar, SoA const &b, SoA &result) {
+            wide::Register s = wide::splat(scalar);
+            batch::mapComponents(a, &b, result,
+                [s](wide::Register x, wide::Register y) { return wide::mulAdd(x, s, y); },
+                [scalar](f32 x, f32 y) { return x * scalar + y; });
+        }
+
+        template<VectorSoA SoA>
+        inline void lerp(SoA const &a, SoA const &b, f32 t, SoA &result) {
+            wide::Register s = wide::splat(1 - t);
+            wide::Register u = wide::splat(t);
+            batch::mapComponents(a, &b, result,
+                [s, u](wide::Register x, wide::Register y) { return wide::add(wide::mul(s, x), wide::mul(u, y)); },
+                [t](f32 x, f32 y) { return lerp(x, y, t); });
+        }
+
+        // every component clamped to [min, max]
+        template<VectorSoA SoA>
+        inline void clamp(SoA const &a, f32 min, f32 max, SoA &result) {
+            wide::Register low = wide::splat(min);
+            wide::Register high = wide::splat(max);
+            batch::mapComponents(a, (SoA const *) nullptr, result,
+                [low, high](wide::Register x, wide::Register) { return wide::min(wide::max(x, low), high); },
+                [min, max](f32 x, f32) { return clamp(x, min, max); });
+        }
+
+        template<VectorSoA SoA>
+        inline void clamp01(SoA const &a, SoA &result) {
+            clamp(a, 0.0f, 1.0f, result);
+        }
+
+        // every component remapped from [inMin, inMax] to [outMin, outMax]
+        template<VectorSoA SoA>
+        inline void remap(SoA const &a, f32 inMin, f32 inMax, f32 outMin, f32 outMax, SoA &result) {
+            if (inMin == inMax) {
+                // 'inverseLerp' gives zero for an empty range, so everything lands on 'outMin'
+                batch::mapComponents(a, (SoA const *) nullptr, result,
+                    [outMin](wide::Register, wide::Register) { return wide::splat(outMin); },
+                    [outMin](f32, f32) { return outMin; });
+                return;
+            }
+            wide::Register low = wide::splat(inMin);
+            wide::Register range = wide::splat(inMax - inMin);
+            wide::Register from = wide::splat(outMin);
+            wide::Register to = wide::splat(outMax);
+            wide::Register one = wide::splat(1.0f);
+            batch::mapComponents(a, (SoA const *) nullptr, result,
+                [=](wide::Register x, wide::Register) {
+                    wide::Register t = wide::div(wide::sub(x, low), range);
+                    return wide::add(wide::mul(wide::sub(one, t), from), wide::mul(t, to));
+                },
+                [=](f32 x, f32) { return remap(inMin, inMax, outMin, outMax, x); });
+        }
+
+        inline void dot(float3SoA const &a, float3SoA const &b, memory::Slice<f32> result) {
+            aassert(a.size() == b.size() && result.size() >= a.size(), "soa kernel sizes differ");
+            f32 const *ax = float3SoA::lane(a.x), *ay = float3SoA::lane(a.y), *az = float3SoA::lane(a.z);
+            f32 const *bx = float3SoA::lane(b.x), *by = float3SoA::lane(b.y), *bz = float3SoA::lane(b.z);
+            f32 *out = (f32 *) result;
+            u64 count = a.size();
+            u64 i = 0;
+            for (; i + wide::LANES <= count; i += wide::LANES) {
+                wide::Register d = wide::mul(wide::load(ax + i), wide::load(bx + i));
+                d = wide::add(d, wide::mul(wide::load(ay + i), wide::load(by + i)));
+                d = wide::add(d, wide::mul(wide::load(az + i), wide::load(bz + i)));
+                wide::store(out + i, d);
+            }
+            for (; i < count; ++i) {
+                out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+            }
+        }
+
+        inline void dot(float4SoA const &a, float4SoA const &b, memory::Slice<f32> result) {
+            aassert(a.size() == b.size() && result.size() >= a.size(), "soa kernel sizes differ");
+            f32 const *ax = float4SoA::lane(a.x), *ay = float4SoA::lane(a.y), *az = float4SoA::lane(a.z), *aw = float4SoA::lane(a.w);
+            f32 const *bx = float4SoA::lane(b.x), *by = float4SoA::lane(b.y), *bz = float4SoA::lane(b.z), *bw = float4SoA::lane(b.w);
+            f32 *out = (f32 *) result;
+            u64 count = a.size();
+            u64 i = 0;
+            for (; i + wide::LANES <= count; i += wide::LANES) {
+                wide::Register d = wide::mul(wide::load(ax + i), wide::load(bx + i));
+                d = wide::add(d, wide::mul(wide::load(ay + i), wide::load(by + i)));
+                d = wide::add(d, wide::mul(wide::load(az + i), wide::load(bz + i)));
+                d = wide::add(d, wide::mul(wide::load(aw + i), wide::load(bw + i)));
+                wide::store(out + i, d);
+            }
+            for (; i < count; ++i) {
+                out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+            }
+        }
+
+        // 'result' can't be one of the inputs
+        inline void cross(float3SoA const &a, float3SoA const &b, float3SoA &result) {
+            aassert(a.size() == b.size() && result.size() == a.size(), "soa kernel sizes differ");
+            aassert(&result != &a && &result != &b, "soa cross product can't be in place");
+            f32 const *ax = float3SoA::lane(a.x), *ay = float3SoA::lane(a.y), *az = float3SoA::lane(a.z);
+            f32 const *bx = float3SoA::lane(b.x), *by = float3SoA::lane(b.y), *bz = float3SoA::lane(b.z);
+            f32 *rx = float3SoA::lane(result.x), *ry = float3SoA::lane(result.y), *rz = float3SoA::lane(result.z);
+            u64 count = a.size();
+            u64 i = 0;
+            for (; i + wide::LANES <= count; i += wide::LANES) {
+                wide::Register x0 = wide::load(ax + i), y0 = wide::load(ay + i), z0 = wide::load(az + i);
+                wide::Register x1 = wide::load(bx + i), y1 = wide::load(by + i), z1 = wide::load(bz + i);
+                wide::store(rx + i, wide::sub(wide::mul(y0, z1), wide::mul(z0, y1)));
+                wide::store(ry + i, wide::sub(wide::mul(z0, x1), wide::mul(x0, z1)));
+                wide::store(rz + i, wide::sub(wide::mul(x0, y1), wide::mul(y0, x1)));
+            }
+            for (; i < count; ++i) {
+                float3 c = float3 { ax[i], ay[i], az[i] }.cross(float3 { bx[i], by[i], bz[i] });
+                rx[i] = c.x;
+                ry[i] = c.y;
+                rz[i] = c.z;
+            }
+        }
+
+        // like 'float3::normalized', through 'fisqrt'
+        inline void normalize(float3SoA const &a, float3SoA &result) {
+            aassert(result.size() == a.size(), "soa kernel sizes differ");
+            f32 const *ax = float3SoA::lane(a.x), *ay = float3SoA::lane(a.y), *az = float3SoA::lane(a.z);
+            f32 *rx = float3SoA::lane(result.x), *ry = float3SoA::lane(result.y), *rz = float3SoA::lane(result.z);
+            u64 count = a.size();
+            u64 i = 0;
+            for (; i + wide::LANES <= count; i += wide::LANES) {
+                wide::Register x = wide::load(ax + i), y = wide::load(ay + i), z = wide::load(az + i);
+                wide::Register root = wide::fisqrt(wide::add(wide::add(wide::mul(x, x), wide::mul(y, y)), wide::mul(z, z)));
+                wide::store(rx + i, wide::mul(x, root));
+                wide::store(ry + i, wide::mul(y, root));
+                wide::store(rz + i, wide::mul(z, root));
+            }
+            for (; i < count; ++i) {
+                float3 n = float3 { ax[i], ay[i], az[i] }.normalized();
+                rx[i] = n.x;
+                ry[i] = n.y;
+                rz[i] = n.z;
+            }
+        }
+
+        inline void normalize(float4SoA const &a, float4SoA &result) {
+            aassert(result.size() == a.size(), "soa kernel sizes differ");
+            f32 const *ax = float4SoA::lane(a.x), *ay = float4SoA::lane(a.y), *az = float4SoA::lane(a.z), *aw = float4SoA::lane(a.w);
+            f32 *rx = float4SoA::lane(result.x), *ry = float4SoA::lane(result.y), *rz = float4SoA::lane(result.z), *rw = float4SoA::lane(result.w);
+            u64 count = a.size();
+            u64 i = 0;
+            for (; i + wide::LANES <= count; i += wide::LANES) {
+                wide::Register x = wide::load(ax + i), y = wide::load(ay + i), z = wide::load(az + i), w = wide::load(aw + i);
+                wide::Register root = wide::fisqrt(wide::add(wide::add(wide::add(wide::mul(x, x), wide::mul(y, y)), wide::mul(z, z)), wide::mul(w, w)));
+                wide::store(rx + i, wide::mul(x, root));
+                wide::store(ry + i, wide::mul(y, root));
+                wide::store(rz + i, wide::mul(z, root));
+                wide::store(rw + i, wide::mul(w, root));
+            }
+            for (; i < count; ++i) {
+                float4 n = float4 { ax[i], ay[i], az[i], aw[i] }.normalized();
+                rx[i] = n.x;
+                ry[i] = n.y;
+                rz[i] = n.z;
+                rw[i] = n.w;
+            }
+        }
+
+        // 'Precision::sincos' of every angle, a 'wide::Register' at a time
+        template<typename Precision = Fast>
+        inline void sincos(memory::Slice<f32 const> angles, memory::Slice<f32> sines, memory::Slice<f32> cosines) {
+            aassert(sines.size() >= angles.size() && cosines.size() >= angles.size(), "batch sizes differ");
+            f32 const *in = (f32 const *) angles;
+            f32 *outSin = (f32 *) sines;
+            f32 *outCos = (f32 *) cosines;
+            u64 count = angles.size();
+            u64 i = 0;
+            for (; i + wide::LANES <= count; i += wide::LANES) {
+                wide::Register s, c;
+                Precision::sincos(wide::load(in + i), s, c);
+                wide::store(outSin + i, s);
+                wide::store(outCos + i, c);
+            }
+            for (; i < count; ++i) {
+                Precision::sincos(in[i], outSin[i], outCos[i]);
+            }
+        }
+
+        template<typename Precision = Fast>
+        inline void atan2(memory::Slice<f32 const> y, memory::Slice<f32 const> x, memory::Slice<f32> result) {
+            aassert(x.size() == y.size() && result.size() >= y.size(), "batch sizes differ");
+            batch::map(y.size(), (f32 *) result,
+                [](wide::Register a, wide::Register b) { return Precision::atan2(a, b); },
+                [](f32 a, f32 b) { return Precision::atan2(a, b); },
+                (f32 const *) y, (f32 const *) x);
+        }
+
+        template<typename Precision = Fast>
+        inline void acos(memory::Slice<f32 const> values, memory::Slice<f32> result) {
+            aassert(result.size() >= values.size(), "batch sizes differ");
+            batch::map(values.size(), (f32 *) result,
+                [](wide::Register a, wide::Register) { return Precision::acos(a); },
+                [](f32 a, f32) { return Precision::acos(a); },
+                (f32 const *) values);
+        }
+
+        template<typename Precision = Fast>
+        inline void rsqrt(memory::Slice<f32 const> values, memory::Slice<f32> result) {
+            aassert(result.size() >= values.size(), "batch sizes differ");
+            batch::map(values.size(), (f32 *) result,
+                [](wide::Register a, wide::Register) { return Precision::rsqrt(a); },
+                [](f32 a, f32) { return Precision::rsqrt(a); },
+                (f32 const *) values);
+        }
+
+        // 'quaternion::nlerp' of every pair 'a[i]', 'b[i]' into 'result[i]', which can be 'a' or 'b'. four pairs
+        // at a time go through transposed registers
+        inline void nlerp(memory::Slice<quaternion const> a, memory::Slice<quaternion const> b, f32 t, memory::Slice<quaternion> result) {
+            aassert(a.size() == b.size() && result.size() >= a.size(), "quaternion batch sizes differ");
+            quaternion const *first = (quaternion const *) a;
+            quaternion const *second = (quaternion const *) b;
+            quaternion *output = (quaternion *) result;
+            u64 count = a.size();
+            u64 i = 0;
+            #if ACHILLES_SIMD_MATH
+                vec4::Register s = vec4::splat(1 - t);
+                vec4::Register u = vec4::splat(t);
+                for (; i + 4 <= count; i += 4) {
+                    vec4::Register ax, ay, az, aw, bx, by, bz, bw;
+                    vec4::load4(first[i].values, ax, ay, az, aw);
+                    vec4::load4(second[i].values, bx, by, bz, bw);
+                    vec4::Register d = vec4::add(vec4::add(vec4::add(vec4::mul(ax, bx), vec4::mul(ay, by)), vec4::mul(az, bz)), vec4::mul(aw, bw));
+                    vec4::Register rx = vec4::add(vec4::mul(s, ax), vec4::mul(u, vec4::flipIfNegative(bx, d)));
+                    vec4::Register ry = vec4::add(vec4::mul(s, ay), vec4::mul(u, vec4::flipIfNegative(by, d)));
+                    vec4::Register rz = vec4::add(vec4::mul(s, az), vec4::mul(u, vec4::flipIfNegative(bz, d)));
+                    vec4::Register rw = vec4::add(vec4::mul(s, aw), vec4::mul(u, vec4::flipIfNegative(bw, d)));
+                    vec4::Register root = vec4::fisqrt(vec4::add(vec4::add(vec4::add(vec4::mul(rx, rx), vec4::mul(ry, ry)), vec4::mul(rz, rz)), vec4::mul(rw, rw)));
+                    vec4::store4(output[i].values, vec4::mul(rx, root), vec4::mul(ry, root), vec4::mul(rz, root), vec4::mul(rw, root));
+                }
+            #endif
+            for (; i < count; ++i) {
+                output[i] = quaternion::nlerp(first[i], second[i], t);
+            }
+        }
+
+        // 'quaternion::slerp<Precision>' of every pair. with 'Fast' or 'Approximate' everything runs on four lanes,
+        // with 'Precise' the angles are still taken lane by lane
+        template<typename Precision = Precise>
+        inline void slerp(memory::Slice<quaternion const> a, memory::Slice<quaternion const> b, f32 t, memory::Slice<quaternion> result) {
+            aassert(a.size() == b.size() && result.size() >= a.size(), "quaternion batch sizes differ");
+            quaternion const *first = (quaternion const *) a;
+            quaternion const *second = (quaternion const *) b;
+            quaternion *output = (quaternion *) result;
+            u64 count = a.size();
+            u64 i = 0;
+            #if ACHILLES_SIMD_MATH
+                for (; i + 4 <= count; i += 4) {
+                    vec4::Register ax, ay, az, aw, bx, by, bz, bw;
+                    vec4::load4(first[i].values, ax, ay, az, aw);
+                    vec4::load4(second[i].values, bx, by, bz, bw);
+                    vec4::Register d = vec4::add(vec4::add(vec4::add(vec4::mul(ax, bx), vec4::mul(ay, by)), vec4::mul(az, bz)), vec4::mul(aw, bw));
+                    bx = vec4::flipIfNegative(bx, d);
+                    by = vec4::flipIfNegative(by, d);
+                    bz = vec4::flipIfNegative(bz, d);
+                    bw = vec4::flipIfNegative(bw, d);
+
+                    // the lanes too close for the division by 'sin(theta)' fall back to a normalized lerp
+                    vec4::Register cosine = vec4::flipIfNegative(d, d);
+                    vec4::Mask near = vec4::less(vec4::splat(SLERP_THRESHOLD), cosine);
+                    vec4::Register wa, wb;
+                    if constexpr (std::is_same_v<Precision, Precise>) {
+                        alignas(16) f32 cosines[4];
+                        alignas(16) f32 weightsA[4];
+                        alignas(16) f32 weightsB[4];
+                        vec4::store(cosines, cosine);
+                        for (u32 k = 0; k < 4; ++k) {
+                            f32 theta = std::acos(cosines[k]);
+                            f32 inverseSin = 1.0f / std::sin(theta);
+                            weightsA[k] = std::sin((1 - t) * theta) * inverseSin;
+                            weightsB[k] = std::sin(t * theta) * inverseSin;
+                        }
+                        wa = vec4::load(weightsA);
+                        wb = vec4::load(weightsB);
+                    } else {
+                        vec4::Register theta = Precision::acos(cosine);
+                        vec4::Register inverseSin = vec4::div(vec4::splat(1.0f), Precision::sin(theta));
+                        wa = vec4::mul(Precision::sin(vec4::mul(vec4::splat(1 - t), theta)), inverseSin);
+                        wb = vec4::mul(Precision::sin(vec4::mul(vec4::splat(t), theta)), inverseSin);
+                    }
+                    wa = vec4::select(near, vec4::splat(1 - t), wa);
+                    wb = vec4::select(near, vec4::splat(t), wb);
+                    vec4::Register rx = vec4::add(vec4::mul(wa, ax), vec4::mul(wb, bx));
+                    vec4::Register ry = vec4::add(vec4::mul(wa, ay), vec4::mul(wb, by));
+                    vec4::Register rz = vec4::add(vec4::mul(wa, az), vec4::mul(wb, bz));
+                    vec4::Register rw = vec4::add(vec4::mul(wa, aw), vec4::mul(wb, bw));
+
+                    vec4::Register root = vec4::fisqrt(vec4::add(vec4::add(vec4::add(vec4::mul(rx, rx), vec4::mul(ry, ry)), vec4::mul(rz, rz)), vec4::mul(rw, rw)));
+                    root = vec4::select(near, root, vec4::splat(1.0f));
+                    vec4::store4(output[i].values, vec4::mul(rx, root), vec4::mul(ry, root), vec4::mul(rz, root), vec4::mul(rw, root));
+                }
+            #endif
+            for (; i < count; ++i) {
+                output[i] = quaternion::slerp<Precision>(first[i], second[i], t);
+            }
+        }
+
+        // 'fromRotation' of every rotation, 'Rows' being 4 for 'float4x4' and 3 for 'float3x4'
+        template<typename M, u32 Rows>
+        inline void rotationsToMatrices(memory::Slice<quaternion const> rotations, memory::Slice<M> result) {
+            aassert(result.size() >= rotations.size(), "matrix batch result is too small");
+            quaternion const *input = (quaternion const *) rotations;
+            M *output = (M *) result;
+            u64 count = rotations.size();
+            u64 i = 0;
+            #if ACHILLES_SIMD_MATH
+                vec4::Register one = vec4::splat(1.0f);
+                vec4::Register zero = vec4::splat(0.0f);
+                for (; i + 4 <= count; i += 4) {
+                    vec4::Register x, y, z, w;
+                    vec4::load4(input[i].values, x, y, z, w);
+                    vec4::Register x2 = vec4::add(x, x);
+                    vec4::Register y2 = vec4::add(y, y);
+                    vec4::Register z2 = vec4::add(z, z);
+                    vec4::Register yy = vec4::mul(y, y2);
+                    vec4::Register xy = vec4::mul(x, y2);
+                    vec4::Register xz = vec4::mul(x, z2);
+                    vec4::Register yz = vec4::mul(y, z2);
+                    vec4::Register zz = vec4::mul(z, z2);
+                    vec4::Register wz = vec4::mul(w, z2);
+                    vec4::Register wy = vec4::mul(w, y2);
+                    vec4::Register wx = vec4::mul(w, x2);
+                    vec4::Register xx = vec4::mul(x, x2);
+
+                    // one register per matrix element across the four matrices, transposed into rows
+                    vec4::Register rows[3][4] = {
+                        { vec4::sub(vec4::sub(one, yy), zz), vec4::sub(xy, wz), vec4::add(xz, wy), zero },
+                        { vec4::add(xy, wz), vec4::sub(vec4::sub(one, xx), zz), vec4::sub(yz, wx), zero },
+                        { vec4::sub(xz, wy), vec4::add(yz, wx), vec4::sub(vec4::sub(one, xx), yy), zero },
+                    };
+                    for (u32 row = 0; row < 3; ++row) {
+                        vec4::transpose(rows[row][0], rows[row][1], rows[row][2], rows[row][3]);
+                        for (u32 k = 0; k < 4; ++k) {
+                            vec4::store(output[i + k].values[row], rows[row][k]);
+                        }
+                    }
+                    if constexpr (Rows == 4) {
+                        for (u32 k = 0; k < 4; ++k) {
+                            output[i + k].rows.d = float4 { 0.0f, 0.0f, 0.0f, 1.0f };
+                        }
+                    }
+                }
+            #endif
+            for (; i < count; ++i) {
+                output[i] = M::fromRotation(input[i]);
+            }
+        }
+
+        inline void toMatrices(memory::Slice<quaternion const> rotations, memory::Slice<float4x4> result) {
+            rotationsToMatrices<float4x4, 4>(rotations, result);
+        }
+
+        inline void toMatrices(memory::Slice<quaternion const> rotations, memory::Slice<float3x4> result) {
+            rotationsToMatrices<float3x4, 3>(rotations, result);
+        }
+
+        namespace batch {
+            // the planes of a frustum in registers, '|normal|' for the box test
+            struct FrustumLanes {
+                wide::Register x[6], y[6], z[6], distance[6];
+                wide::Register absX[6], absY[6], absZ[6];
+
+                explicit FrustumLanes(frustum const &view) {
+                    for (u32 i = 0; i < 6; ++i) {
+                        plane p = view.planes[i];
+                        x[i] = wide::splat(p.normal.x);
+                        y[i] = wide::splat(p.normal.y);
+                        z[i] = wide::splat(p.normal.z);
+                        distance[i] = wide::splat(p.distance);
+                        absX[i] = wide::splat(math::abs(p.normal.x));
+                        absY[i] = wide::splat(math::abs(p.normal.y));
+                        absZ[i] = wide::splat(math::abs(p.normal.z));
+                    }
+                }
+
+                wide::Register distanceTo(u32 i, wide::Register px, wide::Register py, wide::Register pz) const {
+                    return wide::add(wide::add(wide::add(wide::mul(x[i], px), wide::mul(y[i], py)), wide::mul(z[i], pz)), distance[i]);
+                }
+            };
+
+            // clears the bits of 'visible' for 'count' objects and then sets those 'batchTest' or 'test' pass,
+            // 'wide::LANES' objects at a time
+            template<typename W, typename S>
+            inline u64 cull(u64 count, memory::Slice<u64> visible, W &&batchTest, S &&test) {
+                aassert(visible.size() * 64 >= count, "cull bitmask is too small");
+                u64 *bits = (u64 *) visible;
+                for (u64 word = 0; word < (count + 63) / 64; ++word) {
+                    bits[word] = 0;
+                }
+                constexpr u64 full = (1ull << wide::LANES) - 1;
+                u64 passed = 0;
+                u64 i = 0;
+                for (; i + wide::LANES <= count; i += wide::LANES) {
+                    u64 mask = ~(u64) wide::signBits(batchTest(i)) & full;
+                    bits[i / 64] |= mask << (i % 64);
+                    passed += std::popcount(mask);
+                }
+                for (; i < count; ++i) {
+                    if (!test(i)) continue;
+                    bits[i / 64] |= 1ull << (i % 64);
+                    ++passed;
+                }
+                return passed;
+            }
+        }
+
+        // sets bit 'i % 64' of 'visible[i / 64]' for every sphere that passes 'frustum::intersects' and clears the
+        // rest, 'visible' needs a bit per sphere. 'spheres' hold the centers in x, y, z and the radii in w. runs
+        // eight spheres at a time with AVX2, four with SSE or NEON, and returns how many passed
+        inline u64 cullSpheres(frustum const &view, float4SoA const &spheres, memory::Slice<u64> visible) {
+            f32 const *xs = float4SoA::lane(spheres.x), *ys = float4SoA::lane(spheres.y);
+            f32 const *zs = float4SoA::lane(spheres.z), *radii = float4SoA::lane(spheres.w);
+            batch::FrustumLanes planes { view };
+            return batch::cull(spheres.size(), visible,
+                [&](u64 i) {
+                    wide::Register x = wide::load(xs + i), y = wide::load(ys + i), z = wide::load(zs + i);
+                    wide::Register radius = wide::load(radii + i);
+                    wide::Register nearest = wide::add(planes.distanceTo(0, x, y, z), radius);
+                    for (u32 p = 1; p < 6; ++p) {
+                        nearest = wide::min(wide::add(planes.distanceTo(p, x, y, z), radius), nearest);
+                    }
+                    return nearest;
+                },
+                [&](u64 i) { return view.intersects(sphere { float3 { xs[i], ys[i], zs[i] }, radii[i] }); });
+        }
+
+        // like 'cullSpheres' for boxes given by their centers and half sizes, see 'aabb::center' and
+        // 'aabb::extents'
+        inline u64 cullAABBs(frustum const &view, float3SoA const &centers, float3SoA const &extents, memory::Slice<u64> visible) {
+            aassert(centers.size() == extents.size(), "box centers and extents differ in size");
+            f32 const *xs = float3SoA::lane(centers.x), *ys = float3SoA::lane(centers.y), *zs = float3SoA::lane(centers.z);
+            f32 const *ex = float3SoA::lane(extents.x), *ey = float3SoA::lane(extents.y), *ez = float3SoA::lane(extents.z);
+            batch::FrustumLanes planes { view };
+            return batch::cull(centers.size(), visible,
+                [&](u64 i) {
+                    wide::Register x = wide::load(xs + i), y = wide::load(ys + i), z = wide::load(zs + i);
+                    wide::Register sx = wide::load(ex + i), sy = wide::load(ey + i), sz = wide::load(ez + i);
+                    wide::Register nearest {};
+                    for (u32 p = 0; p < 6; ++p) {
+                        wide::Register reach = wide::add(wide::add(wide::mul(planes.absX[p], sx), wide::mul(planes.absY[p], sy)), wide::mul(planes.absZ[p], sz));
+                        wide::Register d = wide::add(planes.distanceTo(p, x, y, z), reach);
+                        nearest = p == 0 ? d : wide::min(d, nearest);
+                    }
+                    return nearest;
+                },
+                [&](u64 i) { return view.intersects(float3 { xs[i], ys[i], zs[i] }, float3 { ex[i], ey[i], ez[i] }); });
+        }
     }
 }
 
@@ -7,19 +7,78 @@
 // should be able to remove this dependency when providing own 'std::memcpy' implementation
 #include <cstring>
 #include <utility>
+// placement new
+#include <new>
 // require cstdlib for malloc, free
 #include <cstdlib>
+#include <cstddef>
+// for 'fprintf' in 'TrackingAllocator::report'
+#include <cstdio>
 #include <initializer_list>
 #include <type_traits>
+#include <atomic>
 #include "types.hpp"
 #include "assert.hpp"
+#include "defer.hpp"
+#include "simd.hpp"
 
 #define KB(s) ((s) * 1024ULL)
 #define MB(s) ((s) * KB(1024ULL))
 #define GB(s) ((s) * MB(1024ULL))
 
+#if !defined(RELEASE) || defined(RELEASE_TRACKING)
+    #define ACHILLES_TRACKING 1
+#else
+    #define ACHILLES_TRACKING 0
+#endif
+
+// whether 'SafeOffsetPointer' and 'RelativeSlice' check they stay inside their block, define 'RELEASE_BOUNDS_CHECKS'
+// to keep the checks in release builds that read untrusted files
+#if !defined(RELEASE) || defined(RELEASE_BOUNDS_CHECKS)
+    #define ACHILLES_BOUNDS_CHECKS 1
+#else
+    #define ACHILLES_BOUNDS_CHECKS 0
+#endif
+
+// destructive interference size, data written by different threads is kept this far apart
+#define CACHE_LINE_SIZE 64ULL
+
 namespace achilles {
     namespace memory {
+        // the alignment 'allocate' guarantees, the same as 'malloc'
+        constexpr u64 DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+        constexpr bool isPowerOfTwo(u64 value) {
+            return value != 0 && (value & (value - 1)) == 0;
+        }
+
+        constexpr u64 alignUp(u64 value, u64 alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        // pads 'T' out to a cache line of its own, e.g. 'Array<CacheAligned<Counters>>' for per-thread data that
+        // must not share cache lines
+        template<typename T>
+        struct alignas(CACHE_LINE_SIZE) CacheAligned {
+            T value;
+
+            T *operator->() {
+                return &value;
+            }
+
+            T const *operator->() const {
+                return &value;
+            }
+
+            T &operator*() {
+                return value;
+            }
+
+            T const &operator*() const {
+                return value;
+            }
+        };
+
         struct Allocator {
             virtual u8 * allocate(u64 size) = 0;
             virtual bool tryResize(u8 **memory, u64 oldSize, u64 newSize) = 0;
@@ -27,6 +86,14 @@ namespace achilles {
             virtual bool owns(u8 *const memory, u64 size) const { (void) memory, (void) size; return true; }
             virtual bool canAllocate(u64 size) const { (void) size; return true; }
             virtual bool canDeallocate(u8 *const memory, u64 size) const { (void) memory, (void) size; return true; }
+            // 'alignment' must be a power of two, blocks allocated this way are released with 'deallocate'. the
+            // defaults only support up to 'DEFAULT_ALIGNMENT', allocators that can do better override them
+            virtual u8 * allocateAligned(u64 size, u64 alignment) {
+                return alignment <= DEFAULT_ALIGNMENT ? allocate(size) : nullptr;
+            }
+            virtual bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) {
+                return alignment <= DEFAULT_ALIGNMENT && tryResize(memory, oldSize, newSize);
+            }
         };
 
         struct NullAllocator : Allocator {
@@ -53,71 +120,200 @@ namespace achilles {
             }
         };
 
+        // 'malloc' and friends, thread-safe. larger alignments use 'posix_memalign', or '_aligned_malloc' on
+        // windows, where every block goes through the '_aligned' functions so 'deallocate' can free any of them
         struct GlobalAllocator : Allocator {
             u8 * allocate(u64 size) override {
-                u8 *result = (u8 *) malloc(size);
+                return allocateAligned(size, DEFAULT_ALIGNMENT);
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                return tryResizeAligned(memory, oldSize, newSize, DEFAULT_ALIGNMENT);
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                (void) size;
+                if (memory == nullptr || *memory == nullptr) return; 
+                #if defined(_WIN32)
+                    _aligned_free(*memory);
+                #else
+                    free(*memory);
+                #endif
+                *memory = nullptr;
+            }
+
+            u8 * allocateAligned(u64 size, u64 alignment) override {
+                aassert(isPowerOfTwo(alignment), "allocation alignment must be a power of two");
+                u8 *result = nullptr;
+                #if defined(_WIN32)
+                    result = (u8 *) _aligned_malloc(size, alignment);
+                #else
+                    if (alignment <= DEFAULT_ALIGNMENT) {
+                        result = (u8 *) malloc(size);
+                    } else {
+                        void *aligned = nullptr;
+                        if (posix_memalign(&aligned, alignment, size) == 0) result = (u8 *) aligned;
+                    }
+                #endif
                 if (result) {
                     memset(result, 0, size);
                 }
                 return result;
             }
 
-            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+            bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) override {
                 if (memory == nullptr || *memory == nullptr) return false;
-                u8 *result = (u8 *) realloc(*memory, newSize);
-                if (result == nullptr) return false;
+                aassert(isPowerOfTwo(alignment), "allocation alignment must be a power of two");
+                #if defined(_WIN32)
+                    u8 *result = (u8 *) _aligned_realloc(*memory, newSize, alignment);
+                    if (result == nullptr) return false;
+                #else
+                    u8 *result = (u8 *) realloc(*memory, newSize);
+                    if (result == nullptr) return false;
+                    if (((u64) result & (alignment - 1)) != 0) {
+                        // 'realloc' only keeps 'malloc' alignment, move over-aligned blocks by hand
+                        void *aligned = nullptr;
+                        if (posix_memalign(&aligned, alignment, newSize) != 0) {
+                            *memory = result;
+                            return false;
+                        }
+                        memcpy(aligned, result, oldSize < newSize ? oldSize : newSize);
+                        free(result);
+                        result = (u8 *) aligned;
+                    }
+                #endif
                 if (oldSize < newSize) {
-                } else {
-                    u64 diff = newSize - oldSize;
-                    u8 *pos = result + oldSize;
-                    memset(pos, 0, diff);
+                    memset(result + oldSize, 0, newSize - oldSize);
                 }
                 *memory = result;
                 return true;
             }
 
-            void deallocate(u8 **memory, u64 size) override {
-                (void) size;
-                if (memory == nullptr || *memory == nullptr) return; 
-                free(*memory);
-                *memory = nullptr;
-            }
-
             static GlobalAllocator &instance() {
                 static auto _instance = GlobalAllocator{};
                 return _instance;
             }
         };
 
-        struct Block {
-            Block(u8 *memory, u64 size, Allocator &allocator) : _memory{memory}, _size{size}, _allocator{allocator} {}
+        // calls into an allocator of type 'A'. when 'A' is a concrete allocator the calls are qualified, which
+        // bypasses virtual dispatch and lets them inline, so the object passed in must be exactly an 'A'. when 'A'
+        // is abstract (i.e. the 'Allocator' interface itself) the calls stay virtual
+        template<typename A>
+        struct AllocatorTraits {
+            static_assert(std::is_base_of_v<Allocator, A>, "allocators must implement the 'Allocator' interface");
+
+            static constexpr bool POLYMORPHIC = std::is_abstract_v<A>;
+
+            static u8 * allocate(A &allocator, u64 size) {
+                if constexpr (POLYMORPHIC) return allocator.allocate(size);
+                else return allocator.A::allocate(size);
+            }
+
+            static bool tryResize(A &allocator, u8 **memory, u64 oldSize, u64 newSize) {
+                if constexpr (POLYMORPHIC) return allocator.tryResize(memory, oldSize, newSize);
+                else return allocator.A::tryResize(memory, oldSize, newSize);
+            }
+
+            static void deallocate(A &allocator, u8 **memory, u64 size) {
+                if constexpr (POLYMORPHIC) allocator.deallocate(memory, size);
+                else allocator.A::deallocate(memory, size);
+            }
+
+            static u8 * allocateAligned(A &allocator, u64 size, u64 alignment) {
+                if constexpr (POLYMORPHIC) return allocator.allocateAligned(size, alignment);
+                else return allocator.A::allocateAligned(size, alignment);
+            }
 
-            Block(Block &&other) : _memory{other._memory}, _size{other._size}, _allocator{other._allocator} {
+            static bool tryResizeAligned(A &allocator, u8 **memory, u64 oldSize, u64 newSize, u64 alignment) {
+                if constexpr (POLYMORPHIC) return allocator.tryResizeAligned(memory, oldSize, newSize, alignment);
+                else return allocator.A::tryResizeAligned(memory, oldSize, newSize, alignment);
+            }
+        };
+
+        // how a block refers to its allocator. stateless allocators, the ones reachable through a static
+        // 'instance()' like 'GlobalAllocator', are not stored at all, everything else is kept as a pointer
+        template<typename A, typename = void>
+        struct AllocatorHandle {
+            static constexpr bool STATELESS = false;
+
+            AllocatorHandle() : _allocator{defaultAllocator()} {}
+            AllocatorHandle(A &allocator) : _allocator{&allocator} {}
+
+            A &get() const {
+                return *_allocator;
+            }
+
+            // only the 'Allocator' interface has a default, an invalid block of it points to 'NullAllocator'
+            static A &defaultInstance() {
+                static_assert(std::is_same_v<A, Allocator>, "stateful allocators have to be passed explicitly");
+                return NullAllocator::instance();
+            }
+        private:
+            static A *defaultAllocator() {
+                if constexpr (std::is_same_v<A, Allocator>) return &NullAllocator::instance();
+                else return nullptr;
+            }
+
+            A *_allocator;
+        };
+
+        template<typename A>
+        struct AllocatorHandle<A, std::enable_if_t<std::is_same_v<decltype(A::instance()), A &>>> {
+            static constexpr bool STATELESS = true;
+
+            AllocatorHandle() = default;
+            AllocatorHandle(A &allocator) { (void) allocator; }
+
+            A &get() const {
+                return A::instance();
+            }
+
+            static A &defaultInstance() {
+                return A::instance();
+            }
+        };
+
+        // a block of memory owned by an allocator of type 'A', use 'Block' for the polymorphic version, or a
+        // concrete allocator to devirtualize allocator calls. blocks of stateless allocators are only a pointer
+        // and a size, the handle being an empty base
+        template<typename A>
+        struct BasicBlock : private AllocatorHandle<A> {
+            using Handle = AllocatorHandle<A>;
+            using Traits = AllocatorTraits<A>;
+
+            BasicBlock() : Handle{}, _memory{nullptr}, _size{0} {}
+
+            BasicBlock(u8 *memory, u64 size, A &allocator) : Handle{allocator}, _memory{memory}, _size{size} {}
+
+            BasicBlock(u8 *memory, u64 size) requires Handle::STATELESS : Handle{}, _memory{memory}, _size{size} {}
+
+            BasicBlock(BasicBlock &&other) : Handle{(Handle const &) other}, _memory{other._memory}, _size{other._size} {
                 other.invalidate();
             }
 
-            Block &operator =(Block &&other) {
-                if (isValid()) _allocator.deallocate(&_memory, _size);
+            BasicBlock &operator =(BasicBlock &&other) {
+                if (this == &other) return *this;
+                if (isValid()) Traits::deallocate(allocator(), &_memory, _size);
                 _memory = other._memory;
                 _size = other._size;
-                _allocator = other._allocator;
+                (Handle &) *this = (Handle const &) other;
                 other.invalidate();
                 return *this;
             }
 
-            ~Block() {
-                _allocator.deallocate(&_memory, _size);
+            ~BasicBlock() {
+                if (_memory) Traits::deallocate(allocator(), &_memory, _size);
                 invalidate();
             }
 
-            Block(Block const &other) = delete;
-            Block &operator =(Block const &other) = delete;
+            BasicBlock(BasicBlock const &other) = delete;
+            BasicBlock &operator =(BasicBlock const &other) = delete;
 
-            bool operator ==(Block const &other) {
+            bool operator ==(BasicBlock const &other) {
                 return other._memory == _memory && other._size == _size;
             }
 
-            bool operator ==(Block &&other) {
+            bool operator ==(BasicBlock &&other) {
                 return other._memory == _memory && other._size == _size;
             }
 
@@ -130,14 +326,27 @@ namespace achilles {
                 return _memory != nullptr && _size > 0;
             }
 
-            Block copy(Allocator &allocator) {
-                u8 *result = allocator.allocate(_size);
-                memcpy(_memory, _memory, _size);
-                return Block{result, _size, allocator};
+            BasicBlock copy(A &allocator) {
+                u8 *result = Traits::allocate(allocator, _size);
+                if (result == nullptr) return BasicBlock{nullptr, 0, allocator};
+                memcpy(result, _memory, _size);
+                return BasicBlock{result, _size, allocator};
             }
 
             bool tryResize(u64 newSize) {
-                if (_allocator.tryResize(&_memory, _size, newSize)) {
+                if (_memory == nullptr) return false;
+                if (Traits::tryResize(allocator(), &_memory, _size, newSize)) {
+                    _size = newSize;
+                    return true;
+                } else  {
+                    return false;
+                }
+            }
+
+            // resizes keeping the block aligned to 'alignment', which should be what it was allocated with
+            bool tryResize(u64 newSize, u64 alignment) {
+                if (_memory == nullptr) return false;
+                if (Traits::tryResizeAligned(allocator(), &_memory, _size, newSize, alignment)) {
                     _size = newSize;
                     return true;
                 } else  {
@@ -148,6 +357,10 @@ namespace achilles {
             u64 size() const {
                 return _size;
             }
+
+            A &allocator() const {
+                return Handle::get();
+            }
         private:
             void invalidate() {
                 _memory = nullptr;
@@ -156,7 +369,698 @@ namespace achilles {
 
             u8 *_memory;
             u64 _size;
-            Allocator &_allocator;
+        };
+
+        using Block = BasicBlock<Allocator>;
+
+        // a linear (bump-pointer) allocator over a fixed region, either supplied by the caller or reserved from a
+        // backing allocator. individual deallocations only reclaim memory for the most recent allocation, which is
+        // also the only allocation that can be resized in place. everything else is released in bulk with 'reset'
+        // or by rolling back to a 'Marker' taken with 'save'
+        struct ArenaAllocator : Allocator {
+            static constexpr u64 ALIGNMENT = DEFAULT_ALIGNMENT;
+
+            struct Marker {
+                u64 offset;
+                u64 last;
+            };
+
+            ArenaAllocator(u8 *memory, u64 size) : _memory{memory}, _capacity{memory ? size : 0} {}
+
+            // uses the memory of 'block' without taking ownership, the block must outlive the arena
+            explicit ArenaAllocator(Block const &block) : ArenaAllocator{(u8 *) block, block.size()} {}
+
+            explicit ArenaAllocator(u64 size, Allocator &backing = GlobalAllocator::instance()) {
+                u8 *memory = backing.allocate(size);
+                if (memory) {
+                    _backing = Block { memory, size, backing };
+                    _memory = memory;
+                    _capacity = size;
+                }
+            }
+
+            ArenaAllocator(ArenaAllocator const &other) = delete;
+            ArenaAllocator &operator =(ArenaAllocator const &other) = delete;
+
+            u8 * allocate(u64 size) override {
+                return allocateAligned(size, ALIGNMENT);
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                if (memory == nullptr || *memory == nullptr) return false;
+                if (*memory != _memory + _last || _last + oldSize != _offset) {
+                    // not the most recent allocation, shrinking is still fine, the tail is just not reclaimed
+                    return newSize <= oldSize && owns(*memory, oldSize);
+                }
+                if (newSize > _capacity - _last) return false;
+                if (newSize > oldSize) {
+                    memset(*memory + oldSize, 0, newSize - oldSize);
+                }
+                _offset = _last + newSize;
+                return true;
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                if (memory == nullptr || *memory == nullptr) return;
+                if (canDeallocate(*memory, size)) {
+                    _offset = _last;
+                }
+                *memory = nullptr;
+            }
+
+            bool owns(u8 *const memory, u64 size) const override {
+                return memory >= _memory && memory + size <= _memory + _capacity;
+            }
+
+            bool canAllocate(u64 size) const override {
+                u64 offset = alignedOffset(ALIGNMENT);
+                return offset <= _capacity && size <= _capacity - offset;
+            }
+
+            bool canDeallocate(u8 *const memory, u64 size) const override {
+                return memory != nullptr && memory == _memory + _last && _last + size == _offset;
+            }
+
+            u8 * allocateAligned(u64 size, u64 alignment) override {
+                aassert(isPowerOfTwo(alignment), "allocation alignment must be a power of two");
+                if (alignment < ALIGNMENT) alignment = ALIGNMENT;
+                u64 offset = alignedOffset(alignment);
+                if (size == 0 || offset > _capacity || size > _capacity - offset) return nullptr;
+                u8 *result = _memory + offset;
+                _last = offset;
+                _offset = offset + size;
+                memset(result, 0, size);
+                return result;
+            }
+
+            bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) override {
+                // resizing happens in place, so the alignment is kept as long as it was there to begin with
+                if (memory == nullptr || ((u64) *memory & (alignment - 1)) != 0) return false;
+                return tryResize(memory, oldSize, newSize);
+            }
+
+            Marker save() const {
+                return Marker { _offset, _last };
+            }
+
+            // releases everything allocated after 'marker' was taken
+            void restore(Marker marker) {
+                aassert(marker.offset <= _offset, "restoring an arena to a marker that was already released");
+                _offset = marker.offset;
+                _last = marker.last;
+            }
+
+            void reset() {
+                _offset = 0;
+                _last = 0;
+            }
+
+            u64 used() const {
+                return _offset;
+            }
+
+            u64 capacity() const {
+                return _capacity;
+            }
+
+            u64 remaining() const {
+                return _capacity - _offset;
+            }
+        private:
+            // the offset of the next free address aligned to 'alignment'
+            u64 alignedOffset(u64 alignment) const {
+                return alignUp((u64) (_memory + _offset), alignment) - (u64) _memory;
+            }
+
+            Block _backing;
+            u8 *_memory = nullptr;
+            u64 _capacity = 0;
+            u64 _offset = 0;
+            u64 _last = 0;
+        };
+
+        // rolls 'arena' back to its current position when the enclosing scope exits, the marker is named after
+        // the line so the 'defer' that follows can refer to it, so only one 'arena_scope' per line
+        #define arena_scope(arena)\
+            auto macro_concat2(ARENA_MARKER_, __LINE__) = (arena).save();\
+            defer { (arena).restore(macro_concat2(ARENA_MARKER_, __LINE__)); }
+
+        // a fixed-size allocator, hands out slots of 'SlotSize' bytes from chunks of 'SlotsPerChunk' slots that
+        // are requested from a backing allocator as needed. free slots are kept in an intrusive free list, so both
+        // allocation and deallocation are O(1). chunks are only returned to the backing allocator on destruction
+        template<u64 SlotSize, u64 SlotsPerChunk = 64>
+        struct PoolAllocator : Allocator {
+            static_assert(SlotSize > 0, "pool slots must have a non-zero size");
+            static_assert(SlotsPerChunk > 0, "pool chunks must hold at least one slot");
+
+            explicit PoolAllocator(Allocator &backing = GlobalAllocator::instance()) : _backing{&backing} {}
+
+            PoolAllocator(PoolAllocator const &other) = delete;
+            PoolAllocator &operator =(PoolAllocator const &other) = delete;
+
+            ~PoolAllocator() {
+                release();
+            }
+
+            u8 * allocate(u64 size) override {
+                if (size == 0 || size > SlotSize) return nullptr;
+                if (_free == nullptr && !addChunk()) return nullptr;
+                Node *node = _free;
+                _free = node->next;
+                u8 *result = (u8 *) node;
+                memset(result, 0, SlotSize);
+                return result;
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                (void) oldSize;
+                if (memory == nullptr || *memory == nullptr) return false;
+                return newSize > 0 && newSize <= SlotSize && owns(*memory, newSize);
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                (void) size;
+                if (memory == nullptr || *memory == nullptr) return;
+                aassert(owns(*memory, 1), "deallocating memory that does not belong to this pool");
+                Node *node = (Node *) *memory;
+                node->next = _free;
+                _free = node;
+                *memory = nullptr;
+            }
+
+            bool owns(u8 *const memory, u64 size) const override {
+                if (memory == nullptr || size > SlotSize) return false;
+                for (Chunk *chunk = _chunks; chunk != nullptr; chunk = chunk->next) {
+                    u8 *slots = slotsOf(chunk);
+                    if (memory >= slots && memory < slots + SLOT_STRIDE * SlotsPerChunk) {
+                        return (u64) (memory - slots) % SLOT_STRIDE == 0;
+                    }
+                }
+                return false;
+            }
+
+            bool canAllocate(u64 size) const override {
+                return size > 0 && size <= SlotSize && (_free != nullptr || _backing->canAllocate(CHUNK_SIZE));
+            }
+
+            bool canDeallocate(u8 *const memory, u64 size) const override {
+                return owns(memory, size);
+            }
+
+            u8 * allocateAligned(u64 size, u64 alignment) override {
+                aassert(isPowerOfTwo(alignment), "allocation alignment must be a power of two");
+                return alignment <= SLOT_ALIGNMENT ? allocate(size) : nullptr;
+            }
+
+            bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) override {
+                return alignment <= SLOT_ALIGNMENT && tryResize(memory, oldSize, newSize);
+            }
+
+            // returns every chunk to the backing allocator, invalidating all outstanding slots
+            void release() {
+                Chunk *chunk = _chunks;
+                while (chunk != nullptr) {
+                    Chunk *next = chunk->next;
+                    u8 *memory = (u8 *) chunk;
+                    _backing->deallocate(&memory, CHUNK_SIZE);
+                    chunk = next;
+                }
+                _chunks = nullptr;
+                _free = nullptr;
+                _chunkCount = 0;
+            }
+
+            u64 chunkCount() const {
+                return _chunkCount;
+            }
+
+            static constexpr u64 slotSize() {
+                return SlotSize;
+            }
+        private:
+            struct Node {
+                Node *next;
+            };
+
+            struct Chunk {
+                Chunk *next;
+            };
+
+            static constexpr u64 SLOT_STRIDE    = alignUp(SlotSize < sizeof(Node) ? sizeof(Node) : SlotSize, alignof(Node));
+            // slots start 'DEFAULT_ALIGNMENT' aligned, so each one is aligned to its stride's lowest set bit
+            static constexpr u64 SLOT_ALIGNMENT = (SLOT_STRIDE & (~SLOT_STRIDE + 1)) < DEFAULT_ALIGNMENT ? (SLOT_STRIDE & (~SLOT_STRIDE + 1)) : DEFAULT_ALIGNMENT;
+            static constexpr u64 HEADER_SIZE    = alignUp(sizeof(Chunk), DEFAULT_ALIGNMENT);
+            static constexpr u64 CHUNK_SIZE     = HEADER_SIZE + SLOT_STRIDE * SlotsPerChunk;
+
+            static u8 *slotsOf(Chunk *chunk) {
+                return ((u8 *) chunk) + HEADER_SIZE;
+            }
+
+            bool addChunk() {
+                u8 *memory = _backing->allocate(CHUNK_SIZE);
+                if (memory == nullptr) return false;
+                Chunk *chunk = (Chunk *) memory;
+                chunk->next = _chunks;
+                _chunks = chunk;
+                _chunkCount += 1;
+
+                // thread the new slots onto the free list, lowest address first
+                u8 *slots = slotsOf(chunk);
+                for (u64 i = SlotsPerChunk; i > 0; --i) {
+                    Node *node = (Node *) (slots + (i - 1) * SLOT_STRIDE);
+                    node->next = _free;
+                    _free = node;
+                }
+                return true;
+            }
+
+            Allocator *_backing;
+            Chunk *_chunks = nullptr;
+            Node *_free = nullptr;
+            u64 _chunkCount = 0;
+        };
+
+        // a pool sized for objects of type 'T', e.g. to back 'Address<T>'
+        template<typename T, u64 SlotsPerChunk = 64>
+        using ObjectPool = PoolAllocator<sizeof(T), SlotsPerChunk>;
+
+        // an arena that lives inside the object itself, e.g. on the stack, for small short-lived buffers
+        template<u64 Size>
+        struct StackAllocator : ArenaAllocator {
+            StackAllocator() : ArenaAllocator{_buffer, Size} {}
+
+            StackAllocator(StackAllocator const &other) = delete;
+            StackAllocator &operator =(StackAllocator const &other) = delete;
+        private:
+            alignas(DEFAULT_ALIGNMENT) u8 _buffer[Size];
+        };
+
+        // the combinators below hold their allocators by value, so calls into them are resolved statically and
+        // only the outermost allocator is called through the 'Allocator' interface. they route blocks based on
+        // 'owns', so the allocators they are composed of must report ownership precisely ('GlobalAllocator' claims
+        // to own everything, so it only makes sense as the last choice)
+
+        // tries 'Primary' first, and defers to 'Secondary' when it fails. resizing a block past what 'Primary' can
+        // hold moves it to 'Secondary'
+        template<typename Primary, typename Secondary>
+        struct FallbackAllocator : Allocator {
+            u8 * allocate(u64 size) override {
+                u8 *result = _primary.allocate(size);
+                if (result) return result;
+                return _secondary.allocate(size);
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                if (memory == nullptr || *memory == nullptr) return false;
+                if (!_primary.owns(*memory, oldSize)) {
+                    return _secondary.tryResize(memory, oldSize, newSize);
+                }
+                if (_primary.tryResize(memory, oldSize, newSize)) return true;
+                u8 *result = _secondary.allocate(newSize);
+                if (result == nullptr) return false;
+                memcpy(result, *memory, oldSize < newSize ? oldSize : newSize);
+                _primary.deallocate(memory, oldSize);
+                *memory = result;
+                return true;
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                if (memory == nullptr || *memory == nullptr) return;
+                if (_primary.owns(*memory, size)) {
+                    _primary.deallocate(memory, size);
+                } else {
+                    _secondary.deallocate(memory, size);
+                }
+            }
+
+            bool owns(u8 *const memory, u64 size) const override {
+                return _primary.owns(memory, size) || _secondary.owns(memory, size);
+            }
+
+            bool canAllocate(u64 size) const override {
+                return _primary.canAllocate(size) || _secondary.canAllocate(size);
+            }
+
+            bool canDeallocate(u8 *const memory, u64 size) const override {
+                if (_primary.owns(memory, size)) return _primary.canDeallocate(memory, size);
+                return _secondary.canDeallocate(memory, size);
+            }
+
+            u8 * allocateAligned(u64 size, u64 alignment) override {
+                u8 *result = _primary.allocateAligned(size, alignment);
+                if (result) return result;
+                return _secondary.allocateAligned(size, alignment);
+            }
+
+            bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) override {
+                if (memory == nullptr || *memory == nullptr) return false;
+                if (!_primary.owns(*memory, oldSize)) {
+                    return _secondary.tryResizeAligned(memory, oldSize, newSize, alignment);
+                }
+                if (_primary.tryResizeAligned(memory, oldSize, newSize, alignment)) return true;
+                u8 *result = _secondary.allocateAligned(newSize, alignment);
+                if (result == nullptr) return false;
+                memcpy(result, *memory, oldSize < newSize ? oldSize : newSize);
+                _primary.deallocate(memory, oldSize);
+                *memory = result;
+                return true;
+            }
+
+            Primary &primary() {
+                return _primary;
+            }
+
+            Secondary &secondary() {
+                return _secondary;
+            }
+        private:
+            Primary _primary;
+            Secondary _secondary;
+        };
+
+        // sends allocations of up to 'Threshold' bytes to 'Small' and anything larger to 'Large'. a block that is
+        // resized across the threshold is moved to the other allocator
+        template<u64 Threshold, typename Small, typename Large>
+        struct Segregator : Allocator {
+            u8 * allocate(u64 size) override {
+                if (size <= Threshold) return _small.allocate(size);
+                return _large.allocate(size);
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                if (memory == nullptr || *memory == nullptr) return false;
+                bool wasSmall = oldSize <= Threshold;
+                bool isSmall = newSize <= Threshold;
+                if (wasSmall && isSmall) return _small.tryResize(memory, oldSize, newSize);
+                if (!wasSmall && !isSmall) return _large.tryResize(memory, oldSize, newSize);
+                u8 *result = allocate(newSize);
+                if (result == nullptr) return false;
+                memcpy(result, *memory, oldSize < newSize ? oldSize : newSize);
+                deallocate(memory, oldSize);
+                *memory = result;
+                return true;
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                if (size <= Threshold) {
+                    _small.deallocate(memory, size);
+                } else {
+                    _large.deallocate(memory, size);
+                }
+            }
+
+            bool owns(u8 *const memory, u64 size) const override {
+                if (size <= Threshold) return _small.owns(memory, size);
+                return _large.owns(memory, size);
+            }
+
+            bool canAllocate(u64 size) const override {
+                if (size <= Threshold) return _small.canAllocate(size);
+                return _large.canAllocate(size);
+            }
+
+            bool canDeallocate(u8 *const memory, u64 size) const override {
+                if (size <= Threshold) return _small.canDeallocate(memory, size);
+                return _large.canDeallocate(memory, size);
+            }
+
+            u8 * allocateAligned(u64 size, u64 alignment) override {
+                if (size <= Threshold) return _small.allocateAligned(size, alignment);
+                return _large.allocateAligned(size, alignment);
+            }
+
+            bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) override {
+                if (memory == nullptr || *memory == nullptr) return false;
+                bool wasSmall = oldSize <= Threshold;
+                bool isSmall = newSize <= Threshold;
+                if (wasSmall && isSmall) return _small.tryResizeAligned(memory, oldSize, newSize, alignment);
+                if (!wasSmall && !isSmall) return _large.tryResizeAligned(memory, oldSize, newSize, alignment);
+                u8 *result = allocateAligned(newSize, alignment);
+                if (result == nullptr) return false;
+                memcpy(result, *memory, oldSize < newSize ? oldSize : newSize);
+                deallocate(memory, oldSize);
+                *memory = result;
+                return true;
+            }
+
+            Small &small() {
+                return _small;
+            }
+
+            Large &large() {
+                return _large;
+            }
+        private:
+            Small _small;
+            Large _large;
+        };
+
+        // a per-thread arena of 'Size' bytes reserved from 'GlobalAllocator' on first use. 'instance()' resolves to
+        // the calling thread's arena, so it needs no synchronization and can be used as a stateless allocator, e.g.
+        // 'Array<T, ThreadLocalArena<>>'. blocks handed to another thread can't be resized or released in place
+        // there, they are copied into that thread's arena instead. the arena is released when its thread exits
+        template<u64 Size = MB(1)>
+        struct ThreadLocalArena : ArenaAllocator {
+            static ThreadLocalArena &instance() {
+                thread_local ThreadLocalArena _instance{};
+                return _instance;
+            }
+        private:
+            ThreadLocalArena() : ArenaAllocator{Size} {}
+        };
+
+        // a pool shared between threads, where every thread allocates from its own heap without any atomics.
+        // freeing a slot from the thread that allocated it is just as cheap, freeing it from any other thread
+        // pushes it onto the owning heap's lock-free remote list, which the owner takes over in one exchange once
+        // its local list runs dry. heaps are created on a thread's first allocation and live as long as the pool,
+        // a thread that starts later may end up reusing the heap of one that exited. chunks are requested from
+        // 'backing', which has to be thread-safe itself ('GlobalAllocator' is)
+        template<u64 SlotSize, u64 SlotsPerChunk = 64>
+        struct ThreadCachePool : Allocator {
+            static_assert(SlotSize > 0, "pool slots must have a non-zero size");
+            static_assert(SlotsPerChunk > 0, "pool chunks must hold at least one slot");
+
+            explicit ThreadCachePool(Allocator &backing = GlobalAllocator::instance())
+                : _backing{&backing}, _id{nextId().fetch_add(1, std::memory_order_relaxed)} {}
+
+            ThreadCachePool(ThreadCachePool const &other) = delete;
+            ThreadCachePool &operator =(ThreadCachePool const &other) = delete;
+
+            ~ThreadCachePool() {
+                Heap *heap = _heaps.load(std::memory_order_acquire);
+                while (heap != nullptr) {
+                    Heap *next = heap->next;
+                    Chunk *chunk = heap->chunks.load(std::memory_order_acquire);
+                    while (chunk != nullptr) {
+                        Chunk *nextChunk = chunk->next;
+                        u8 *memory = chunk->base;
+                        _backing->deallocate(&memory, chunk->allocated);
+                        chunk = nextChunk;
+                    }
+                    u8 *memory = (u8 *) heap;
+                    heap->~Heap();
+                    _backing->deallocate(&memory, sizeof(Heap));
+                    heap = next;
+                }
+            }
+
+            u8 * allocate(u64 size) override {
+                if (size == 0 || size > SlotSize) return nullptr;
+                Heap *heap = localHeap();
+                if (heap == nullptr) return nullptr;
+                if (heap->free == nullptr) {
+                    heap->free = heap->remote.exchange(nullptr, std::memory_order_acquire);
+                    if (heap->free == nullptr && !addChunk(heap)) return nullptr;
+                }
+                Node *node = heap->free;
+                heap->free = node->next;
+                u8 *result = (u8 *) node;
+                memset(result, 0, SlotSize);
+                return result;
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                (void) oldSize;
+                if (memory == nullptr || *memory == nullptr) return false;
+                return newSize > 0 && newSize <= SlotSize;
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                (void) size;
+                if (memory == nullptr || *memory == nullptr) return;
+                Chunk *chunk = chunkOf(*memory);
+                aassert(chunk->pool == this, "deallocating memory that does not belong to this pool");
+                Heap *heap = chunk->heap;
+                Node *node = (Node *) *memory;
+                *memory = nullptr;
+                if (heap == cachedHeap()) {
+                    node->next = heap->free;
+                    heap->free = node;
+                    return;
+                }
+                Node *head = heap->remote.load(std::memory_order_relaxed);
+                do {
+                    node->next = head;
+                } while (!heap->remote.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            bool owns(u8 *const memory, u64 size) const override {
+                if (memory == nullptr || size > SlotSize) return false;
+                for (Heap *heap = _heaps.load(std::memory_order_acquire); heap != nullptr; heap = heap->next) {
+                    for (Chunk *chunk = heap->chunks.load(std::memory_order_acquire); chunk != nullptr; chunk = chunk->next) {
+                        if (memory >= slotsOf(chunk) && memory < slotsOf(chunk) + SLOT_STRIDE * SLOTS) return true;
+                    }
+                }
+                return false;
+            }
+
+            bool canAllocate(u64 size) const override {
+                return size > 0 && size <= SlotSize;
+            }
+
+            bool canDeallocate(u8 *const memory, u64 size) const override {
+                return owns(memory, size);
+            }
+
+            u8 * allocateAligned(u64 size, u64 alignment) override {
+                aassert(isPowerOfTwo(alignment), "allocation alignment must be a power of two");
+                return alignment <= SLOT_ALIGNMENT ? allocate(size) : nullptr;
+            }
+
+            bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) override {
+                return alignment <= SLOT_ALIGNMENT && tryResize(memory, oldSize, newSize);
+            }
+        private:
+            struct Node {
+                Node *next;
+            };
+
+            struct Heap;
+
+            // chunks are 'CHUNK_ALIGNMENT' bytes and aligned to it, so a slot finds its chunk, and through it its heap,
+            // by masking
+            struct Chunk {
+                Chunk *next;
+                Heap *heap;
+                ThreadCachePool *pool;
+                // what came from 'backing', which is more than the chunk when it had to be aligned by hand
+                u8 *base;
+                u64 allocated;
+            };
+
+            struct Heap {
+                Heap *next = nullptr;
+                void const *thread = nullptr;
+                Node *free = nullptr;
+                std::atomic<Chunk *> chunks {nullptr};
+                // written by other threads, padded off the owner's cache line. padding rather than 'alignas' since
+                // heaps come from 'backing', which only guarantees 'max_align_t' alignment
+                u8 padding[CACHE_LINE_SIZE];
+                std::atomic<Node *> remote {nullptr};
+            };
+
+            struct ThreadCache {
+                u64 pool = 0;
+                Heap *heap = nullptr;
+            };
+
+            static constexpr u64 nextPowerOfTwo(u64 value) {
+                u64 result = 1;
+                while (result < value) result <<= 1;
+                return result;
+            }
+
+            static constexpr u64 SLOT_STRIDE      = alignUp(SlotSize < sizeof(Node) ? sizeof(Node) : SlotSize, alignof(Node));
+            // chunks are aligned to at least a cache line, so slots whose stride is a multiple of one start on
+            // their own lines once the header is padded to it, e.g. 64-byte slots don't share lines
+            static constexpr u64 SLOT_ALIGNMENT   = (SLOT_STRIDE & (~SLOT_STRIDE + 1)) < CACHE_LINE_SIZE ? (SLOT_STRIDE & (~SLOT_STRIDE + 1)) : CACHE_LINE_SIZE;
+            static constexpr u64 HEADER_SIZE      = alignUp(sizeof(Chunk), SLOT_ALIGNMENT < DEFAULT_ALIGNMENT ? DEFAULT_ALIGNMENT : SLOT_ALIGNMENT);
+            static constexpr u64 CHUNK_ALIGNMENT  = nextPowerOfTwo(HEADER_SIZE + SLOT_STRIDE * SlotsPerChunk);
+            // the room left by rounding the chunk up to a power of two holds more slots
+            static constexpr u64 SLOTS            = (CHUNK_ALIGNMENT - HEADER_SIZE) / SLOT_STRIDE;
+            static_assert(CHUNK_ALIGNMENT >= CACHE_LINE_SIZE, "pool chunks must be at least a cache line");
+
+            static std::atomic<u64> &nextId() {
+                static std::atomic<u64> _next {1};
+                return _next;
+            }
+
+            // one cache line per pool type and thread, remembers the heap of the pool used last from this thread
+            static ThreadCache &threadCache() {
+                thread_local ThreadCache _cache {};
+                return _cache;
+            }
+
+            // the address of a thread local identifies the calling thread
+            static void const *threadKey() {
+                thread_local u8 _key = 0;
+                return &_key;
+            }
+
+            static Chunk *chunkOf(u8 *memory) {
+                return (Chunk *) ((u64) memory & ~(CHUNK_ALIGNMENT - 1));
+            }
+
+            static u8 *slotsOf(Chunk *chunk) {
+                return ((u8 *) chunk) + HEADER_SIZE;
+            }
+
+            Heap *cachedHeap() const {
+                ThreadCache &cache = threadCache();
+                return cache.pool == _id ? cache.heap : nullptr;
+            }
+
+            Heap *localHeap() {
+                ThreadCache &cache = threadCache();
+                if (cache.pool == _id) return cache.heap;
+
+                void const *thread = threadKey();
+                Heap *heap = _heaps.load(std::memory_order_acquire);
+                while (heap != nullptr && heap->thread != thread) heap = heap->next;
+                if (heap == nullptr) {
+                    u8 *memory = _backing->allocate(sizeof(Heap));
+                    if (memory == nullptr) return nullptr;
+                    heap = new (memory) Heap {};
+                    heap->thread = thread;
+                    Heap *head = _heaps.load(std::memory_order_relaxed);
+                    do {
+                        heap->next = head;
+                    } while (!_heaps.compare_exchange_weak(head, heap, std::memory_order_release, std::memory_order_relaxed));
+                }
+                cache.pool = _id;
+                cache.heap = heap;
+                return heap;
+            }
+
+            bool addChunk(Heap *heap) {
+                // a backing allocator that can't align that far gets asked for twice the size, aligned by hand
+                u64 allocated = CHUNK_ALIGNMENT;
+                u8 *base = _backing->allocateAligned(allocated, CHUNK_ALIGNMENT);
+                if (base == nullptr) {
+                    allocated = CHUNK_ALIGNMENT * 2;
+                    base = _backing->allocate(allocated);
+                }
+                if (base == nullptr) return false;
+                Chunk *chunk = (Chunk *) alignUp((u64) base, CHUNK_ALIGNMENT);
+                chunk->heap = heap;
+                chunk->pool = this;
+                chunk->base = base;
+                chunk->allocated = allocated;
+                chunk->next = heap->chunks.load(std::memory_order_relaxed);
+                heap->chunks.store(chunk, std::memory_order_release);
+
+                u8 *slots = slotsOf(chunk);
+                for (u64 i = SLOTS; i > 0; --i) {
+                    Node *node = (Node *) (slots + (i - 1) * SLOT_STRIDE);
+                    node->next = heap->free;
+                    heap->free = node;
+                }
+                return true;
+            }
+
+            Allocator *_backing;
+            u64 _id;
+            std::atomic<Heap *> _heaps {nullptr};
         };
 
         template<typename T>
@@ -165,7 +1069,12 @@ namespace achilles {
 
             template<typename... Args>
             Address(Allocator &allocator, Args &&...args) {
-                u8 *memory = allocator.allocate(sizeof(T));
+                u8 *memory = nullptr;
+                if constexpr (alignof(T) <= DEFAULT_ALIGNMENT) {
+                    memory = allocator.allocate(sizeof(T));
+                } else {
+                    memory = allocator.allocateAligned(sizeof(T), alignof(T));
+                }
                 if (memory) {
                     new (memory) T { std::forward<Args>(args)... };
                 }
@@ -261,23 +1170,12 @@ namespace achilles {
             Slice &operator=(Slice const &other) = default;
             Slice &operator=(Slice &&other) = default;
 
-            template<u64 SIZE>
-            Slice<char const>(char const (&str)[SIZE]) : _memory{&str}, _size{SIZE} {}
-
-            Slice<char const>(char const *_str) : _memory{(char *) _str}, _size{strlen(_str)} {}
+            Slice(char const *str) requires std::is_same_v<T, char const> : _memory{str}, _size{strlen(str)} {}
 
             bool operator==(Slice const &other) const {
-                if (_memory == other.memory && _size == other._size) {
-                    return true;
-                } else if (_size == other._size) {
-                    bool areEqual = true;
-                    for (auto i = 0; i < _size && areEqual; ++i) {
-                        areEqual &= get(i) == other.get(i);
-                    }
-                    return areEqual;
-                } else {
-                    return false;
-                }
+                if (_size != other._size) return false;
+                if (_memory == other._memory) return true;
+                return simd::equal<std::remove_cv_t<T>>(_memory, other._memory, _size);
             }
 
             bool operator!=(Slice const &other) const {
@@ -285,27 +1183,57 @@ namespace achilles {
             }
 
             bool operator==(Slice &&other) const {
-                if (_memory == other.memory && _size == other._size) {
-                    return true;
-                } else if (_size == other._size) {
-                    bool areEqual = true;
-                    for (auto i = 0; i < _size && areEqual; ++i) {
-                        areEqual &= get(i) == other.get(i);
-                    }
-                    return areEqual;
-                } else {
-                    return false;
-                }
+                return operator==((Slice const &) other);
             }
 
             bool operator!=(Slice &&other) const {
-                return !operator==((Slice &&) other);
+                return !operator==((Slice const &) other);
+            }
+
+            // the searches below are vectorised for arithmetic element types, see 'simd.hpp'
+
+            // the index of the first element equal to 'value', 'U64_MAX' if there is none
+            u64 find(T const &value) const {
+                return simd::find<std::remove_cv_t<T>>(_memory, _size, value);
+            }
+
+            bool contains(T const &value) const {
+                return find(value) != U64_MAX;
+            }
+
+            u64 count(T const &value) const {
+                return simd::count<std::remove_cv_t<T>>(_memory, _size, value);
+            }
+
+            // pushes the index of every element equal to 'value' into 'indices', e.g. an 'Array<u64>', returns how
+            // many were found
+            template<typename Indices>
+            u64 findAll(T const &value, Indices &indices) const {
+                u64 found = 0;
+                simd::findAll<std::remove_cv_t<T>>(_memory, _size, value, [&](u64 index) {
+                    indices.push(index);
+                    found += 1;
+                });
+                return found;
+            }
+
+            void fill(T const &value) const {
+                simd::fill<T>(_memory, _size, value);
             }
 
             operator T *() const {
                 return (T *) _memory;
             }
 
+            // for range-based for loops
+            T *begin() const {
+                return _memory;
+            }
+
+            T *end() const {
+                return _memory + _size;
+            }
+
             bool isValid() const {
                 return _memory != nullptr && _size > 0;
             }
@@ -342,24 +1270,71 @@ namespace achilles {
             u64 _size;
         };
 
+        // whether moving a 'T' to a new address and forgetting the old one is the same as a plain byte copy, in
+        // which case 'Array' moves elements with 'memcpy'/'memmove' and grows through 'tryResize'. anything
+        // trivially copyable is, specialize this for other types that are, e.g. ones holding an owning pointer
         template<typename T>
+        struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+        template<typename T>
+        constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+        // how an 'Array' picks its next capacity when it runs out, passed as its 'Growth' parameter so an array
+        // carries no policy at runtime. a policy is any type with a static 'next(capacity, required)' returning the
+        // capacity to grow 'capacity' to, so that at least 'required' elements fit. 'GrowByFactor' multiplies the
+        // capacity by 'Numerator / Denominator', starting from 8 elements
+        template<u32 Numerator = 2, u32 Denominator = 1>
+        struct GrowByFactor {
+            static_assert(Denominator > 0, "growth factors need a non-zero denominator");
+
+            static constexpr u64 next(u64 capacity, u64 required) {
+                u64 result = capacity == 0 ? 8 : capacity / Denominator * Numerator + capacity % Denominator * Numerator / Denominator;
+                if (result <= capacity) result = capacity + 1;
+                return result < required ? required : result;
+            }
+        };
+
+        // adds 'Chunk' elements at a time
+        template<u32 Chunk>
+        struct GrowByChunk {
+            static_assert(Chunk > 0, "growth chunks must hold at least one element");
+
+            static constexpr u64 next(u64 capacity, u64 required) {
+                u64 result = capacity + Chunk;
+                return result < required ? required : result;
+            }
+        };
+
+        // a growable array, 'A' selects the allocator type. the default goes through the 'Allocator' interface,
+        // a concrete allocator type devirtualizes growth, and a stateless one (e.g. 'GlobalAllocator') is not
+        // stored, leaving just the pointer, capacity and size. storage is aligned to 'Alignment', which can be
+        // raised above 'alignof(T)', e.g. to 32 for aligned AVX loads. 'Growth' picks the next capacity, see
+        // 'GrowByFactor'
+        template<typename T, typename A = Allocator, u64 Alignment = alignof(T), typename Growth = GrowByFactor<>>
         struct Array {
-            Array(Allocator &allocator = NullAllocator::instance(), u64 capacity = 8) {
+            static_assert(isPowerOfTwo(Alignment) && Alignment >= alignof(T), "array alignment must be a power of two, at least 'alignof(T)'");
+
+            using Traits = AllocatorTraits<A>;
+
+            // a 'capacity' of zero allocates nothing until the first push or 'reserve'
+            Array(A &allocator = AllocatorHandle<A>::defaultInstance(), u64 capacity = 8) : _block{nullptr, 0, allocator} {
                 if (capacity > 0) {
-                    u8 *memory = allocator.allocate(capacity * sizeof(T));
+                    u8 *memory = allocateStorage(allocator, capacity * sizeof(T));
                     if (memory) {
-                        _block = Block { memory, capacity * sizeof(T), allocator };
+                        _block = BasicBlock<A> { memory, capacity * sizeof(T), allocator };
                     }
                 }
             }
 
+            explicit Array(u64 capacity) requires AllocatorHandle<A>::STATELESS : Array(A::instance(), capacity) {}
+
             template<typename... Items>
-            Array(Allocator &allocator, T &&item, Items &&...items) {
+            Array(A &allocator, T &&item, Items &&...items) : _block{nullptr, 0, allocator} {
                 std::initializer_list<T> items_ = {std::forward<T>(item), std::forward<Items>(items)...};
                 size_t size_ = items_.size() * sizeof(T);
-                u8 *memory = allocator.allocate(size_);
+                u8 *memory = allocateStorage(allocator, size_);
                 if (memory) {
-                    _block = Block { memory, size_, allocator };
+                    _block = BasicBlock<A> { memory, size_, allocator };
                     for (auto &i : items_) {
                         // this stupid hack because we cannot have a non-const iterator when iterating std::initializer_list
                         auto &e = const_cast<T &>(i);
@@ -395,9 +1370,8 @@ namespace achilles {
             }
 
             bool push(T &&value) {
-                if (!isValid()) return false;
                 if (capacity() == _size) {
-                    if (!_block.tryResize(_block.size() * 2)) {
+                    if (!grow(Growth::next(capacity(), _size + 1))) {
                         return false;
                     }
                 }
@@ -412,9 +1386,8 @@ namespace achilles {
             }
 
             bool push(T const &value) {
-                if (!isValid()) return false;
                 if (capacity() == _size) {
-                    if (!_block.tryResize(_block.size() * 2)) {
+                    if (!grow(Growth::next(capacity(), _size + 1))) {
                         return false;
                     }
                 }
@@ -428,6 +1401,78 @@ namespace achilles {
                 return true;
             }
 
+            // constructs the new element in place from 'args'
+            template<typename... Args>
+            bool emplace(Args &&...args) {
+                if (capacity() == _size) {
+                    if (!grow(Growth::next(capacity(), _size + 1))) {
+                        return false;
+                    }
+                }
+                T *memory = (T *) _block;
+                new (memory + _size) T { std::forward<Args>(args)... };
+                _size += 1;
+                return true;
+            }
+
+            // appends all of 'values' with at most one allocation, and a single copy for trivially copyable types
+            bool pushMany(Slice<T> const &values) {
+                u64 count = values.size();
+                if (count == 0) return true;
+                if (count > capacity() - _size && !grow(Growth::next(capacity(), _size + count))) return false;
+                T *memory = (T *) _block;
+                T *source = (T *) values;
+                if constexpr (std::is_trivially_copyable_v<T>) {
+                    memcpy(memory + _size, source, count * sizeof(T));
+                } else {
+                    for (u64 i = 0; i < count; ++i) {
+                        new (memory + _size + i) T(source[i]);
+                    }
+                }
+                _size += count;
+                return true;
+            }
+
+            // makes room for at least 'newCapacity' elements, in one allocation
+            bool reserve(u64 newCapacity) {
+                if (newCapacity <= capacity()) return true;
+                return grow(newCapacity);
+            }
+
+            // default-constructs new elements when growing, destroys the extra ones when shrinking
+            bool resize(u64 newSize) {
+                u64 oldSize = _size;
+                if (!setSize(newSize)) return false;
+                T *memory = (T *) _block;
+                for (u64 i = oldSize; i < newSize; ++i) {
+                    new (memory + i) T {};
+                }
+                return true;
+            }
+
+            bool resize(u64 newSize, T const &value) {
+                u64 oldSize = _size;
+                if (!setSize(newSize)) return false;
+                T *memory = (T *) _block;
+                for (u64 i = oldSize; i < newSize; ++i) {
+                    new (memory + i) T(value);
+                }
+                return true;
+            }
+
+            // like 'resize', but leaves new elements as whatever the allocator returned (zeroed memory for the
+            // allocators here, but not after shrinking and growing again), for bulk writes that follow
+            bool resizeUninitialized(u64 newSize) {
+                static_assert(std::is_trivially_default_constructible_v<T>, "only trivial types can be left uninitialized");
+                return setSize(newSize);
+            }
+
+            // releases unused capacity, an empty array keeps its storage
+            bool shrinkToFit() {
+                if (_size == capacity() || _size == 0) return true;
+                return grow(_size);
+            }
+
             T & pop() {
                 aassert(isValid(), "popping from an invalid array");
                 aassert(_size > 0, "popping from an empty array");
@@ -455,17 +1500,57 @@ namespace achilles {
                 return isValid();
             }
 
-            T remove(u64 index) {
-                aassert(isValid(), "removing a value from an invalid array");
-                aassert(_size > 0, "removing a value from an empty array");
-                aassert(index >= 0 && index < _size, "Array.remove: index out of bound");
+            T remove(u64 index) {
+                aassert(isValid(), "removing a value from an invalid array");
+                aassert(_size > 0, "removing a value from an empty array");
+                aassert(index >= 0 && index < _size, "Array.remove: index out of bound");
+                T *memory = (T *) _block;
+                T item = std::move(memory[index]);
+                removeRange(index, index + 1);
+                return item;
+            }
+
+            // removes the elements in [low, high), shifting the tail down once
+            void removeRange(u64 low, u64 high) {
+                aassert(low <= high && high <= _size, "Array.removeRange: invalid range");
+                if (low == high) return;
+                T *memory = (T *) _block;
+                u64 tail = _size - high;
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    destroy(memory + low, high - low);
+                    memmove(memory + low, memory + high, tail * sizeof(T));
+                } else {
+                    for (u64 i = 0; i < tail; ++i) {
+                        memory[low + i] = std::move(memory[high + i]);
+                    }
+                    destroy(memory + low + tail, high - low);
+                }
+                _size -= high - low;
+            }
+
+            // inserts 'value' before 'index', shifting the rest up once, 'index' can be 'size()' to append
+            bool insert(u64 index, T value) {
+                aassert(index <= _size, "Array.insert: index out of bound");
+                if (capacity() == _size) {
+                    if (!grow(Growth::next(capacity(), _size + 1))) {
+                        return false;
+                    }
+                }
                 T *memory = (T *) _block;
-                T item = memory[index];
-                for (auto i = index + 1; i < _size; ++i) {
-                    memory[i - 1] = memory[i];
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    memmove(memory + index + 1, memory + index, (_size - index) * sizeof(T));
+                    new (memory + index) T(std::move(value));
+                } else if (index == _size) {
+                    new (memory + index) T(std::move(value));
+                } else {
+                    new (memory + _size) T(std::move(memory[_size - 1]));
+                    for (u64 i = _size - 1; i > index; --i) {
+                        memory[i] = std::move(memory[i - 1]);
+                    }
+                    memory[index] = std::move(value);
                 }
-                _size -= 1;
-                return item;
+                _size += 1;
+                return true;
             }
 
             void swap(u64 first, u64 second) {
@@ -475,9 +1560,16 @@ namespace achilles {
                 aassert(second >= 0 && second < _size, "Array.swap: second index out of bound");
                 aassert(first != second, "Array.swap: first and second are the same!");
                 T *memory = (T *) _block;
-                T temp = memory[first];
-                memory[first] = memory[second];
-                memory[second] = temp;
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    alignas(T) u8 temp[sizeof(T)];
+                    memcpy(temp, memory + first, sizeof(T));
+                    memcpy((void *) (memory + first), memory + second, sizeof(T));
+                    memcpy((void *) (memory + second), temp, sizeof(T));
+                } else {
+                    T temp = std::move(memory[first]);
+                    memory[first] = std::move(memory[second]);
+                    memory[second] = std::move(temp);
+                }
             }
 
             // removes the element by swapping it with the last element
@@ -485,37 +1577,30 @@ namespace achilles {
                 aassert(isValid(), "removing a value from an invalid array");
                 aassert(_size > 0, "removing a value from an empty array");
                 aassert(index >= 0 && index < _size, "Array.swapRemove: index out of bound");
-                swap(index, --_size);
+                if (index != _size - 1) swap(index, _size - 1);
                 T *memory = (T *) _block;
-                return memory[_size];
+                T item = std::move(memory[--_size]);
+                destroy(memory + _size, 1);
+                return item;
             }
 
-            u64 find(T value) const {
-                aassert(isValid(), "trying to find a value from an invalid array");
+            u64 find(T const &value) const {
                 if (_size == 0) return U64_MAX;
-                T *memory = (T *) _block;
-                for (auto i = 0; i < _size; ++i) {
-                    if (value == memory[i]) {
-                        return i;
-                    }
-                }
-                return U64_MAX;
+                aassert(isValid(), "trying to find a value from an invalid array");
+                return simd::find<T>((T *) _block, _size, value);
             }
 
             void clear() {
+                destroy((T *) _block, _size);
                 _size = 0;
             }
 
             ~Array() {
                 if (!isValid()) return;
-                T *mem = (T *) _block;
-                for (auto i = 0; i < _size; ++i) {
-                    mem[i].~T();
-                }
                 clear();
             }
 
-            Block & operator &() {
+            BasicBlock<A> & operator &() {
                 return _block;
             }
 
@@ -542,10 +1627,472 @@ namespace achilles {
                 };
             }
         private:
-            Block _block;
+            // grows the storage to 'newCapacity' elements, in place when the allocator can (e.g. the most recent
+            // allocation of an 'ArenaAllocator'), otherwise by copying into a fresh block from the same allocator
+            // types that aren't trivially relocatable can't go through 'tryResize', since it may move the block
+            // with a plain copy ('realloc'), so they're always move-constructed into a fresh block
+            bool grow(u64 newCapacity) {
+                u64 newSize = newCapacity * sizeof(T);
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    if (resizeStorage(newSize)) return true;
+                }
+                A &allocator = _block.allocator();
+                u8 *memory = allocateStorage(allocator, newSize);
+                if (memory == nullptr) return false;
+                if constexpr (is_trivially_relocatable_v<T>) {
+                    if (_size > 0) memcpy(memory, (u8 *) _block, _size * sizeof(T));
+                } else {
+                    T *source = (T *) _block;
+                    T *destination = (T *) memory;
+                    for (u64 i = 0; i < _size; ++i) {
+                        new (destination + i) T(std::move(source[i]));
+                    }
+                    destroy(source, _size);
+                }
+                _block = BasicBlock<A> { memory, newSize, allocator };
+                return true;
+            }
+
+            static void destroy(T *memory, u64 count) {
+                if constexpr (!std::is_trivially_destructible_v<T>) {
+                    for (u64 i = 0; i < count; ++i) {
+                        memory[i].~T();
+                    }
+                }
+            }
+
+            // changes the size without constructing new elements, destroying the ones dropped
+            bool setSize(u64 newSize) {
+                if (newSize < _size) {
+                    destroy(((T *) _block) + newSize, _size - newSize);
+                } else if (!reserve(newSize)) {
+                    return false;
+                }
+                _size = newSize;
+                return true;
+            }
+
+            // plain allocations are already 'DEFAULT_ALIGNMENT' aligned, only larger alignments need the aligned calls
+            static u8 *allocateStorage(A &allocator, u64 size) {
+                if constexpr (Alignment <= DEFAULT_ALIGNMENT) return Traits::allocate(allocator, size);
+                else return Traits::allocateAligned(allocator, size, Alignment);
+            }
+
+            bool resizeStorage(u64 newSize) {
+                if constexpr (Alignment <= DEFAULT_ALIGNMENT) return _block.tryResize(newSize);
+                else return _block.tryResize(newSize, Alignment);
+            }
+
+            BasicBlock<A> _block;
             u64 _size = 0;
         };
 
+        // maps 'Handle's (see 'HandleType') to values that stay densely packed, so they can be iterated through
+        // 'values()' like an 'Array'. a handle packs a slot index and the slot's generation, which changes on every
+        // removal, so handles to removed values are detected instead of silently resolving to whatever moved into
+        // their place. every operation is O(1), removal moves the last value into the hole
+        template<typename T, typename Handle, typename A = Allocator>
+        struct SlotMap {
+            using Value = typename Handle::Value;
+            static_assert(std::is_unsigned_v<Value> && sizeof(Value) >= 4, "slot map handles must be unsigned integers of at least 32 bits");
+
+            // 32-bit handles get 20 bits of index and 12 of generation, 64-bit ones 32 each
+            static constexpr u64 INDEX_BITS = sizeof(Value) == 8 ? 32 : 20;
+            static constexpr u64 GENERATION_BITS = sizeof(Value) * 8 - INDEX_BITS;
+            // the all-ones index is never handed out, so with generations starting at one neither zero nor all
+            // ones can be a valid handle
+            static constexpr u64 MAX_SLOTS = (1ULL << INDEX_BITS) - 1;
+
+            SlotMap(A &allocator = AllocatorHandle<A>::defaultInstance(), u64 capacity = 0)
+                : _values{allocator, capacity},
+                  _owners{allocator, capacity},
+                  _slots{allocator, capacity} {}
+
+            explicit SlotMap(u64 capacity) requires AllocatorHandle<A>::STATELESS : SlotMap(A::instance(), capacity) {}
+
+            u64 size() const {
+                return _values.size();
+            }
+
+            bool reserve(u64 capacity) {
+                return _values.reserve(capacity) && _owners.reserve(capacity) && _slots.reserve(capacity);
+            }
+
+            // returns 'Handle::invalid()' when out of memory or slots
+            Handle insert(T value) {
+                return emplace(std::move(value));
+            }
+
+            template<typename... Args>
+            Handle emplace(Args &&...args) {
+                u32 slotIndex = _freeHead;
+                if (slotIndex == FREE_END) {
+                    if (_slots.size() == MAX_SLOTS) return Handle::invalid();
+                    slotIndex = (u32) _slots.size();
+                    if (!_slots.push(Slot { FREE_END, nextGeneration(slotIndex, 0) })) return Handle::invalid();
+                    _freeHead = slotIndex;
+                }
+                Slot &slot = _slots[slotIndex];
+                u32 denseIndex = (u32) _values.size();
+                if (!_values.emplace(std::forward<Args>(args)...)) return Handle::invalid();
+                if (!_owners.push(slotIndex)) {
+                    _values.pop();
+                    return Handle::invalid();
+                }
+                _freeHead = slot.index;
+                slot.index = denseIndex;
+                return makeHandle(slotIndex, slot.generation);
+            }
+
+            // null when 'handle' was removed or doesn't name a live slot of this map. a handle from another map
+            // that happens to name a live slot here resolves to its value
+            T *get(Handle handle) const {
+                u32 denseIndex = denseIndexOf(handle);
+                return denseIndex == FREE_END ? nullptr : &_values[denseIndex];
+            }
+
+            bool contains(Handle handle) const {
+                return denseIndexOf(handle) != FREE_END;
+            }
+
+            bool remove(Handle handle) {
+                u32 denseIndex = denseIndexOf(handle);
+                if (denseIndex == FREE_END) return false;
+                u32 slotIndex = (u32) ((Value) handle & INDEX_MASK);
+                u64 last = _values.size() - 1;
+                _values.swapRemove(denseIndex);
+                _owners.swapRemove(denseIndex);
+                if (denseIndex != last) _slots[_owners[denseIndex]].index = denseIndex;
+                Slot &slot = _slots[slotIndex];
+                slot.generation = nextGeneration(slotIndex, slot.generation);
+                slot.index = _freeHead;
+                _freeHead = slotIndex;
+                return true;
+            }
+
+            // removes every value, invalidating every handle
+            void clear() {
+                while (_values.size() > 0) {
+                    remove(handleAt(_values.size() - 1));
+                }
+            }
+
+            // the densely packed values, in no particular order. removing a value can move another one
+            Slice<T> values() {
+                return _values.slice();
+            }
+
+            // the handle of 'values()[index]'
+            Handle handleAt(u64 index) const {
+                aassert(index < _values.size(), "SlotMap.handleAt: index out of bound");
+                u32 slotIndex = _owners[index];
+                return makeHandle(slotIndex, _slots[slotIndex].generation);
+            }
+        private:
+            static constexpr Value INDEX_MASK = (Value) MAX_SLOTS;
+            static constexpr u32 GENERATION_MASK = (u32) ((1ULL << GENERATION_BITS) - 1);
+            static constexpr u32 FREE_END = U32_MAX;
+
+            // 'index' is the value's position in '_values', or the next free slot while the slot is free
+            struct Slot {
+                u32 index;
+                u32 generation;
+            };
+
+            static Handle makeHandle(u32 slotIndex, u32 generation) {
+                return Handle { (Value) (((Value) generation << INDEX_BITS) | slotIndex) };
+            }
+
+            // generations wrap around, skipping zero and whatever would collide with 'Handle::invalid()'
+            static u32 nextGeneration(u32 slotIndex, u32 generation) {
+                do {
+                    generation = (generation + 1) & GENERATION_MASK;
+                } while (generation == 0 || (Value) makeHandle(slotIndex, generation) == Handle::DEFAULT);
+                return generation;
+            }
+
+            u32 denseIndexOf(Handle handle) const {
+                Value value = (Value) handle;
+                u64 slotIndex = value & INDEX_MASK;
+                if (slotIndex >= _slots.size()) return FREE_END;
+                Slot const &slot = _slots[slotIndex];
+                if (slot.generation != (u32) (value >> INDEX_BITS)) return FREE_END;
+                // a free slot's index is the free list link, a handle from another map (or a made up one) can
+                // still carry its generation, so the dense entry has to point back at the slot
+                if (slot.index >= _values.size() || _owners[slot.index] != slotIndex) return FREE_END;
+                return slot.index;
+            }
+
+            Array<T, A> _values;
+            Array<u32, A> _owners;
+            Array<Slot, A> _slots;
+            u32 _freeHead = FREE_END;
+        };
+
+        // a source location allocations are attributed to, see 'allocation_site'
+        struct AllocationSite {
+            char const *file;
+            int line;
+
+            // the innermost site of the calling thread, 'nullptr' when outside of any
+            static AllocationSite const *&current() {
+                thread_local AllocationSite const *_current = nullptr;
+                return _current;
+            }
+
+            static AllocationSite const *enter(AllocationSite const *site) {
+                AllocationSite const *previous = current();
+                current() = site;
+                return previous;
+            }
+
+            static void leave(AllocationSite const *previous) {
+                current() = previous;
+            }
+        };
+
+        // attributes every allocation made through a 'TrackingAllocator' until the end of the scope, including
+        // the ones made deep inside e.g. 'Array::push', to this file and line. only one per line
+        #if ACHILLES_TRACKING
+            #define allocation_site()\
+                static achilles::memory::AllocationSite const macro_concat2(ALLOCATION_SITE_, __LINE__) { __FILE__, __LINE__ };\
+                auto macro_concat2(ALLOCATION_PREVIOUS_, __LINE__) = achilles::memory::AllocationSite::enter(&macro_concat2(ALLOCATION_SITE_, __LINE__));\
+                defer { achilles::memory::AllocationSite::leave(macro_concat2(ALLOCATION_PREVIOUS_, __LINE__)); }
+        #else
+            #define allocation_site() ((void) 0)
+        #endif
+
+        struct AllocationStats {
+            u64 allocations = 0;
+            u64 failedAllocations = 0;
+            u64 deallocations = 0;
+            u64 resizes = 0;
+            u64 failedResizes = 0;
+            u64 bytesAllocated = 0;
+            u64 liveBytes = 0;
+            u64 peakBytes = 0;
+
+            u64 liveAllocations() const {
+                return allocations - deallocations;
+            }
+        };
+
+        // wraps another allocator and records counts, bytes, peak usage and resizes, in total and per
+        // 'allocation_site'. every block carries a small header in front of it naming its site, so blocks seen
+        // by the wrapped allocator are 'DEFAULT_ALIGNMENT' bytes (or the requested alignment) larger. in release
+        // builds, unless 'RELEASE_TRACKING' is defined, it only forwards to the wrapped allocator
+        struct TrackingAllocator : Allocator {
+            explicit TrackingAllocator(Allocator &inner, bool reportOnDestruction = false)
+                : _inner{&inner}, _reportOnDestruction{reportOnDestruction} {
+                #if ACHILLES_TRACKING
+                    _sites.push(SiteStats { nullptr, {} });
+                #endif
+            }
+
+            TrackingAllocator(TrackingAllocator const &other) = delete;
+            TrackingAllocator &operator =(TrackingAllocator const &other) = delete;
+
+            ~TrackingAllocator() {
+                if (_reportOnDestruction) report();
+            }
+
+            u8 * allocate(u64 size) override {
+                return allocateAligned(size, DEFAULT_ALIGNMENT);
+            }
+
+            bool tryResize(u8 **memory, u64 oldSize, u64 newSize) override {
+                return tryResizeAligned(memory, oldSize, newSize, DEFAULT_ALIGNMENT);
+            }
+
+            void deallocate(u8 **memory, u64 size) override {
+                #if ACHILLES_TRACKING
+                    if (memory == nullptr || *memory == nullptr) return;
+                    Header header = headerOf(*memory);
+                    u8 *base = *memory - header.size;
+                    _inner->deallocate(&base, size + header.size);
+                    *memory = nullptr;
+                    released(_total, size);
+                    released(_sites[header.site].stats, size);
+                #else
+                    _inner->deallocate(memory, size);
+                #endif
+            }
+
+            // every block has at least the smallest header in front of it, so that much is checked before the
+            // header is read for the actual size, which is 'alignment' bytes for blocks from 'allocateAligned'
+            bool owns(u8 *const memory, u64 size) const override {
+                #if ACHILLES_TRACKING
+                    if (memory == nullptr || !_inner->owns(memory - headerSizeFor(1), size + headerSizeFor(1))) return false;
+                    u32 headerSize = headerOf(memory).size;
+                    return _inner->owns(memory - headerSize, size + headerSize);
+                #else
+                    return _inner->owns(memory, size);
+                #endif
+            }
+
+            // for 'allocate', which takes the header of the default alignment
+            bool canAllocate(u64 size) const override {
+                #if ACHILLES_TRACKING
+                    return _inner->canAllocate(size + headerSizeFor(DEFAULT_ALIGNMENT));
+                #else
+                    return _inner->canAllocate(size);
+                #endif
+            }
+
+            bool canDeallocate(u8 *const memory, u64 size) const override {
+                #if ACHILLES_TRACKING
+                    if (!owns(memory, size)) return false;
+                    u32 headerSize = headerOf(memory).size;
+                    return _inner->canDeallocate(memory - headerSize, size + headerSize);
+                #else
+                    return _inner->canDeallocate(memory, size);
+                #endif
+            }
+
+            u8 * allocateAligned(u64 size, u64 alignment) override {
+                #if ACHILLES_TRACKING
+                    u32 site = siteIndex(AllocationSite::current());
+                    u64 headerSize = headerSizeFor(alignment);
+                    u8 *base = _inner->allocateAligned(size + headerSize, alignment);
+                    if (base == nullptr) {
+                        _total.failedAllocations += 1;
+                        if (site != U32_MAX) _sites[site].stats.failedAllocations += 1;
+                        return nullptr;
+                    }
+                    if (site == U32_MAX) site = 0;
+                    u8 *result = base + headerSize;
+                    writeHeader(result, Header { site, (u32) headerSize });
+                    acquired(_total, size);
+                    acquired(_sites[site].stats, size);
+                    return result;
+                #else
+                    return _inner->allocateAligned(size, alignment);
+                #endif
+            }
+
+            bool tryResizeAligned(u8 **memory, u64 oldSize, u64 newSize, u64 alignment) override {
+                #if ACHILLES_TRACKING
+                    if (memory == nullptr || *memory == nullptr) return false;
+                    Header header = headerOf(*memory);
+                    u8 *base = *memory - header.size;
+                    AllocationStats &stats = _sites[header.site].stats;
+                    _total.resizes += 1;
+                    stats.resizes += 1;
+                    if (!_inner->tryResizeAligned(&base, oldSize + header.size, newSize + header.size, alignment)) {
+                        _total.failedResizes += 1;
+                        stats.failedResizes += 1;
+                        return false;
+                    }
+                    *memory = base + header.size;
+                    resized(_total, oldSize, newSize);
+                    resized(stats, oldSize, newSize);
+                    return true;
+                #else
+                    return _inner->tryResizeAligned(memory, oldSize, newSize, alignment);
+                #endif
+            }
+
+            AllocationStats const &stats() const {
+                return _total;
+            }
+
+            // prints the totals and one line per site, sites with live allocations are leaks if this runs at shutdown
+            void report(FILE *out = stderr) const {
+                #if ACHILLES_TRACKING
+                    fprintf(
+                        out,
+                        "allocations: %llu (%llu failed), deallocations: %llu, live: %llu (%llu bytes), peak: %llu bytes, resizes: %llu (%llu failed)\n",
+                        _total.allocations, _total.failedAllocations, _total.deallocations,
+                        _total.liveAllocations(), _total.liveBytes, _total.peakBytes,
+                        _total.resizes, _total.failedResizes
+                    );
+                    for (u64 i = 0; i < _sites.size(); ++i) {
+                        SiteStats const &site = _sites[i];
+                        if (site.stats.allocations == 0 && site.stats.failedAllocations == 0) continue;
+                        fprintf(
+                            out,
+                            "    %s:%i allocations: %llu, live: %llu (%llu bytes), peak: %llu bytes, resizes: %llu (%llu failed)\n",
+                            site.site ? site.site->file : "<unknown>", site.site ? site.site->line : 0,
+                            site.stats.allocations, site.stats.liveAllocations(), site.stats.liveBytes,
+                            site.stats.peakBytes, site.stats.resizes, site.stats.failedResizes
+                        );
+                    }
+                #else
+                    (void) out;
+                #endif
+            }
+        private:
+            struct Header {
+                u32 site;
+                u32 size;
+            };
+
+            struct SiteStats {
+                AllocationSite const *site;
+                AllocationStats stats;
+            };
+
+            // the padding in front of a block, which keeps the block aligned and holds the header at its end
+            static constexpr u64 headerSizeFor(u64 alignment) {
+                return alignment < DEFAULT_ALIGNMENT ? DEFAULT_ALIGNMENT : alignment;
+            }
+
+            // the header sits right in front of the block, at the end of the padding
+            static Header headerOf(u8 *const memory) {
+                Header header;
+                memcpy(&header, memory - sizeof(Header), sizeof(Header));
+                return header;
+            }
+
+            static void writeHeader(u8 *memory, Header header) {
+                memcpy(memory - sizeof(Header), &header, sizeof(Header));
+            }
+
+            static void acquired(AllocationStats &stats, u64 size) {
+                stats.allocations += 1;
+                stats.bytesAllocated += size;
+                stats.liveBytes += size;
+                if (stats.liveBytes > stats.peakBytes) stats.peakBytes = stats.liveBytes;
+            }
+
+            static void released(AllocationStats &stats, u64 size) {
+                stats.deallocations += 1;
+                stats.liveBytes -= size;
+            }
+
+            static void resized(AllocationStats &stats, u64 oldSize, u64 newSize) {
+                stats.liveBytes = stats.liveBytes - oldSize + newSize;
+                if (newSize > oldSize) stats.bytesAllocated += newSize - oldSize;
+                if (stats.liveBytes > stats.peakBytes) stats.peakBytes = stats.liveBytes;
+            }
+
+            #if ACHILLES_TRACKING
+            // finds or adds the record of 'site', scanning from the most recently used one, 'U32_MAX' if the
+            // record can't be stored
+            u32 siteIndex(AllocationSite const *site) {
+                if (site == nullptr) return 0;
+                if (_sites[_lastSite].site == site) return _lastSite;
+                for (u64 i = 1; i < _sites.size(); ++i) {
+                    if (_sites[i].site == site) {
+                        _lastSite = (u32) i;
+                        return _lastSite;
+                    }
+                }
+                if (!_sites.push(SiteStats { site, {} })) return U32_MAX;
+                _lastSite = (u32) (_sites.size() - 1);
+                return _lastSite;
+            }
+            #endif
+
+            Allocator *_inner;
+            bool _reportOnDestruction;
+            AllocationStats _total {};
+            #if ACHILLES_TRACKING
+                Array<SiteStats, GlobalAllocator> _sites {};
+                u32 _lastSite = 0;
+            #endif
+        };
+
         template<typename T, typename W>
         struct RelativePointer {
             RelativePointer() : base(nullptr), offset(0) {}
@@ -664,38 +2211,407 @@ namespace achilles {
             u64  offset;
         };
 
+        // a pointer stored as the distance from itself to its target, so a structure made of them means the same
+        // wherever its bytes are, e.g. in a mapped file. zero is null, a pointer can't point to itself. copying one
+        // keeps the target and recomputes the distance from the copy
         template<typename T>
         struct OffsetPointer {
-            OffsetPointer(u64 offset) : _offset(offset) {}
+            OffsetPointer() : _offset(0) {}
+
+            explicit OffsetPointer(s64 offset) : _offset(offset) {}
+
+            OffsetPointer(OffsetPointer const &other) {
+                set(other.asPtr());
+            }
+
+            OffsetPointer &operator =(OffsetPointer const &other) {
+                set(other.asPtr());
+                return *this;
+            }
+
+            OffsetPointer &operator =(T *target) {
+                set(target);
+                return *this;
+            }
 
-            explicit operator T*() {
+            explicit operator T*() const {
                 return asPtr();
             }
 
-            T * operator->() {
+            T * operator->() const {
                 return asPtr();
             }
 
-            T &operator *() {
+            T &operator *() const {
                 return *(asPtr());
             }
 
-            T **operator&() {
-                return &(asPtr());
+            explicit operator bool() const {
+                return isValid();
             }
 
-            operator bool() {
+            bool isValid() const {
+                return _offset != 0;
+            }
+
+            T *get() const {
+                return asPtr();
+            }
+
+            void set(T *target) {
+                _offset = target ? (s64) ((char const *) target - (char const *) this) : 0;
+            }
+
+            s64 offset() const {
+                return _offset;
+            }
+        private:
+            T *asPtr() const {
+                return isValid() ? reinterpret_cast<T *>(((char *) this) + _offset) : nullptr;
+            }
+            s64 _offset;
+        };
+
+        // 'count' elements starting at an offset pointer, how relocatable data stores arrays and strings
+        template<typename T>
+        struct OffsetSlice {
+            OffsetPointer<T> data {};
+            u64 count = 0;
+
+            void set(T *values, u64 size) {
+                data.set(values);
+                count = size;
+            }
+
+            u64 size() const {
+                return count;
+            }
+
+            T &operator [](u64 index) const {
+                aassert(index < count, "offset slice index out of bounds");
+                return data.get()[index];
+            }
+
+            T *begin() const {
+                return data.get();
+            }
+
+            T *end() const {
+                return data.get() + count;
+            }
+
+            Slice<T> slice() const {
+                return Slice<T> { data.get(), count };
+            }
+        };
+
+        // whether 'size' bytes at 'memory', aligned to 'alignment', lie inside 'range'. works on addresses so
+        // nothing out of range is ever formed as a pointer
+        inline bool isInside(Slice<u8 const> range, void const *memory, u64 size, u64 alignment) {
+            u64 low = (u64) (u8 const *) range;
+            u64 high = low + range.size();
+            u64 address = (u64) memory;
+            return address >= low && address <= high && high - address >= size && (address & (alignment - 1)) == 0;
+        }
+
+        template<typename T>
+        struct RelativeSlice;
+
+        // resolves offset pointers inside one block, e.g. a mapping, making sure every target lies inside it.
+        // a pointer that leaves the block resolves to null, so data from untrusted files can be walked without
+        // copying it first. with 'ACHILLES_BOUNDS_CHECKS' off it doesn't keep the block and is a plain pointer
+        template<typename T>
+        struct SafeOffsetPointer {
+            SafeOffsetPointer() = default;
+
+            // 'target' must already be known to be inside 'range', like the root of a checked blob
+            SafeOffsetPointer(T *target, Slice<u8 const> range) : _target{target} {
+                #if ACHILLES_BOUNDS_CHECKS
+                    _range = range;
+                    if (!isInside(range, target, sizeof(T), alignof(T))) _target = nullptr;
+                #else
+                    (void) range;
+                #endif
+            }
+
+            // 'pointer' must itself be inside 'range'
+            SafeOffsetPointer(OffsetPointer<std::remove_cv_t<T>> const &pointer, Slice<u8 const> range) {
+                if (!pointer.isValid()) return;
+                #if ACHILLES_BOUNDS_CHECKS
+                    _range = range;
+                    void const *target = (void const *) ((u64) &pointer + (u64) pointer.offset());
+                    if (!isInside(range, target, sizeof(T), alignof(T))) return;
+                #else
+                    (void) range;
+                #endif
+                _target = pointer.get();
+            }
+
+            T * operator->() const {
+                aassert(_target != nullptr, "dereferencing an invalid safe offset pointer");
+                return _target;
+            }
+
+            T &operator *() const {
+                aassert(_target != nullptr, "dereferencing an invalid safe offset pointer");
+                return *_target;
+            }
+
+            explicit operator bool() const {
                 return isValid();
             }
 
             bool isValid() const {
-                return _offset != 0;
+                return _target != nullptr;
+            }
+
+            T *get() const {
+                return _target;
+            }
+
+            // the offset pointer 'member' of the target, checked against the same block
+            template<typename U, typename C>
+            auto follow(OffsetPointer<U> C::*member) const {
+                static_assert(std::is_same_v<std::remove_cv_t<T>, C>, "member of another type");
+                using Result = SafeOffsetPointer<std::conditional_t<std::is_const_v<T>, U const, U>>;
+                if (_target == nullptr) return Result {};
+                return Result { _target->*member, range() };
+            }
+
+            // the offset slice 'member' of the target, checked against the same block
+            template<typename U, typename C>
+            auto follow(OffsetSlice<U> C::*member) const {
+                static_assert(std::is_same_v<std::remove_cv_t<T>, C>, "member of another type");
+                using Result = RelativeSlice<std::conditional_t<std::is_const_v<T>, U const, U>>;
+                if (_target == nullptr) return Result {};
+                return Result { _target->*member, range() };
+            }
+
+            Slice<u8 const> range() const {
+                #if ACHILLES_BOUNDS_CHECKS
+                    return _range;
+                #else
+                    return Slice<u8 const> { nullptr, 0 };
+                #endif
+            }
+        private:
+            T *_target = nullptr;
+            #if ACHILLES_BOUNDS_CHECKS
+                Slice<u8 const> _range { nullptr, 0 };
+            #endif
+        };
+
+        // the slice counterpart of 'SafeOffsetPointer', an 'OffsetSlice' whose whole extent was checked to lie
+        // inside its block. one that doesn't is empty
+        template<typename T>
+        struct RelativeSlice {
+            RelativeSlice() = default;
+
+            // 'slice' must itself be inside 'range'
+            RelativeSlice(OffsetSlice<std::remove_cv_t<T>> const &slice, Slice<u8 const> range) {
+                if (!slice.data.isValid() || slice.count == 0) return;
+                #if ACHILLES_BOUNDS_CHECKS
+                    _range = range;
+                    void const *first = (void const *) ((u64) &slice.data + (u64) slice.data.offset());
+                    if (slice.count > range.size() / sizeof(T)) return;
+                    if (!isInside(range, first, slice.count * sizeof(T), alignof(T))) return;
+                #else
+                    (void) range;
+                #endif
+                _memory = slice.data.get();
+                _size = slice.count;
+            }
+
+            u64 size() const {
+                return _size;
+            }
+
+            T &operator [](u64 index) const {
+                aassert(index < _size, "relative slice index out of bounds");
+                return _memory[index];
+            }
+
+            // the element at 'index' as a pointer, to follow its own offset pointers
+            SafeOffsetPointer<T> at(u64 index) const {
+                aassert(index < _size, "relative slice index out of bounds");
+                return SafeOffsetPointer<T> { _memory + index, range() };
+            }
+
+            T *begin() const {
+                return _memory;
+            }
+
+            T *end() const {
+                return _memory + _size;
+            }
+
+            Slice<T> slice() const {
+                return Slice<T> { _memory, _size };
+            }
+
+            Slice<u8 const> range() const {
+                #if ACHILLES_BOUNDS_CHECKS
+                    return _range;
+                #else
+                    return Slice<u8 const> { nullptr, 0 };
+                #endif
+            }
+        private:
+            T *_memory = nullptr;
+            u64 _size = 0;
+            #if ACHILLES_BOUNDS_CHECKS
+                Slice<u8 const> _range { nullptr, 0 };
+            #endif
+        };
+
+        // an owning 'types::Any': a value of any type, checked against its 'typehash' when it is read back. values
+        // of up to 'INLINE_SIZE' bytes that move without throwing are stored inside the object, bigger ones in a
+        // block from 'allocator'. can be moved but not copied
+        //
+        //     AnyValue setting { 0.5f };
+        //     if (f32 *volume = setting.get<f32>()) *volume *= 2;
+        //     setting = AnyValue { std::string { "loud" } };
+        struct AnyValue {
+            static constexpr u64 INLINE_SIZE = 32;
+
+            explicit AnyValue(Allocator &allocator = GlobalAllocator::instance()) : _allocator{&allocator} {}
+
+            // empty when the value doesn't fit inline and the allocation failed. allocators aren't taken as values,
+            // so 'AnyValue { arena }' picks the constructor above
+            template<typename T> requires (!std::is_base_of_v<Allocator, std::remove_cvref_t<T>> && !std::is_same_v<std::remove_cvref_t<T>, AnyValue>)
+            AnyValue(T &&value, Allocator &allocator = GlobalAllocator::instance()) : _allocator{&allocator} {
+                emplace<std::decay_t<T>>(std::forward<T>(value));
+            }
+
+            AnyValue(AnyValue const &other) = delete;
+            AnyValue &operator =(AnyValue const &other) = delete;
+
+            AnyValue(AnyValue &&other) : _allocator{other._allocator} {
+                take(other);
+            }
+
+            // the allocator comes along with the value
+            AnyValue &operator =(AnyValue &&other) {
+                if (this != &other) {
+                    reset();
+                    _allocator = other._allocator;
+                    take(other);
+                }
+                return *this;
+            }
+
+            ~AnyValue() {
+                reset();
+            }
+
+            // replaces the value with a 'T' made from 'args', false when it had to be allocated and that failed
+            template<typename T, typename... Args>
+            bool emplace(Args &&...args) {
+                static_assert(std::is_same_v<T, std::decay_t<T>>, "any values hold plain types, not references or arrays");
+                reset();
+                void *memory = _inline;
+                if constexpr (!Operations::template fitsInline<T>()) {
+                    memory = _allocator->allocateAligned(sizeof(T), alignof(T));
+                    if (memory == nullptr) return false;
+                    _heap = memory;
+                }
+                new (memory) T(std::forward<Args>(args)...);
+                _operations = &Operations::template of<T>;
+                return true;
+            }
+
+            void reset() {
+                if (_operations == nullptr) return;
+                void *value = data();
+                _operations->destroy(value);
+                if (!_operations->storedInline) {
+                    u8 *memory = (u8 *) value;
+                    _allocator->deallocate(&memory, _operations->size);
+                }
+                _operations = nullptr;
+            }
+
+            bool isEmpty() const {
+                return _operations == nullptr;
+            }
+
+            // zero when empty
+            types::TypeHash type() const {
+                return _operations ? _operations->type : 0;
+            }
+
+            template<typename T>
+            bool is() const {
+                return _operations != nullptr && _operations->type == types::typehash<T>;
+            }
+
+            // null unless it holds a 'T'
+            template<typename T>
+            T *get() {
+                return is<T>() ? (T *) data() : nullptr;
+            }
+
+            template<typename T>
+            T const *get() const {
+                return is<T>() ? (T const *) data() : nullptr;
+            }
+
+            template<typename T>
+            T &value() {
+                aassert(is<T>(), "any value holds a different type");
+                return *(T *) data();
+            }
+
+            template<typename T>
+            T const &value() const {
+                aassert(is<T>(), "any value holds a different type");
+                return *(T const *) data();
             }
         private:
-            T *asPtr() {
-                return isValid() ? *reinterpret_cast<T *>(((char *) &_offset) + _offset) : nullptr;
+            struct Operations {
+                void (*move)(void *from, void *to);
+                void (*destroy)(void *value);
+                types::TypeHash type;
+                u64 size;
+                bool storedInline;
+
+                template<typename T>
+                static constexpr bool fitsInline() {
+                    return sizeof(T) <= INLINE_SIZE && alignof(T) <= DEFAULT_ALIGNMENT && std::is_nothrow_move_constructible_v<T>;
+                }
+
+                template<typename T>
+                static constexpr Operations of {
+                    [](void *from, void *to) {
+                        new (to) T(std::move(*(T *) from));
+                        ((T *) from)->~T();
+                    },
+                    [](void *value) { ((T *) value)->~T(); },
+                    types::typehash<T>,
+                    sizeof(T),
+                    fitsInline<T>(),
+                };
+            };
+
+            void *data() const {
+                return _operations->storedInline ? (void *) _inline : _heap;
+            }
+
+            // the other one is left empty, values stored in a block only hand the block over
+            void take(AnyValue &other) {
+                if (other._operations == nullptr) return;
+                if (other._operations->storedInline) other._operations->move(other._inline, _inline);
+                else _heap = other._heap;
+                _operations = other._operations;
+                other._operations = nullptr;
             }
-            u64 _offset;
+
+            union {
+                alignas(DEFAULT_ALIGNMENT) u8 _inline[INLINE_SIZE];
+                void *_heap;
+            };
+            Operations const *_operations = nullptr;
+            Allocator *_allocator;
         };
     }
 }
@@ -0,0 +1,263 @@
+#if !defined(ACHILLES_PROFILE_HPP)
+#define ACHILLES_PROFILE_HPP
+
+// this file depends on <chrono> for the clock where there is no 'rdtsc', and on <mutex> so only one 'flush'
+// runs at a time
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include "types.hpp"
+#include "assert.hpp"
+#include "misc.hpp"
+#include "defer.hpp"
+#include "memory.hpp"
+#include "files.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+    #define ACHILLES_RDTSC 1
+#else
+    #define ACHILLES_RDTSC 0
+#endif
+
+// zones are only recorded when 'PROFILE' is defined, otherwise 'PROFILE_ZONE' compiles to nothing. they can
+// also be switched off at run time with 'profile::setEnabled', which leaves a relaxed load and a branch
+#if defined(PROFILE)
+    #define ACHILLES_PROFILING 1
+#else
+    #define ACHILLES_PROFILING 0
+#endif
+
+// zones each thread can hold between two flushes, a power of two. the ones past that are dropped and counted
+#if !defined(ACHILLES_PROFILE_EVENTS)
+    #define ACHILLES_PROFILE_EVENTS 16384
+#endif
+
+namespace achilles {
+    namespace profile {
+        // 'rdtsc' ticks on x86, which assumes an invariant tsc like every x86 of the last decade has, and
+        // 'steady_clock' nanoseconds elsewhere
+        inline u64 now() {
+            #if ACHILLES_RDTSC
+                return (u64) __rdtsc();
+            #else
+                return (u64) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            #endif
+        }
+
+        inline u64 nanoseconds() {
+            return (u64) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // 'name' isn't copied, it has to outlive the next 'flush', like a string literal or '__func__' does
+        struct Event {
+            char const *name;
+            u64 begin;
+            u64 end;
+        };
+
+        // the zones of one thread, a single producer single consumer ring: the thread moves 'written' and
+        // 'flush' moves 'read', so recording never takes a lock
+        struct ThreadBuffer {
+            static constexpr u64 CAPACITY = ACHILLES_PROFILE_EVENTS;
+            static_assert(memory::isPowerOfTwo(CAPACITY), "profile buffer capacity must be a power of two");
+
+            memory::CacheAligned<std::atomic<u64>> written {};
+            memory::CacheAligned<std::atomic<u64>> read {};
+            std::atomic<u64> dropped {0};
+            ThreadBuffer *next = nullptr;
+            u32 thread = 0;
+            Event events[CAPACITY];
+
+            // owner only, drops the zone when 'flush' hasn't kept up
+            void push(Event event) {
+                u64 index = written->load(std::memory_order_relaxed);
+                if (index - read->load(std::memory_order_acquire) >= CAPACITY) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                events[index & (CAPACITY - 1)] = event;
+                written->store(index + 1, std::memory_order_release);
+            }
+        };
+
+        struct State {
+            // every thread buffer ever made, pushed at the front. buffers outlive their threads, so zones of
+            // threads that have exited are still flushed
+            std::atomic<ThreadBuffer *> buffers {nullptr};
+            std::atomic<u32> threads {0};
+            std::atomic<bool> enabled {true};
+            std::mutex flushing;
+            // when the trace starts, in both clocks, to turn ticks into microseconds
+            u64 originTicks = now();
+            u64 originNanoseconds = nanoseconds();
+        };
+
+        inline State &state() {
+            static State _state {};
+            return _state;
+        }
+
+        inline void setEnabled(bool enabled) {
+            state().enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        inline bool isEnabled() {
+            return state().enabled.load(std::memory_order_relaxed);
+        }
+
+        // the calling thread's buffer, allocated the first time the thread records a zone. null when that
+        // allocation failed, the zone is lost then
+        inline ThreadBuffer *localBuffer() {
+            thread_local ThreadBuffer *_buffer = nullptr;
+            if (_buffer != nullptr) return _buffer;
+
+            State &global = state();
+            u8 *memory = memory::GlobalAllocator::instance().allocateAligned(sizeof(ThreadBuffer), alignof(ThreadBuffer));
+            if (memory == nullptr) return nullptr;
+            ThreadBuffer *buffer = new (memory) ThreadBuffer {};
+            buffer->thread = global.threads.fetch_add(1, std::memory_order_relaxed);
+            ThreadBuffer *head = global.buffers.load(std::memory_order_relaxed);
+            do {
+                buffer->next = head;
+            } while (!global.buffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+            _buffer = buffer;
+            return buffer;
+        }
+
+        // zero when profiling is switched off, which 'end' skips
+        inline u64 begin() {
+            return isEnabled() ? now() : 0;
+        }
+
+        inline void end(char const *name, u64 begin) {
+            if (begin == 0) return;
+            u64 end = now();
+            ThreadBuffer *buffer = localBuffer();
+            if (buffer) buffer->push(Event { name, begin, end });
+        }
+
+        // zones lost to full buffers since the start
+        inline u64 dropped() {
+            u64 result = 0;
+            for (ThreadBuffer *buffer = state().buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+                result += buffer->dropped.load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        struct TraceWriter {
+            memory::Array<u8> bytes;
+
+            bool append(char const *text, u64 length) {
+                return bytes.pushMany(memory::Slice<u8> { (u8 *) text, length });
+            }
+
+            bool append(char const *text) {
+                return append(text, strlen(text));
+            }
+
+            // a json string, zone names are usually plain identifiers but don't have to be
+            bool appendString(char const *text) {
+                bool ok = append("\"", 1);
+                char const *run = text;
+                for (char const *c = text; *c && ok; ++c) {
+                    bool quote = *c == '"' || *c == '\\';
+                    if (!quote && (u8) *c >= 0x20) continue;
+                    ok = append(run, (u64) (c - run)) && append(quote ? "\\" : "?", 1) && (!quote || append(c, 1));
+                    run = c + 1;
+                }
+                return ok && append(run, strlen(run)) && append("\"", 1);
+            }
+
+            bool appendNumber(u64 value) {
+                char digits[20];
+                u32 count = 0;
+                do {
+                    digits[19 - count++] = (char) ('0' + value % 10);
+                    value /= 10;
+                } while (value != 0);
+                return append(digits + 20 - count, count);
+            }
+
+            // nanoseconds as microseconds with three decimals, what the trace format counts in
+            bool appendMicroseconds(u64 nanoseconds) {
+                char decimals[4] = { '.', (char) ('0' + nanoseconds / 100 % 10), (char) ('0' + nanoseconds / 10 % 10), (char) ('0' + nanoseconds % 10) };
+                return appendNumber(nanoseconds / 1000) && append(decimals, 4);
+            }
+        };
+
+        // writes every zone recorded since the previous flush to 'path' as a chrome trace, which
+        // 'chrome://tracing', perfetto and tracy ('import-chrome') all read. the zones are taken out of the
+        // buffers, so the next flush starts where this one ended. false when the trace couldn't be built or
+        // written, 'error' says which
+        inline bool flush(const char *path, memory::Allocator &allocator = memory::GlobalAllocator::instance(), files::FileError *error = nullptr) {
+            State &global = state();
+            std::lock_guard<std::mutex> lock { global.flushing };
+
+            // nanoseconds per tick, measured against the steady clock over at least 10ms
+            f64 nanosecondsPerTick = 1.0;
+            #if ACHILLES_RDTSC
+                u64 endNanoseconds = nanoseconds();
+                while (endNanoseconds - global.originNanoseconds < 10000000) {
+                    endNanoseconds = nanoseconds();
+                }
+                u64 endTicks = now();
+                nanosecondsPerTick = (f64) (endNanoseconds - global.originNanoseconds) / (f64) (endTicks - global.originTicks);
+            #endif
+
+            TraceWriter trace { memory::Array<u8> { allocator, KB(64) } };
+            bool ok = trace.append("{\"traceEvents\":[\n");
+            bool first = true;
+            char line[160];
+            for (ThreadBuffer *buffer = global.buffers.load(std::memory_order_acquire); buffer && ok; buffer = buffer->next) {
+                int length = snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                    first ? "" : ",\n", buffer->thread, buffer->thread);
+                ok = trace.append(line, (u64) length);
+                first = false;
+
+                u64 read = buffer->read->load(std::memory_order_relaxed);
+                u64 written = buffer->written->load(std::memory_order_acquire);
+                for (u64 i = read; i < written && ok; ++i) {
+                    Event const &event = buffer->events[i & (ThreadBuffer::CAPACITY - 1)];
+                    ok = trace.append(",\n{\"name\":") && trace.appendString(event.name)
+                        && trace.append(",\"ph\":\"X\",\"pid\":1,\"tid\":") && trace.appendNumber(buffer->thread)
+                        && trace.append(",\"ts\":") && trace.appendMicroseconds((u64) ((f64) (event.begin - global.originTicks) * nanosecondsPerTick))
+                        && trace.append(",\"dur\":") && trace.appendMicroseconds((u64) ((f64) (event.end - event.begin) * nanosecondsPerTick))
+                        && trace.append("}");
+                }
+                // only hand the slots back once they made it into the trace
+                if (ok) buffer->read->store(written, std::memory_order_release);
+            }
+            ok = ok && trace.append("\n]}\n");
+            if (!ok) {
+                if (error) *error = files::FILE_OUT_OF_MEMORY;
+                return false;
+            }
+            return files::writeToFile(path, &trace.bytes, trace.bytes.size(), files::FILE_BINARY, error);
+        }
+    }
+}
+
+#if ACHILLES_PROFILING
+    // PROFILE_ZONE("load meshes"); times the rest of the enclosing scope, the end is recorded by a 'defer'
+    #define PROFILE_ZONE(name) ACHILLES_PROFILE_ZONE_AT(name, ANON_VAL)
+    #define ACHILLES_PROFILE_ZONE_AT(name, id) \
+        char const *macro_concat2(PROFILE_NAME_, id) = name; \
+        u64 macro_concat2(PROFILE_BEGIN_, id) = achilles::profile::begin(); \
+        defer { achilles::profile::end(macro_concat2(PROFILE_NAME_, id), macro_concat2(PROFILE_BEGIN_, id)); }
+#else
+    #define PROFILE_ZONE(name) ((void) 0)
+#endif
+
+// a zone named after the enclosing function
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+
+#endif
@@ -0,0 +1,363 @@
+#if !defined(ACHILLES_QUEUE_HPP)
+#define ACHILLES_QUEUE_HPP
+
+// this file depends on <bit> for 'std::bit_ceil' and 'std::bit_floor'
+#include <bit>
+#include <atomic>
+#include <utility>
+#include <new>
+#include <type_traits>
+#include "types.hpp"
+#include "assert.hpp"
+#include "memory.hpp"
+
+namespace achilles {
+    namespace queue {
+        // a bounded lock-free queue between exactly one producer thread and one consumer thread. each side owns a
+        // cache line with its index and a cached copy of the other side's, so the other line is only read when the
+        // queue looks full (or empty). the capacity is rounded up to a power of two
+        template<typename T, typename A = memory::Allocator>
+        struct SpscQueue {
+            SpscQueue(A &allocator, u64 capacity) : _block{nullptr, 0, allocator} {
+                aassert(capacity > 0, "queues need a non-zero capacity");
+                u64 slots = std::bit_ceil(capacity);
+                u8 *memory = allocateStorage(allocator, slots * sizeof(T));
+                if (memory) {
+                    _block = memory::BasicBlock<A> { memory, slots * sizeof(T), allocator };
+                    _mask = slots - 1;
+                }
+            }
+
+            explicit SpscQueue(u64 capacity) requires memory::AllocatorHandle<A>::STATELESS : SpscQueue(A::instance(), capacity) {}
+
+            // uses 'storage' for the slots, as many as fit rounded down to a power of two
+            explicit SpscQueue(memory::BasicBlock<A> &&storage) : _block{std::move(storage)} {
+                u64 slots = _block.size() / sizeof(T);
+                aassert(slots > 0, "queue storage too small for a single element");
+                aassert(((u64) (u8 *) _block & (alignof(T) - 1)) == 0, "queue storage is not aligned for its elements");
+                _mask = std::bit_floor(slots) - 1;
+            }
+
+            SpscQueue(SpscQueue const &other) = delete;
+            SpscQueue &operator =(SpscQueue const &other) = delete;
+
+            ~SpscQueue() {
+                if constexpr (!std::is_trivially_destructible_v<T>) {
+                    u64 tail = _producer->tail.load(std::memory_order_acquire);
+                    for (u64 i = _consumer->head.load(std::memory_order_relaxed); i != tail; ++i) {
+                        slots()[i & _mask].~T();
+                    }
+                }
+            }
+
+            bool isValid() const {
+                return _block.isValid();
+            }
+
+            u64 capacity() const {
+                return isValid() ? _mask + 1 : 0;
+            }
+
+            // a snapshot, exact only when called from one of the two sides while the other is idle
+            u64 size() const {
+                return _producer->tail.load(std::memory_order_acquire) - _consumer->head.load(std::memory_order_acquire);
+            }
+
+            // producer only, false when the queue is full
+            bool push(T const &value) {
+                return emplace(value);
+            }
+
+            bool push(T &&value) {
+                return emplace(std::move(value));
+            }
+
+            template<typename... Args>
+            bool emplace(Args &&...args) {
+                u64 tail = _producer->tail.load(std::memory_order_relaxed);
+                if (tail - _producer->headCache == capacity()) {
+                    _producer->headCache = _consumer->head.load(std::memory_order_acquire);
+                    if (tail - _producer->headCache == capacity()) return false;
+                }
+                new (slots() + (tail & _mask)) T { std::forward<Args>(args)... };
+                _producer->tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            // producer only, pushes as many of 'values' as fit and publishes them at once, returns how many
+            u64 pushMany(memory::Slice<T> const &values) {
+                u64 tail = _producer->tail.load(std::memory_order_relaxed);
+                u64 free = capacity() - (tail - _producer->headCache);
+                if (free < values.size()) {
+                    _producer->headCache = _consumer->head.load(std::memory_order_acquire);
+                    free = capacity() - (tail - _producer->headCache);
+                }
+                u64 count = free < values.size() ? free : values.size();
+                T *source = (T *) values;
+                for (u64 i = 0; i < count; ++i) {
+                    new (slots() + ((tail + i) & _mask)) T(source[i]);
+                }
+                if (count > 0) _producer->tail.store(tail + count, std::memory_order_release);
+                return count;
+            }
+
+            // consumer only, false when the queue is empty
+            bool pop(T &value) {
+                u64 head = _consumer->head.load(std::memory_order_relaxed);
+                if (head == _consumer->tailCache) {
+                    _consumer->tailCache = _producer->tail.load(std::memory_order_acquire);
+                    if (head == _consumer->tailCache) return false;
+                }
+                T *slot = slots() + (head & _mask);
+                value = std::move(*slot);
+                slot->~T();
+                _consumer->head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            // consumer only, moves up to 'values.size()' elements into 'values' and releases their slots at once,
+            // returns how many
+            u64 popMany(memory::Slice<T> values) {
+                u64 head = _consumer->head.load(std::memory_order_relaxed);
+                u64 available = _consumer->tailCache - head;
+                if (available < values.size()) {
+                    _consumer->tailCache = _producer->tail.load(std::memory_order_acquire);
+                    available = _consumer->tailCache - head;
+                }
+                u64 count = available < values.size() ? available : values.size();
+                T *destination = (T *) values;
+                for (u64 i = 0; i < count; ++i) {
+                    T *slot = slots() + ((head + i) & _mask);
+                    destination[i] = std::move(*slot);
+                    slot->~T();
+                }
+                if (count > 0) _consumer->head.store(head + count, std::memory_order_release);
+                return count;
+            }
+        private:
+            struct Producer {
+                std::atomic<u64> tail {0};
+                u64 headCache = 0;
+            };
+
+            struct Consumer {
+                std::atomic<u64> head {0};
+                u64 tailCache = 0;
+            };
+
+            T *slots() const {
+                return (T *) _block;
+            }
+
+            static u8 *allocateStorage(A &allocator, u64 size) {
+                if constexpr (alignof(T) <= memory::DEFAULT_ALIGNMENT) return memory::AllocatorTraits<A>::allocate(allocator, size);
+                else return memory::AllocatorTraits<A>::allocateAligned(allocator, size, alignof(T));
+            }
+
+            memory::CacheAligned<Producer> _producer {};
+            memory::CacheAligned<Consumer> _consumer {};
+            memory::BasicBlock<A> _block;
+            u64 _mask = 0;
+        };
+
+        // a bounded lock-free queue for any number of producers and consumers, Dmitry Vyukov's design: every cell
+        // carries a sequence number that says whether it's ready to be written or read for a given position, so
+        // claiming a position is a single compare-and-swap on one of the two cache-line-padded indices. batches
+        // claim a run of ready cells with one compare-and-swap. a single cell can't tell a written cell from one
+        // ready for the next lap, so there are always at least two
+        template<typename T, typename A = memory::Allocator>
+        struct MpmcQueue {
+            MpmcQueue(A &allocator, u64 capacity) : _block{nullptr, 0, allocator} {
+                aassert(capacity > 0, "queues need a non-zero capacity");
+                u64 cells = std::bit_ceil(capacity < 2 ? (u64) 2 : capacity);
+                u8 *memory = allocateStorage(allocator, cells * sizeof(Cell));
+                if (memory) {
+                    _block = memory::BasicBlock<A> { memory, cells * sizeof(Cell), allocator };
+                    initialize(cells);
+                }
+            }
+
+            explicit MpmcQueue(u64 capacity) requires memory::AllocatorHandle<A>::STATELESS : MpmcQueue(A::instance(), capacity) {}
+
+            // uses 'storage' for the cells, as many as fit rounded down to a power of two, at least two
+            explicit MpmcQueue(memory::BasicBlock<A> &&storage) : _block{std::move(storage)} {
+                u64 cells = _block.size() / sizeof(Cell);
+                aassert(cells >= 2, "queue storage too small for two elements");
+                aassert(((u64) (u8 *) _block & (alignof(Cell) - 1)) == 0, "queue storage is not aligned for its elements");
+                initialize(std::bit_floor(cells));
+            }
+
+            MpmcQueue(MpmcQueue const &other) = delete;
+            MpmcQueue &operator =(MpmcQueue const &other) = delete;
+
+            ~MpmcQueue() {
+                if (!isValid()) return;
+                if constexpr (!std::is_trivially_destructible_v<T>) {
+                    u64 enqueue = _enqueue->load(std::memory_order_acquire);
+                    for (u64 i = _dequeue->load(std::memory_order_acquire); i != enqueue; ++i) {
+                        cells()[i & _mask].value()->~T();
+                    }
+                }
+            }
+
+            bool isValid() const {
+                return _block.isValid();
+            }
+
+            u64 capacity() const {
+                return isValid() ? _mask + 1 : 0;
+            }
+
+            // false when the queue is full
+            bool push(T const &value) {
+                return emplace(value);
+            }
+
+            bool push(T &&value) {
+                return emplace(std::move(value));
+            }
+
+            template<typename... Args>
+            bool emplace(Args &&...args) {
+                if (!isValid()) return false;
+                u64 position = _enqueue->load(std::memory_order_relaxed);
+                Cell *cell = nullptr;
+                for (;;) {
+                    cell = cells() + (position & _mask);
+                    u64 sequence = cell->sequence.load(std::memory_order_acquire);
+                    s64 difference = (s64) (sequence - position);
+                    if (difference == 0) {
+                        if (_enqueue->compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                    } else if (difference < 0) {
+                        return false;
+                    } else {
+                        position = _enqueue->load(std::memory_order_relaxed);
+                    }
+                }
+                new (cell->value()) T { std::forward<Args>(args)... };
+                cell->sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            // pushes as many of 'values' as there are free cells in a row, returns how many
+            u64 pushMany(memory::Slice<T> const &values) {
+                if (!isValid() || values.size() == 0) return 0;
+                u64 position = _enqueue->load(std::memory_order_relaxed);
+                u64 count = 0;
+                for (;;) {
+                    count = readyRun(position, 0, values.size());
+                    if (count == 0) {
+                        u64 sequence = cells()[position & _mask].sequence.load(std::memory_order_acquire);
+                        if ((s64) (sequence - position) < 0) return 0;
+                        position = _enqueue->load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    if (_enqueue->compare_exchange_weak(position, position + count, std::memory_order_relaxed)) break;
+                }
+                T *source = (T *) values;
+                for (u64 i = 0; i < count; ++i) {
+                    Cell *cell = cells() + ((position + i) & _mask);
+                    new (cell->value()) T(source[i]);
+                    cell->sequence.store(position + i + 1, std::memory_order_release);
+                }
+                return count;
+            }
+
+            // false when the queue is empty
+            bool pop(T &value) {
+                if (!isValid()) return false;
+                u64 position = _dequeue->load(std::memory_order_relaxed);
+                Cell *cell = nullptr;
+                for (;;) {
+                    cell = cells() + (position & _mask);
+                    u64 sequence = cell->sequence.load(std::memory_order_acquire);
+                    s64 difference = (s64) (sequence - (position + 1));
+                    if (difference == 0) {
+                        if (_dequeue->compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                    } else if (difference < 0) {
+                        return false;
+                    } else {
+                        position = _dequeue->load(std::memory_order_relaxed);
+                    }
+                }
+                T *slot = cell->value();
+                value = std::move(*slot);
+                slot->~T();
+                cell->sequence.store(position + _mask + 1, std::memory_order_release);
+                return true;
+            }
+
+            // moves as many elements as are ready in a row, up to 'values.size()', into 'values', returns how many
+            u64 popMany(memory::Slice<T> values) {
+                if (!isValid() || values.size() == 0) return 0;
+                u64 position = _dequeue->load(std::memory_order_relaxed);
+                u64 count = 0;
+                for (;;) {
+                    count = readyRun(position, 1, values.size());
+                    if (count == 0) {
+                        u64 sequence = cells()[position & _mask].sequence.load(std::memory_order_acquire);
+                        if ((s64) (sequence - (position + 1)) < 0) return 0;
+                        position = _dequeue->load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    if (_dequeue->compare_exchange_weak(position, position + count, std::memory_order_relaxed)) break;
+                }
+                T *destination = (T *) values;
+                for (u64 i = 0; i < count; ++i) {
+                    Cell *cell = cells() + ((position + i) & _mask);
+                    T *slot = cell->value();
+                    destination[i] = std::move(*slot);
+                    slot->~T();
+                    cell->sequence.store(position + i + _mask + 1, std::memory_order_release);
+                }
+                return count;
+            }
+        private:
+            struct Cell {
+                std::atomic<u64> sequence;
+                alignas(T) u8 storage[sizeof(T)];
+
+                T *value() {
+                    return (T *) storage;
+                }
+            };
+
+            Cell *cells() const {
+                return (Cell *) _block;
+            }
+
+            void initialize(u64 cells) {
+                _mask = cells - 1;
+                for (u64 i = 0; i < cells; ++i) {
+                    new (&this->cells()[i].sequence) std::atomic<u64> { i };
+                }
+            }
+
+            // how many cells from 'position' on, up to 'limit', are ready for the side whose sequence is
+            // 'position + offset', i.e. 0 for producers and 1 for consumers. cells can't stop being ready before
+            // the index moves past them, so a run found here is still ready when the compare-and-swap succeeds
+            u64 readyRun(u64 position, u64 offset, u64 limit) const {
+                u64 count = 0;
+                if (limit > _mask + 1) limit = _mask + 1;
+                while (count < limit) {
+                    u64 sequence = cells()[(position + count) & _mask].sequence.load(std::memory_order_acquire);
+                    if (sequence != position + count + offset) break;
+                    count += 1;
+                }
+                return count;
+            }
+
+            static u8 *allocateStorage(A &allocator, u64 size) {
+                if constexpr (alignof(Cell) <= memory::DEFAULT_ALIGNMENT) return memory::AllocatorTraits<A>::allocate(allocator, size);
+                else return memory::AllocatorTraits<A>::allocateAligned(allocator, size, alignof(Cell));
+            }
+
+            memory::CacheAligned<std::atomic<u64>> _enqueue {};
+            memory::CacheAligned<std::atomic<u64>> _dequeue {};
+            memory::BasicBlock<A> _block;
+            u64 _mask = 0;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,206 @@
+#if !defined(ACHILLES_SERIALIZE_HPP)
+#define ACHILLES_SERIALIZE_HPP
+
+#include <cstring>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "types.hpp"
+#include "assert.hpp"
+#include "memory.hpp"
+
+namespace achilles {
+    namespace serialize {
+        using memory::Allocator;
+        using memory::Block;
+        using memory::Slice;
+        using memory::OffsetPointer;
+        using memory::OffsetSlice;
+        using memory::SafeOffsetPointer;
+        using memory::RelativeSlice;
+
+        static constexpr u32 MAGIC = 0x52484341; // "ACHR"
+        static constexpr u32 VERSION = 1;
+
+        // every object in a blob is aligned to at most this, which the blob itself is aligned to, mappings are
+        // page aligned and the allocators here give 'DEFAULT_ALIGNMENT'
+        static constexpr u64 MAX_ALIGNMENT = memory::DEFAULT_ALIGNMENT;
+
+        // the start of every blob. 'type' is 'types::typehash' of the root, which is only the same between builds
+        // made with the same compiler
+        struct Header {
+            u32 magic;
+            u32 version;
+            u64 size;
+            u64 root;
+            u64 type;
+        };
+
+        // where an object was written, as a byte offset into the blob. unlike a pointer it stays good while the
+        // blob grows
+        template<typename T>
+        struct Ref {
+            u64 offset = 0;
+
+            bool isValid() const {
+                return offset != 0;
+            }
+        };
+
+        // builds a relocatable blob: structs, arrays and strings appended to one block and linked to each other
+        // through 'OffsetPointer' and 'OffsetSlice' fields. the result can be written to a file as is and used
+        // straight from a mapping, see 'load'. the types written must not hold anything but plain values and
+        // offset pointers into the same blob.
+        //
+        //     Writer writer;
+        //     Ref<Mesh> mesh = writer.allocate<Mesh>();
+        //     Ref<char> name = writer.writeString("cube");
+        //     writer.link(writer.field(mesh, &Mesh::name), name, 4);
+        //     Block blob = writer.finish(mesh);
+        struct Writer {
+            explicit Writer(Allocator &allocator = memory::GlobalAllocator::instance(), u64 capacity = KB(4))
+                : _bytes{allocator, capacity > sizeof(Header) ? capacity : sizeof(Header)} {
+                _bytes.resize(sizeof(Header));
+            }
+
+            // 'count' value-initialized objects, null when out of memory
+            template<typename T>
+            Ref<T> allocate(u64 count = 1) {
+                static_assert(alignof(T) <= MAX_ALIGNMENT, "over-aligned types can't be serialized");
+                u64 offset = memory::alignUp(_bytes.size(), alignof(T));
+                if (!_bytes.resize(offset + count * sizeof(T))) {
+                    _failed = true;
+                    return Ref<T> {};
+                }
+                T *memory = (T *) (((u8 *) &_bytes) + offset);
+                for (u64 i = 0; i < count; ++i) {
+                    new (memory + i) T {};
+                }
+                return Ref<T> { offset };
+            }
+
+            template<typename T>
+            Ref<T> write(T const &value) {
+                return write(Slice<T const> { &value, 1 });
+            }
+
+            // copies plain values, things with offset pointers have to be allocated and linked in place
+            template<typename T>
+            Ref<T> write(Slice<T const> values) {
+                static_assert(std::is_trivially_copyable_v<T>, "only plain values can be copied into a blob");
+                Ref<T> result = allocate<T>(values.size());
+                if (result.isValid() && values.size() > 0) memcpy(at(result), (T const *) values, values.size() * sizeof(T));
+                return result;
+            }
+
+            // the characters and a terminating zero, so the string can also be used as a C string
+            Ref<char> writeString(Slice<char const> string) {
+                Ref<char> result = allocate<char>(string.size() + 1);
+                if (result.isValid() && string.size() > 0) memcpy(at(result), (char const *) string, string.size());
+                return result;
+            }
+
+            // the current address of an object, only good until the next allocation
+            template<typename T>
+            T *at(Ref<T> ref) {
+                aassert(ref.isValid() && ref.offset + sizeof(T) <= _bytes.size(), "invalid blob reference");
+                return (T *) (((u8 *) &_bytes) + ref.offset);
+            }
+
+            // the i-th of 'count' objects allocated together
+            template<typename T>
+            Ref<T> element(Ref<T> first, u64 index) {
+                return Ref<T> { first.offset + index * sizeof(T) };
+            }
+
+            template<typename T, typename M>
+            Ref<M> field(Ref<T> object, M T::*member) {
+                T *value = at(object);
+                u64 offset = (u64) ((u8 *) &(value->*member) - (u8 *) value);
+                return Ref<M> { object.offset + offset };
+            }
+
+            template<typename T>
+            void link(Ref<OffsetPointer<T>> pointer, Ref<T> target) {
+                if (!target.isValid()) {
+                    at(pointer)->set(nullptr);
+                    return;
+                }
+                at(pointer)->set(at(target));
+            }
+
+            template<typename T>
+            void link(Ref<OffsetSlice<T>> slice, Ref<T> first, u64 count) {
+                if (!first.isValid() || count == 0) {
+                    at(slice)->set(nullptr, 0);
+                    return;
+                }
+                at(slice)->set(at(first), count);
+            }
+
+            u64 size() const {
+                return _bytes.size();
+            }
+
+            // fills in the header and hands over the blob, invalid when anything ran out of memory. the writer
+            // can't be used afterwards
+            template<typename T>
+            Block finish(Ref<T> root) {
+                if (_failed || !_bytes.isValid() || !root.isValid()) return Block {};
+                Header *header = (Header *) (u8 *) &_bytes;
+                header->magic = MAGIC;
+                header->version = VERSION;
+                header->size = _bytes.size();
+                header->root = root.offset;
+                header->type = types::typehash<T>;
+                _bytes.shrinkToFit();
+                return std::move(&_bytes);
+            }
+        private:
+            memory::Array<u8> _bytes;
+            bool _failed = false;
+        };
+
+        // checks the header of a blob and returns its root, null when the bytes aren't a blob with a 'T' root.
+        // nothing is copied or fixed up, the root and everything it points to live in 'bytes'
+        template<typename T>
+        T const *load(Slice<u8 const> bytes) {
+            u8 const *memory = (u8 const *) bytes;
+            if (memory == nullptr || bytes.size() < sizeof(Header)) return nullptr;
+            if (((u64) memory & (MAX_ALIGNMENT - 1)) != 0) return nullptr;
+            Header const *header = (Header const *) memory;
+            if (header->magic != MAGIC || header->version != VERSION) return nullptr;
+            if (header->type != types::typehash<T>) return nullptr;
+            if (header->size > bytes.size()) return nullptr;
+            if (header->root < sizeof(Header) || header->root > header->size) return nullptr;
+            if (header->size - header->root < sizeof(T)) return nullptr;
+            if (header->root % alignof(T) != 0) return nullptr;
+            return (T const *) (memory + header->root);
+        }
+
+        template<typename T>
+        T const *load(Block const &block) {
+            return load<T>(Slice<u8 const> { (u8 const *) block, block.size() });
+        }
+
+        // like 'load', but the root comes as a pointer that checks everything reached from it stays inside the
+        // blob, for files that can't be trusted. see 'ACHILLES_BOUNDS_CHECKS'
+        //
+        //     SafeOffsetPointer<Scene const> scene = view<Scene>(bytes(mapped));
+        //     RelativeSlice<Mesh const> meshes = scene.follow(&Scene::meshes); // empty if it leaves the blob
+        template<typename T>
+        SafeOffsetPointer<T const> view(Slice<u8 const> bytes) {
+            T const *root = load<T>(bytes);
+            if (root == nullptr) return SafeOffsetPointer<T const> {};
+            Header const *header = (Header const *) (u8 const *) bytes;
+            return SafeOffsetPointer<T const> { root, Slice<u8 const> { (u8 const *) bytes, header->size } };
+        }
+
+        template<typename T>
+        SafeOffsetPointer<T const> view(Block const &block) {
+            return view<T>(Slice<u8 const> { (u8 const *) block, block.size() });
+        }
+    }
+}
+
+#endif
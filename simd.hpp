@@ -0,0 +1,368 @@
+#if !defined(ACHILLES_SIMD_HPP)
+#define ACHILLES_SIMD_HPP
+
+// this file depends on <bit> for 'std::countr_zero'
+#include <bit>
+#include <cstring>
+#include <type_traits>
+#include "types.hpp"
+
+// instruction sets are picked up from the compiler flags (e.g. '-mavx2', '/arch:AVX2'), define 'ACHILLES_NO_SIMD'
+// to force the scalar paths everywhere
+#if !defined(ACHILLES_NO_SIMD)
+    #if defined(__AVX2__)
+        #define ACHILLES_AVX2 1
+        #include <immintrin.h>
+    #endif
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define ACHILLES_SSE2 1
+        #include <emmintrin.h>
+    #endif
+    #if defined(__aarch64__) || defined(_M_ARM64)
+        #define ACHILLES_NEON 1
+        #include <arm_neon.h>
+    #endif
+#endif
+
+namespace achilles {
+    namespace simd {
+        // element types the kernels below vectorise, anything else takes the scalar loop
+        template<typename T>
+        constexpr bool vectorizable =
+            std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+            (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+        // every backend compares a register of 'BYTES' bytes and returns a mask with 'BITS_PER_BYTE' bits per
+        // byte, all of a lane's bits being set when the lane matched
+        #if defined(ACHILLES_AVX2)
+            struct Native {
+                using Vector = __m256i;
+                static constexpr u64 BYTES = 32;
+                static constexpr u64 BITS_PER_BYTE = 1;
+
+                static Vector load(void const *memory) {
+                    return _mm256_loadu_si256((__m256i const *) memory);
+                }
+
+                static void store(void *memory, Vector v) {
+                    _mm256_storeu_si256((__m256i *) memory, v);
+                }
+
+                template<typename Bits>
+                static Vector broadcast(Bits bits) {
+                    if constexpr (sizeof(Bits) == 1) return _mm256_set1_epi8((char) bits);
+                    else if constexpr (sizeof(Bits) == 2) return _mm256_set1_epi16((short) bits);
+                    else if constexpr (sizeof(Bits) == 4) return _mm256_set1_epi32((int) bits);
+                    else return _mm256_set1_epi64x((long long) bits);
+                }
+
+                // all of a lane's bits set where 'a' and 'b' are equal
+                template<typename T>
+                static Vector equal(Vector a, Vector b) {
+                    if constexpr (std::is_same_v<T, f32>) {
+                        return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+                    } else if constexpr (std::is_same_v<T, f64>) {
+                        return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+                    } else if constexpr (sizeof(T) == 1) {
+                        return _mm256_cmpeq_epi8(a, b);
+                    } else if constexpr (sizeof(T) == 2) {
+                        return _mm256_cmpeq_epi16(a, b);
+                    } else if constexpr (sizeof(T) == 4) {
+                        return _mm256_cmpeq_epi32(a, b);
+                    } else {
+                        return _mm256_cmpeq_epi64(a, b);
+                    }
+                }
+
+                static u64 mask(Vector eq) {
+                    return (u32) _mm256_movemask_epi8(eq);
+                }
+
+                template<typename T>
+                static u64 equalMask(Vector a, Vector b) {
+                    return mask(equal<T>(a, b));
+                }
+
+                static Vector zero() {
+                    return _mm256_setzero_si256();
+                }
+
+                template<typename T>
+                static Vector subtract(Vector a, Vector b) {
+                    if constexpr (sizeof(T) == 1) return _mm256_sub_epi8(a, b);
+                    else if constexpr (sizeof(T) == 2) return _mm256_sub_epi16(a, b);
+                    else if constexpr (sizeof(T) == 4) return _mm256_sub_epi32(a, b);
+                    else return _mm256_sub_epi64(a, b);
+                }
+            };
+        #elif defined(ACHILLES_SSE2)
+            struct Native {
+                using Vector = __m128i;
+                static constexpr u64 BYTES = 16;
+                static constexpr u64 BITS_PER_BYTE = 1;
+
+                static Vector load(void const *memory) {
+                    return _mm_loadu_si128((__m128i const *) memory);
+                }
+
+                static void store(void *memory, Vector v) {
+                    _mm_storeu_si128((__m128i *) memory, v);
+                }
+
+                template<typename Bits>
+                static Vector broadcast(Bits bits) {
+                    if constexpr (sizeof(Bits) == 1) return _mm_set1_epi8((char) bits);
+                    else if constexpr (sizeof(Bits) == 2) return _mm_set1_epi16((short) bits);
+                    else if constexpr (sizeof(Bits) == 4) return _mm_set1_epi32((int) bits);
+                    else return _mm_set1_epi64x((long long) bits);
+                }
+
+                // all of a lane's bits set where 'a' and 'b' are equal
+                template<typename T>
+                static Vector equal(Vector a, Vector b) {
+                    if constexpr (std::is_same_v<T, f32>) {
+                        return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+                    } else if constexpr (std::is_same_v<T, f64>) {
+                        return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+                    } else if constexpr (sizeof(T) == 1) {
+                        return _mm_cmpeq_epi8(a, b);
+                    } else if constexpr (sizeof(T) == 2) {
+                        return _mm_cmpeq_epi16(a, b);
+                    } else if constexpr (sizeof(T) == 4) {
+                        return _mm_cmpeq_epi32(a, b);
+                    } else {
+                        // no 64-bit compare before SSE4.1, a lane matches when both of its halves do
+                        Vector halves = _mm_cmpeq_epi32(a, b);
+                        return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+                    }
+                }
+
+                static u64 mask(Vector eq) {
+                    return (u32) _mm_movemask_epi8(eq);
+                }
+
+                template<typename T>
+                static u64 equalMask(Vector a, Vector b) {
+                    return mask(equal<T>(a, b));
+                }
+
+                static Vector zero() {
+                    return _mm_setzero_si128();
+                }
+
+                template<typename T>
+                static Vector subtract(Vector a, Vector b) {
+                    if constexpr (sizeof(T) == 1) return _mm_sub_epi8(a, b);
+                    else if constexpr (sizeof(T) == 2) return _mm_sub_epi16(a, b);
+                    else if constexpr (sizeof(T) == 4) return _mm_sub_epi32(a, b);
+                    else return _mm_sub_epi64(a, b);
+                }
+            };
+        #elif defined(ACHILLES_NEON)
+            struct Native {
+                using Vector = uint8x16_t;
+                static constexpr u64 BYTES = 16;
+                static constexpr u64 BITS_PER_BYTE = 4;
+
+                static Vector load(void const *memory) {
+                    return vld1q_u8((u8 const *) memory);
+                }
+
+                static void store(void *memory, Vector v) {
+                    vst1q_u8((u8 *) memory, v);
+                }
+
+                template<typename Bits>
+                static Vector broadcast(Bits bits) {
+                    if constexpr (sizeof(Bits) == 1) return vdupq_n_u8(bits);
+                    else if constexpr (sizeof(Bits) == 2) return vreinterpretq_u8_u16(vdupq_n_u16(bits));
+                    else if constexpr (sizeof(Bits) == 4) return vreinterpretq_u8_u32(vdupq_n_u32(bits));
+                    else return vreinterpretq_u8_u64(vdupq_n_u64(bits));
+                }
+
+                // all of a lane's bits set where 'a' and 'b' are equal
+                template<typename T>
+                static Vector equal(Vector a, Vector b) {
+                    if constexpr (std::is_same_v<T, f32>) {
+                        return vreinterpretq_u8_u32(vceqq_f32(vreinterpretq_f32_u8(a), vreinterpretq_f32_u8(b)));
+                    } else if constexpr (std::is_same_v<T, f64>) {
+                        return vreinterpretq_u8_u64(vceqq_f64(vreinterpretq_f64_u8(a), vreinterpretq_f64_u8(b)));
+                    } else if constexpr (sizeof(T) == 1) {
+                        return vceqq_u8(a, b);
+                    } else if constexpr (sizeof(T) == 2) {
+                        return vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+                    } else if constexpr (sizeof(T) == 4) {
+                        return vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+                    } else {
+                        return vreinterpretq_u8_u64(vceqq_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+                    }
+                }
+
+                static u64 mask(Vector eq) {
+                    // no movemask on NEON, narrowing every byte to a nibble packs the mask into 64 bits
+                    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+                    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+                }
+
+                template<typename T>
+                static u64 equalMask(Vector a, Vector b) {
+                    return mask(equal<T>(a, b));
+                }
+
+                static Vector zero() {
+                    return vdupq_n_u8(0);
+                }
+
+                template<typename T>
+                static Vector subtract(Vector a, Vector b) {
+                    if constexpr (sizeof(T) == 1) return vsubq_u8(a, b);
+                    else if constexpr (sizeof(T) == 2) return vreinterpretq_u8_u16(vsubq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+                    else if constexpr (sizeof(T) == 4) return vreinterpretq_u8_u32(vsubq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+                    else return vreinterpretq_u8_u64(vsubq_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+                }
+            };
+        #endif
+
+        #if defined(ACHILLES_AVX2) || defined(ACHILLES_SSE2) || defined(ACHILLES_NEON)
+            #define ACHILLES_SIMD 1
+
+            template<typename T>
+            constexpr u64 LANES = Native::BYTES / sizeof(T);
+
+            // mask bits per lane
+            template<typename T>
+            constexpr u64 LANE_BITS = sizeof(T) * Native::BITS_PER_BYTE;
+
+            constexpr u64 FULL_MASK = Native::BYTES * Native::BITS_PER_BYTE == 64 ? U64_MAX : (1ULL << (Native::BYTES * Native::BITS_PER_BYTE)) - 1;
+
+            // 'value' in every lane, going through its bits so floats take the integer broadcasts
+            template<typename T>
+            inline Native::Vector broadcast(T value) {
+                using Bits = std::conditional_t<sizeof(T) == 1, u8, std::conditional_t<sizeof(T) == 2, u16,
+                             std::conditional_t<sizeof(T) == 4, u32, u64>>>;
+                Bits bits;
+                memcpy(&bits, &value, sizeof(T));
+                return Native::broadcast(bits);
+            }
+        #else
+            #define ACHILLES_SIMD 0
+        #endif
+
+        // the index of the first element equal to 'value', 'U64_MAX' if there is none
+        template<typename T>
+        inline u64 find(T const *values, u64 count, T const &value) {
+            u64 i = 0;
+            #if ACHILLES_SIMD
+                if constexpr (vectorizable<T>) {
+                    auto needle = broadcast(value);
+                    for (; i + LANES<T> <= count; i += LANES<T>) {
+                        u64 mask = Native::equalMask<T>(Native::load(values + i), needle);
+                        if (mask) return i + std::countr_zero(mask) / LANE_BITS<T>;
+                    }
+                }
+            #endif
+            for (; i < count; ++i) {
+                if (values[i] == value) return i;
+            }
+            return U64_MAX;
+        }
+
+        // a matching lane is all ones, minus one, so subtracting the compares counts the matches per lane and
+        // the lanes are only added up once a run of registers is done. byte lanes would wrap past 255 of them,
+        // so the runs are kept below that
+        template<typename T>
+        inline u64 count(T const *values, u64 count, T const &value) {
+            u64 result = 0;
+            u64 i = 0;
+            #if ACHILLES_SIMD
+                if constexpr (vectorizable<T>) {
+                    using Lane = std::conditional_t<sizeof(T) == 1, u8, std::conditional_t<sizeof(T) == 2, u16,
+                                 std::conditional_t<sizeof(T) == 4, u32, u64>>>;
+                    constexpr u64 run = sizeof(T) == 1 ? 255 : 65535;
+                    auto needle = broadcast(value);
+                    while (i + LANES<T> <= count) {
+                        Native::Vector counts = Native::zero();
+                        u64 end = i + run * LANES<T> < count ? i + run * LANES<T> : count;
+                        for (; i + LANES<T> <= end; i += LANES<T>) {
+                            counts = Native::subtract<T>(counts, Native::equal<T>(Native::load(values + i), needle));
+                        }
+                        Lane lanes[LANES<T>];
+                        Native::store(lanes, counts);
+                        for (u64 lane = 0; lane < LANES<T>; ++lane) result += lanes[lane];
+                    }
+                }
+            #endif
+            for (; i < count; ++i) {
+                if (values[i] == value) result += 1;
+            }
+            return result;
+        }
+
+        // calls 'onMatch' with the index of every element equal to 'value', in order
+        template<typename T, typename F>
+        inline void findAll(T const *values, u64 count, T const &value, F &&onMatch) {
+            u64 i = 0;
+            #if ACHILLES_SIMD
+                if constexpr (vectorizable<T>) {
+                    constexpr u64 laneMask = LANE_BITS<T> == 64 ? U64_MAX : (1ULL << LANE_BITS<T>) - 1;
+                    auto needle = broadcast(value);
+                    for (; i + LANES<T> <= count; i += LANES<T>) {
+                        u64 mask = Native::equalMask<T>(Native::load(values + i), needle);
+                        while (mask) {
+                            u64 bit = std::countr_zero(mask);
+                            onMatch(i + bit / LANE_BITS<T>);
+                            mask &= ~(laneMask << bit);
+                        }
+                    }
+                }
+            #endif
+            for (; i < count; ++i) {
+                if (values[i] == value) onMatch(i);
+            }
+        }
+
+        // element-wise '==', so for floats NaNs never match and -0 matches +0
+        template<typename T>
+        inline bool equal(T const *a, T const *b, u64 count) {
+            if constexpr (std::is_integral_v<T>) {
+                // integers are equal exactly when their bytes are
+                return count == 0 || memcmp(a, b, count * sizeof(T)) == 0;
+            } else {
+                u64 i = 0;
+                #if ACHILLES_SIMD
+                    if constexpr (vectorizable<T>) {
+                        for (; i + LANES<T> <= count; i += LANES<T>) {
+                            if (Native::equalMask<T>(Native::load(a + i), Native::load(b + i)) != FULL_MASK) return false;
+                        }
+                    }
+                #endif
+                for (; i < count; ++i) {
+                    if (!(a[i] == b[i])) return false;
+                }
+                return true;
+            }
+        }
+
+        template<typename T>
+        inline void fill(T *values, u64 count, T const &value) {
+            u64 i = 0;
+            #if ACHILLES_SIMD
+                if constexpr (vectorizable<T>) {
+                    if constexpr (sizeof(T) == 1) {
+                        memset(values, *(u8 const *) &value, count);
+                        return;
+                    }
+                    auto pattern = broadcast(value);
+                    for (; i + LANES<T> <= count; i += LANES<T>) {
+                        Native::store(values + i, pattern);
+                    }
+                }
+            #endif
+            for (; i < count; ++i) {
+                values[i] = value;
+            }
+        }
+    }
+}
+
+#endif
@@ -1,7 +1,11 @@
 #if !defined(ACHILLES_TYPES_HPP)
 #define ACHILLES_TYPES_HPP
 
+#include <cstddef>
+#include <cstring>
+#include <new>
 #include <type_traits>
+#include <utility>
 #include "misc.hpp"
 
 using u64 = unsigned long long;
@@ -87,6 +91,8 @@ namespace achilles {
         template<typename T>
         static constexpr auto type_name = typeName<remove_all_t<T>>();
 
+        // a type-erased view of an argument, it only points to the value it was made from, so it mustn't outlive
+        // it, which for a temporary is the end of the full expression. 'memory::AnyValue' holds its own copy
         struct Any {
             Any() : _ptr{nullptr} {}
 
@@ -114,8 +120,141 @@ namespace achilles {
             void *_ptr;
         };
 
+        template<typename Signature>
+        struct FunctionRef;
+
+        // a non-owning reference to something callable, two pointers copied by value and never an allocation. like
+        // 'Any' it doesn't keep the callable alive, so it is for parameters that are called before the function
+        // returns, not for storing callbacks
+        //
+        //     void forEachChild(Node &node, FunctionRef<void(Node &)> visit);
+        //     forEachChild(root, [&](Node &child) { ++count; });
+        template<typename R, typename... Args>
+        struct FunctionRef<R(Args...)> {
+            FunctionRef() = default;
+
+            template<typename F> requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && std::is_invocable_r_v<R, F &, Args...>)
+            FunctionRef(F &&function) {
+                using Function = std::remove_reference_t<F>;
+                if constexpr (std::is_function_v<Function>) {
+                    // function pointers can't be stored as a 'void *' everywhere
+                    _target.function = (void (*)()) &function;
+                    _call = [](Target target, Args... args) -> R {
+                        return ((Function *) target.function)(std::forward<Args>(args)...);
+                    };
+                } else {
+                    _target.object = (void *) &function;
+                    _call = [](Target target, Args... args) -> R {
+                        return (*(Function *) target.object)(std::forward<Args>(args)...);
+                    };
+                }
+            }
+
+            R operator()(Args... args) const {
+                return _call(_target, std::forward<Args>(args)...);
+            }
+
+            explicit operator bool() const {
+                return _call != nullptr;
+            }
+        private:
+            union Target {
+                void *object;
+                void (*function)();
+            };
+
+            Target _target {nullptr};
+            R (*_call)(Target target, Args... args) = nullptr;
+        };
+
+        template<typename Signature, u64 Size = 32>
+        struct InplaceFunction;
+
+        // an owning callable stored in 'Size' bytes inside the object, one that doesn't fit is a compile error
+        // rather than an allocation. it can be moved but not copied, so callables that own things work too.
+        // trivially copyable callables (most lambdas that capture pointers or references) are moved with a copy
+        // of the bytes and need no destructor
+        //
+        //     InplaceFunction<void(u32)> onResize = [this](u32 width) { resize(width); };
+        template<typename R, typename... Args, u64 Size>
+        struct InplaceFunction<R(Args...), Size> {
+            static constexpr u64 ALIGNMENT = alignof(std::max_align_t);
+
+            InplaceFunction() = default;
+
+            template<typename F> requires (!std::is_same_v<std::remove_cvref_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F> &, Args...>)
+            InplaceFunction(F &&function) {
+                using Function = std::decay_t<F>;
+                static_assert(sizeof(Function) <= Size, "callable too large for the inplace function, capture by reference or raise 'Size'");
+                static_assert(alignof(Function) <= ALIGNMENT, "callable over-aligned for the inplace function");
+                static_assert(std::is_nothrow_move_constructible_v<Function>, "inplace functions need callables that move without throwing");
+
+                new (_storage) Function(std::forward<F>(function));
+                _call = [](void *storage, Args... args) -> R {
+                    return (*(Function *) storage)(std::forward<Args>(args)...);
+                };
+                if constexpr (!std::is_trivially_copyable_v<Function>) {
+                    _manage = [](void *storage, void *destination) {
+                        Function *self = (Function *) storage;
+                        if (destination) new (destination) Function(std::move(*self));
+                        self->~Function();
+                    };
+                }
+            }
+
+            InplaceFunction(InplaceFunction const &other) = delete;
+            InplaceFunction &operator =(InplaceFunction const &other) = delete;
+
+            InplaceFunction(InplaceFunction &&other) {
+                take(other);
+            }
+
+            InplaceFunction &operator =(InplaceFunction &&other) {
+                if (this != &other) {
+                    reset();
+                    take(other);
+                }
+                return *this;
+            }
+
+            ~InplaceFunction() {
+                reset();
+            }
+
+            R operator()(Args... args) const {
+                return _call((void *) _storage, std::forward<Args>(args)...);
+            }
+
+            explicit operator bool() const {
+                return _call != nullptr;
+            }
+
+            void reset() {
+                if (_manage) _manage(_storage, nullptr);
+                _call = nullptr;
+                _manage = nullptr;
+            }
+        private:
+            void take(InplaceFunction &other) {
+                if (other._manage) other._manage(other._storage, _storage);
+                else if (other._call) memcpy(_storage, other._storage, Size);
+                _call = other._call;
+                _manage = other._manage;
+                other._call = nullptr;
+                other._manage = nullptr;
+            }
+
+            alignas(ALIGNMENT) u8 _storage[Size];
+            R (*_call)(void *storage, Args... args) = nullptr;
+            // moves the callable into 'destination' (when given) and destroys it, null when that is a plain copy
+            void (*_manage)(void *storage, void *destination) = nullptr;
+        };
+
         template<typename Tag, typename T, T defaultValue>
         struct TypeSafeHandle {
+          using Value = T;
+          static constexpr T DEFAULT = defaultValue;
+
           static TypeSafeHandle invalid() { return TypeSafeHandle(); }
 
           TypeSafeHandle() : value{defaultValue} {}